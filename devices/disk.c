@@ -1,15 +1,35 @@
 #include "devices/disk.h"
 #include <ctype.h>
 #include <debug.h>
+#include <round.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include "devices/pci.h"
 #include "devices/timer.h"
+#include "devices/virtio-blk.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 /* The code in this file is an interface to an ATA (IDE)
-   controller.  It attempts to comply to [ATA-3]. */
+   controller.  It attempts to comply to [ATA-3].
+
+   Disk access is asynchronous.  Requests are queued on their
+   channel with disk_submit(), and each channel has a dispatcher
+   thread that carries them out one command at a time, so that both
+   channels work at once and the order of a channel's requests is
+   up to its elevator.  disk_read(), disk_write() and their
+   _multiple() versions submit requests and wait for them.
+
+   Virtio block devices (see virtio-blk.c) are served the same way,
+   each through a channel of its own, and take the places of the
+   ATA disks that are not there. */
 
 /* ATA command block port addresses. */
 #define reg_data(CHANNEL) ((CHANNEL)->reg_base + 0)     /* Data. */
@@ -32,6 +52,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +68,48 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+#define CMD_READ_DMA 0xc8               /* READ DMA. */
+#define CMD_WRITE_DMA 0xca              /* WRITE DMA. */
+
+/* Most sectors one command can transfer: a sector count register
+   value of 0 stands for 256. */
+#define MAX_NSECT 256
+
+/* Most requests merged into one command. */
+#define MAX_MERGE 32
+
+/* Ticks a read or a write may wait in its channel's queue before
+   the elevator serves it ahead of its turn. */
+#define READ_DEADLINE (TIMER_FREQ / 10)
+#define WRITE_DEADLINE (TIMER_FREQ / 2)
+
+/* Bus master IDE registers of a channel, found through the PCI IDE
+   controller [PIIX]. */
+#define reg_bmcmd(CHANNEL) ((CHANNEL)->bm_base + 0)    /* Command. */
+#define reg_bmstat(CHANNEL) ((CHANNEL)->bm_base + 2)   /* Status. */
+#define reg_bmprdt(CHANNEL) ((CHANNEL)->bm_base + 4)   /* PRD table address. */
+
+/* Bus master command register bits. */
+#define BMCMD_START 0x01        /* Start transfer. */
+#define BMCMD_READ 0x08         /* Transfer from disk to memory. */
+
+/* Bus master status register bits. */
+#define BMSTAT_ACTIVE 0x01      /* Transfer in progress. */
+#define BMSTAT_ERR 0x02         /* Transfer failed (write 1 to clear). */
+#define BMSTAT_INTR 0x04        /* Disk interrupted (write 1 to clear). */
+
+/* A Physical Region Descriptor: one physically contiguous piece of
+   a DMA buffer.  A region may not cross a 64 kB boundary. */
+struct prd {
+	uint32_t addr;              /* Physical address. */
+	uint16_t size;              /* Size in bytes, 0 for 64 kB. */
+	uint16_t flags;             /* PRD_EOT in the last descriptor. */
+};
+#define PRD_EOT 0x8000          /* End of table. */
+#define PRD_CNT (PGSIZE / sizeof (struct prd))
 
 /* An ATA device. */
 struct disk {
@@ -55,23 +118,49 @@ struct disk {
 	int dev_no;                 /* Device 0 or 1 for master or slave. */
 
 	bool is_ata;                /* 1=This device is an ATA disk. */
-	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
-
-	long long read_cnt;         /* Number of sectors read. */
-	long long write_cnt;        /* Number of sectors written. */
+	disk_sector_t capacity;     /* Capacity in sectors. */
+	int multiple;               /* Sectors per interrupt with READ/WRITE
+	                               MULTIPLE, 0 if not supported. */
+	bool dma;                   /* Supports DMA transfers. */
+
+	disk_sector_t head;         /* Sector after the last one accessed. */
+	bool descending;            /* Elevator sweeps toward sector 0. */
+
+	struct disk_stats stats;    /* Statistics. */
+	int64_t queued_cnt;         /* Requests queued, ever. */
+	int64_t completed_cnt;      /* Requests completed, ever.  Updated by
+	                               the dispatcher thread only. */
+	int64_t read_usecs;         /* Time the device spent reading. */
+	int64_t write_usecs;        /* Time the device spent writing. */
 };
 
 /* An ATA channel (aka controller).
-   Each channel can control up to two disks. */
+   Each channel can control up to two disks.  A virtio block device
+   has a channel of its own, with only the members up to QUEUE and
+   device 0 in use. */
 struct channel {
 	char name[8];               /* Name, e.g. "hd0". */
 	uint16_t reg_base;          /* Base I/O port. */
 	uint8_t irq;                /* Interrupt in use. */
 
-	struct lock lock;           /* Must acquire to access the controller. */
+	struct lock lock;           /* Protects QUEUE. */
+	struct list queue;          /* Pending struct disk_requests.  Only
+	                               the dispatcher thread drives the
+	                               controller once the channel is set
+	                               up. */
+	struct semaphore wakeup;    /* Up'd once per request queued, and per
+	                               virtio completion interrupt. */
+	struct virtio_blk *virtio;  /* Virtio device, or NULL for ATA. */
+
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	int64_t intr_usecs;         /* timer_usecs() at the last interrupt. */
+
+	uint16_t bm_base;           /* Bus master registers, 0 if no DMA. */
+	struct prd *prdt;           /* Physical Region Descriptor table. */
+	bool dma_active;            /* True while a DMA transfer runs. */
+	uint8_t dma_status;         /* Bus master status at completion. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -80,14 +169,48 @@ struct channel {
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
 
+/* Channels of virtio block devices. */
+static struct channel virtio_channels[VIRTIO_BLK_CNT];
+
+/* The disk in each place disk_get() knows, or NULL. */
+static struct disk *disks[CHANNEL_CNT][2];
+
+/* True to move disk data by programmed I/O only, even where DMA is
+   available (kernel option -pio). */
+bool disk_pio;
+
+/* True to serve disk requests in the order they are submitted, with
+   neither elevator nor merging (kernel option -fifo). */
+bool disk_fifo;
+
 static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
-
-static void select_sector (struct disk *, disk_sector_t);
+static void set_multiple_mode (struct disk *, int);
+
+static void transfer (struct disk *, disk_sector_t, uint8_t *, size_t cnt,
+		bool write);
+static void init_channel (struct channel *);
+static void init_disk (struct disk *, struct channel *, int dev_no,
+		const char *name);
+static void attach_virtio (void);
+static void print_capacity (const struct disk *);
+
+static void acquire_channel (struct disk *);
+static void enqueue (struct disk_request *);
+static void dispatcher (void *);
+static void virtio_dispatcher (void *);
+static size_t account (struct disk_request **, size_t n);
+static void complete (struct disk_request *);
+static void execute (struct disk_request **, size_t n);
+static void pio_transfer (struct disk_request **, size_t n, size_t cnt);
+static uint16_t find_bus_master (void);
+static bool dma_transfer (struct disk_request **, size_t n, size_t cnt);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
-static void input_sector (struct channel *, void *);
-static void output_sector (struct channel *, const void *);
+static void wait_interrupt (struct disk *);
+static void input_sectors (struct channel *, void *, size_t cnt);
+static void output_sectors (struct channel *, const void *, size_t cnt);
 
 static void wait_until_idle (const struct disk *);
 static bool wait_while_busy (const struct disk *);
@@ -99,6 +222,7 @@ static void interrupt_handler (struct intr_frame *);
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
+	uint16_t bm_base = disk_pio ? 0 : find_bus_master ();
 	size_t chan_no;
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
@@ -119,21 +243,25 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
+		init_channel (c);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
 
+		/* Each channel has 8 bytes of bus master registers. */
+		c->bm_base = 0;
+		c->prdt = NULL;
+		c->dma_active = false;
+		if (bm_base != 0) {
+			c->prdt = palloc_get_page (0);
+			if (c->prdt != NULL)
+				c->bm_base = bm_base + 8 * chan_no;
+		}
+
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
-			struct disk *d = &c->devices[dev_no];
-			snprintf (d->name, sizeof d->name, "%s:%d", c->name, dev_no);
-			d->channel = c;
-			d->dev_no = dev_no;
-
-			d->is_ata = false;
-			d->capacity = 0;
-
-			d->read_cnt = d->write_cnt = 0;
+			char name[8];
+			snprintf (name, sizeof name, "%s:%d", c->name, dev_no);
+			init_disk (&c->devices[dev_no], c, dev_no, name);
 		}
 
 		/* Register interrupt handler. */
@@ -148,14 +276,141 @@ disk_init (void) {
 
 		/* Read hard disk identity information. */
 		for (dev_no = 0; dev_no < 2; dev_no++)
-			if (c->devices[dev_no].is_ata)
+			if (c->devices[dev_no].is_ata) {
 				identify_ata_device (&c->devices[dev_no]);
+				if (c->devices[dev_no].is_ata)
+					disks[chan_no][dev_no] = &c->devices[dev_no];
+			}
+
+		/* Start serving requests. */
+		if (c->devices[0].is_ata || c->devices[1].is_ata)
+			thread_create (c->name, PRI_MAX, dispatcher, c);
 	}
 
+	attach_virtio ();
+
 	/* DO NOT MODIFY BELOW LINES. */
 	register_disk_inspect_intr ();
 }
 
+/* Initializes the request queue of channel C. */
+static void
+init_channel (struct channel *c) {
+	lock_init (&c->lock);
+	list_init (&c->queue);
+	sema_init (&c->wakeup, 0);
+	c->virtio = NULL;
+}
+
+/* Initializes disk D, device DEV_NO on channel C, naming it NAME. */
+static void
+init_disk (struct disk *d, struct channel *c, int dev_no, const char *name) {
+	strlcpy (d->name, name, sizeof d->name);
+	d->channel = c;
+	d->dev_no = dev_no;
+
+	d->is_ata = false;
+	d->capacity = 0;
+	d->multiple = 0;
+	d->dma = false;
+	d->head = 0;
+	d->descending = false;
+
+	memset (&d->stats, 0, sizeof d->stats);
+	d->queued_cnt = d->completed_cnt = 0;
+	d->read_usecs = d->write_usecs = 0;
+}
+
+/* Returns true if SERIAL names a place "hdC:D" for disk_get() that
+   is free, and stores the place into *CHAN_NO and *DEV_NO. */
+static bool
+parse_place (const char *serial, int *chan_no, int *dev_no) {
+	if (serial[0] != 'h' || serial[1] != 'd'
+			|| serial[2] < '0' || serial[2] >= '0' + CHANNEL_CNT
+			|| serial[3] != ':' || (serial[4] != '0' && serial[4] != '1')
+			|| serial[5] != '\0')
+		return false;
+	*chan_no = serial[2] - '0';
+	*dev_no = serial[4] - '0';
+	return disks[*chan_no][*dev_no] == NULL;
+}
+
+/* Sets up the virtio block devices as disks.  A device whose
+   serial number is "hdC:D", as "pintos --virtio" gives them, takes
+   that place; any other takes the first free place. */
+static void
+attach_virtio (void) {
+	struct virtio_blk *vbs[VIRTIO_BLK_CNT];
+	size_t cnt = virtio_blk_init (vbs);
+	size_t i;
+
+	for (i = 0; i < cnt; i++) {
+		struct channel *c = &virtio_channels[i];
+		struct disk *d = &c->devices[0];
+		int chan_no, dev_no;
+		char name[8];
+
+		if (!parse_place (virtio_blk_serial (vbs[i]), &chan_no, &dev_no)) {
+			for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++)
+				for (dev_no = 0; dev_no < 2; dev_no++)
+					if (disks[chan_no][dev_no] == NULL)
+						goto found;
+			printf ("vd%zu: no place left for virtio disk\n", i);
+			continue;
+		}
+found:
+		snprintf (c->name, sizeof c->name, "vd%zu", i);
+		init_channel (c);
+		c->virtio = vbs[i];
+		snprintf (name, sizeof name, "hd%d:%d", chan_no, dev_no);
+		init_disk (d, c, 0, name);
+		d->capacity = virtio_blk_capacity (vbs[i]);
+		disks[chan_no][dev_no] = d;
+
+		printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
+		print_capacity (d);
+		printf (") virtio disk %s\n", c->name);
+
+		virtio_blk_set_notify (vbs[i], &c->wakeup);
+		thread_create (c->name, PRI_MAX, virtio_dispatcher, c);
+	}
+}
+
+/* Returns the rate of CNT sectors moved in USECS microseconds, in
+   sectors per second. */
+static long long
+rate (long long cnt, int64_t usecs) {
+	return usecs > 0 ? cnt * 1000000 / usecs : 0;
+}
+
+/* Returns TOTAL / CNT, or 0 if CNT is 0. */
+static long long
+average (int64_t total, int64_t cnt) {
+	return cnt > 0 ? total / cnt : 0;
+}
+
+/* Prints the read and write latency histograms of disk D, from the
+   first bucket in use to the last. */
+static void
+print_latency (const struct disk *d) {
+	const struct disk_stats *st = &d->stats;
+	int first = -1, last = -1, i;
+
+	for (i = 0; i < DISK_LATENCY_BUCKETS; i++)
+		if (st->read_latency[i] > 0 || st->write_latency[i] > 0) {
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	if (first < 0)
+		return;
+
+	printf ("%s: %10s %8s %8s\n", d->name, "latency", "reads", "writes");
+	for (i = first; i <= last; i++)
+		printf ("%s: %7lld us %8lld %8lld\n", d->name,
+				i > 0 ? 1LL << i : 0LL, st->read_latency[i], st->write_latency[i]);
+}
+
 /* Prints disk statistics. */
 void
 disk_print_stats (void) {
@@ -166,13 +421,51 @@ disk_print_stats (void) {
 
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
-			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+			struct disk_stats *st;
+
+			if (d == NULL)
+				continue;
+			st = &d->stats;
+			printf ("%s: %lld reads, %lld writes, %lld commands\n",
+					d->name, st->read_cnt, st->write_cnt, st->cmd_cnt);
+			if (d->read_usecs > 0 || d->write_usecs > 0)
+				printf ("%s: %lld sectors/s read, %lld sectors/s written\n",
+						d->name, rate (st->read_cnt, d->read_usecs),
+						rate (st->write_cnt, d->write_usecs));
+			printf ("%s: %lld requests, %lld sectors of seeking\n",
+					d->name, st->request_cnt, st->seek_dist);
+			if (st->request_cnt == 0)
+				continue;
+			printf ("%s: %lld bytes read, %lld bytes written, "
+					"%lld sequential and %lld random commands\n",
+					d->name, st->read_bytes, st->write_bytes,
+					st->seq_cnt, st->random_cnt);
+			printf ("%s: lock contended %lld of %lld times, %lld us waiting\n",
+					d->name, st->lock_contended, st->lock_cnt, st->lock_time);
+			printf ("%s: per request %lld us queued, %lld us on the device, "
+					"%lld deep on average, %lld at most\n",
+					d->name, average (st->queue_time, st->request_cnt),
+					average (st->device_time, st->request_cnt),
+					average (st->depth_sum, st->request_cnt), st->depth_max);
+			if (st->intr_cnt > 0)
+				printf ("%s: %lld interrupts, %lld us to wake up on average\n",
+						d->name, st->intr_cnt,
+						average (st->intr_time, st->intr_cnt));
+			print_latency (d);
 		}
 	}
 }
 
+/* Copies the statistics of disk D into *STATS.  The copy is taken
+   without stopping the disk, so while requests are in flight its
+   counters may disagree slightly. */
+void
+disk_get_stats (struct disk *d, struct disk_stats *stats) {
+	ASSERT (d != NULL);
+
+	*stats = d->stats;
+}
+
 /* Returns the disk numbered DEV_NO--either 0 or 1 for master or
    slave, respectively--within the channel numbered CHAN_NO.
 
@@ -186,11 +479,8 @@ struct disk *
 disk_get (int chan_no, int dev_no) {
 	ASSERT (dev_no == 0 || dev_no == 1);
 
-	if (chan_no < (int) CHANNEL_CNT) {
-		struct disk *d = &channels[chan_no].devices[dev_no];
-		if (d->is_ata)
-			return d;
-	}
+	if (chan_no < (int) CHANNEL_CNT)
+		return disks[chan_no][dev_no];
 	return NULL;
 }
 
@@ -209,21 +499,7 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
-
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_read_multiple (d, sec_no, buffer, 1);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -233,23 +509,678 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, buffer, 1);
+}
+
+/* Reads CNT consecutive sectors, starting at SEC_NO, from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  Up to MAX_NSECT sectors are moved by a single command,
+   so this is much cheaper than CNT calls to disk_read().
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, void *buffer,
+		size_t cnt) {
+	transfer (d, sec_no, buffer, cnt, false);
+}
+
+/* Writes CNT consecutive sectors, starting at SEC_NO, to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   Returns after the disk has acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no,
+		const void *buffer, size_t cnt) {
+	transfer (d, sec_no, (uint8_t *) buffer, cnt, true);
+}
+
+/* Initializes R as a request to read CNT sectors, at most
+   DISK_REQUEST_MAX, starting at SEC_NO from disk D into BUFFER,
+   or to write them to the disk from BUFFER if WRITE is true.
+   BUFFER must be a kernel address.  R gets no completion
+   callback; set R->done and R->aux after this to give it one. */
+void
+disk_request_init (struct disk_request *r, struct disk *d,
+		disk_sector_t sec_no, void *buffer, size_t cnt, bool write) {
+	ASSERT (r != NULL);
+	ASSERT (d != NULL);
+	ASSERT (buffer != NULL && is_kernel_vaddr (buffer));
+	ASSERT (cnt > 0 && cnt <= DISK_REQUEST_MAX);
+
+	r->disk = d;
+	r->sec_no = sec_no;
+	r->cnt = cnt;
+	r->buffer = buffer;
+	r->write = write;
+	r->done = NULL;
+	r->aux = NULL;
+	sema_init (&r->finished, 0);
+}
+
+/* Queues request R on its disk's channel and returns without
+   waiting for it.  When R completes, R->done is called if it is
+   set; otherwise disk_wait() returns.  R and its buffer must stay
+   in place until then.  R->done runs in the channel's dispatcher
+   thread, so it must not wait for disk requests itself.
+
+   Requests are not served in the order they are queued.  The
+   elevator keeps the head sweeping across the disk, merges
+   requests for adjacent sectors into one command, and serves a
+   request that has waited past its deadline before anything
+   else. */
+void
+disk_submit (struct disk_request *r) {
+	struct channel *c = r->disk->channel;
+
+	acquire_channel (r->disk);
+	enqueue (r);
+	lock_release (&c->lock);
+}
+
+/* Waits for request R, which was submitted without a completion
+   callback, to complete. */
+void
+disk_wait (struct disk_request *r) {
+	ASSERT (r->done == NULL);
+
+	sema_down (&r->finished);
+}
+
+/* Returns the kernel address of the byte at user address UADDR,
+   through the kernel's mapping of the physical page behind it, so
+   that the dispatcher thread can reach it whatever address space
+   is active.  A page that is not present is faulted in first.  The
+   page is marked accessed and, if the disk is to fill it
+   (TO_MEMORY), dirty, since the disk does not go through the page
+   table as the CPU would.  Returns a null pointer if the page
+   cannot be used, such as a read-only page the disk would fill. */
+static uint8_t *
+user_to_kernel (uint8_t *uaddr, bool to_memory) {
+#ifdef USERPROG
+	uint64_t *pml4 = thread_current ()->pml4;
+	int try;
+
+	if (pml4 == NULL)
+		return NULL;
+	for (try = 0; try < 2; try++) {
+		uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
+
+		if (pte != NULL && (*pte & PTE_P)) {
+			if (!is_user_pte (pte) || (to_memory && !is_writable (pte)))
+				return NULL;
+			pml4_set_accessed (pml4, uaddr, true);
+			if (to_memory)
+				pml4_set_dirty (pml4, uaddr, true);
+			return (uint8_t *) ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
+		}
+
+		/* Touch the page, as the CPU would have when it copied the
+		   data itself. */
+		if (to_memory)
+			*(volatile uint8_t *) uaddr = *(volatile uint8_t *) uaddr;
+		else
+			(void) *(volatile uint8_t *) uaddr;
+	}
+#endif
+	return NULL;
+}
+
+/* Initializes R as a request for up to CNT sectors starting at
+   SEC_NO on disk D, to or from BUFFER, and returns the number it
+   covers.  A request for a user BUFFER stays within one page.
+   Returns 0, leaving R alone, if the first sector at BUFFER cannot
+   be reached from the dispatcher thread. */
+static size_t
+prepare (struct disk_request *r, struct disk *d, disk_sector_t sec_no,
+		uint8_t *buffer, size_t cnt, bool write) {
+	uint8_t *kbuffer = buffer;
+
+	if (cnt > DISK_REQUEST_MAX)
+		cnt = DISK_REQUEST_MAX;
+	if (!is_kernel_vaddr (buffer)) {
+		size_t fit = (PGSIZE - pg_ofs (buffer)) / DISK_SECTOR_SIZE;
+
+		if (cnt > fit)
+			cnt = fit;
+		kbuffer = cnt > 0 ? user_to_kernel (buffer, !write) : NULL;
+		if (kbuffer == NULL)
+			return 0;
+	}
+	disk_request_init (r, d, sec_no, kbuffer, cnt, write);
+	return cnt;
+}
+
+/* Moves sector SEC_NO of disk D to or from BUFFER, as transfer()
+   does, through a kernel buffer. */
+static void
+bounce_sector (struct disk *d, disk_sector_t sec_no, uint8_t *buffer,
+		bool write) {
+	uint8_t bounce[DISK_SECTOR_SIZE];
+	struct disk_request r;
+
+	if (write)
+		memcpy (bounce, buffer, DISK_SECTOR_SIZE);
+	disk_request_init (&r, d, sec_no, bounce, 1, write);
+	disk_submit (&r);
+	disk_wait (&r);
+	if (!write)
+		memcpy (buffer, bounce, DISK_SECTOR_SIZE);
+}
+
+/* Moves CNT sectors between disk D, starting at SEC_NO, and
+   BUFFER: to the disk if WRITE is true, from it otherwise.
+   Submits requests for all of it at once and waits for them.
+
+   BUFFER may be in user memory.  Each user page is then reached
+   through its kernel mapping, one request per page, and the
+   elevator merges the requests for consecutive pages back into a
+   single command.  A sector that straddles two pages goes through
+   a bounce buffer. */
+static void
+transfer (struct disk *d, disk_sector_t sec_no, uint8_t *buffer, size_t cnt,
+		bool write) {
 	struct channel *c;
+	struct disk_request one, *reqs;
+	size_t max;
 
 	ASSERT (d != NULL);
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
-	lock_release (&c->lock);
+	if (is_kernel_vaddr (buffer))
+		max = DIV_ROUND_UP (cnt, DISK_REQUEST_MAX);
+	else
+		max = DIV_ROUND_UP (pg_ofs (buffer) + cnt * DISK_SECTOR_SIZE, PGSIZE);
+	reqs = max > 1 ? malloc (max * sizeof *reqs) : NULL;
+	if (reqs == NULL) {
+		reqs = &one;
+		max = 1;
+	}
+
+	while (cnt > 0) {
+		size_t n, i, piece = 1;
+
+		/* Set up requests, outside the channel lock: faulting in a
+		   user page may take disk requests of its own. */
+		for (n = 0; n < max && cnt > 0; n++) {
+			piece = prepare (&reqs[n], d, sec_no, buffer, cnt, write);
+			if (piece == 0)
+				break;
+			sec_no += piece;
+			buffer += piece * DISK_SECTOR_SIZE;
+			cnt -= piece;
+		}
+
+		/* Queue them together, so that the dispatcher sees them
+		   all before it picks one. */
+		acquire_channel (d);
+		for (i = 0; i < n; i++)
+			enqueue (&reqs[i]);
+		lock_release (&c->lock);
+		for (i = 0; i < n; i++)
+			disk_wait (&reqs[i]);
+
+		if (piece == 0) {
+			bounce_sector (d, sec_no, buffer, write);
+			sec_no++;
+			buffer += DISK_SECTOR_SIZE;
+			cnt--;
+		}
+	}
+
+	if (reqs != &one)
+		free (reqs);
 }
-
+
+/* Elevator. */
+
+/* Acquires the lock of disk D's channel to queue requests for D,
+   counting in D's statistics how long that took. */
+static void
+acquire_channel (struct disk *d) {
+	struct channel *c = d->channel;
+	int64_t start;
+
+	if (!lock_try_acquire (&c->lock)) {
+		start = timer_usecs ();
+		lock_acquire (&c->lock);
+		d->stats.lock_contended++;
+		d->stats.lock_time += timer_usecs () - start;
+	}
+	d->stats.lock_cnt++;
+}
+
+/* Adds request R to its channel's queue and wakes up the
+   channel's dispatcher.  The channel lock must be held. */
+static void
+enqueue (struct disk_request *r) {
+	struct disk *d = r->disk;
+	struct channel *c = d->channel;
+	int64_t depth;
+
+	ASSERT (lock_held_by_current_thread (&c->lock));
+
+	r->deadline = timer_ticks () + (r->write ? WRITE_DEADLINE : READ_DEADLINE);
+	r->queued = timer_usecs ();
+	depth = ++d->queued_cnt - d->completed_cnt;
+	d->stats.depth_sum += depth;
+	if (depth > d->stats.depth_max)
+		d->stats.depth_max = depth;
+	list_push_back (&c->queue, &r->elem);
+	sema_up (&c->wakeup);
+}
+
+/* Returns the request for disk D in channel C's queue that lies
+   nearest ahead of D's head in the direction the elevator sweeps,
+   or a null pointer if there is none. */
+static struct disk_request *
+look (struct channel *c, struct disk *d) {
+	struct disk_request *best = NULL;
+	struct list_elem *e;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+
+		if (r->disk != d)
+			continue;
+		if (d->descending
+				? r->sec_no < d->head && (best == NULL || r->sec_no > best->sec_no)
+				: r->sec_no >= d->head && (best == NULL || r->sec_no < best->sec_no))
+			best = r;
+	}
+	return best;
+}
+
+/* Removes and returns the request in channel C's queue, which must
+   not be empty, to serve next.  If some request has waited past
+   its deadline, that is the one with the earliest deadline.
+   Otherwise that request's disk is served by LOOK: the head keeps
+   moving in one direction, to the nearest request ahead of it, and
+   turns around when there is none left that way.  With disk_fifo
+   set, it is simply the oldest request. */
+static struct disk_request *
+pick (struct channel *c) {
+	struct disk_request *first = NULL, *r;
+	struct list_elem *e;
+
+	if (disk_fifo)
+		return list_entry (list_pop_front (&c->queue), struct disk_request, elem);
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		r = list_entry (e, struct disk_request, elem);
+		if (first == NULL || r->deadline < first->deadline)
+			first = r;
+	}
+
+	r = first;
+	if (first->deadline > timer_ticks ()) {
+		struct disk *d = first->disk;
+
+		r = look (c, d);
+		if (r == NULL) {
+			d->descending = !d->descending;
+			r = look (c, d);
+		}
+	}
+	list_remove (&r->elem);
+	return r;
+}
+
+/* Fills BATCH with request R, just taken off channel C's queue,
+   and the queued requests that extend it on either side: same
+   disk and direction, adjacent sectors, MAX_NSECT sectors in all
+   at most.  Takes them off the queue too.  Returns the number of
+   requests in BATCH, which is in ascending order of sectors.
+   Merges nothing if disk_fifo is set. */
+static size_t
+merge (struct channel *c, struct disk_request *r,
+		struct disk_request **batch) {
+	disk_sector_t first = r->sec_no;
+	size_t cnt = r->cnt, n = 1;
+	struct list_elem *e;
+
+	batch[0] = r;
+	if (disk_fifo)
+		return 1;
+	e = list_begin (&c->queue);
+	while (e != list_end (&c->queue) && n < MAX_MERGE) {
+		struct disk_request *q = list_entry (e, struct disk_request, elem);
+
+		if (q->disk != r->disk || q->write != r->write
+				|| cnt + q->cnt > MAX_NSECT
+				|| (q->sec_no != first + cnt && q->sec_no + q->cnt != first)) {
+			e = list_next (e);
+			continue;
+		}
+
+		if (q->sec_no == first + cnt)
+			batch[n] = q;
+		else {
+			memmove (batch + 1, batch, n * sizeof *batch);
+			batch[0] = q;
+			first = q->sec_no;
+		}
+		n++;
+		cnt += q->cnt;
+		list_remove (e);
+
+		/* Requests passed over may extend the batch now. */
+		e = list_begin (&c->queue);
+	}
+	return n;
+}
+
+/* Dispatcher thread of ATA channel C_.  Serves the requests
+   queued on the channel, a batch of merged requests per command.
+
+   C->wakeup counts the requests queued, less those taken off the
+   queue with a batch, so the dispatcher sleeps while the queue is
+   empty and at worst wakes up once with nothing to do. */
+static void
+dispatcher (void *c_) {
+	struct channel *c = c_;
+
+	for (;;) {
+		struct disk_request *batch[MAX_MERGE];
+		size_t n = 0;
+
+		sema_down (&c->wakeup);
+		lock_acquire (&c->lock);
+		if (!list_empty (&c->queue))
+			n = merge (c, pick (c), batch);
+		lock_release (&c->lock);
+
+		if (n > 0)
+			execute (batch, n);
+	}
+}
+
+/* Dispatcher thread of virtio channel C_.  Keeps as many of the
+   queued requests with the device as its ring holds, taking them
+   in the elevator's order, and completes them as the device
+   reports them done.  The device merges adjacent requests itself,
+   so they are posted one by one. */
+static void
+virtio_dispatcher (void *c_) {
+	struct channel *c = c_;
+	struct disk *d = &c->devices[0];
+
+	for (;;) {
+		struct disk_request *r;
+		bool ok;
+
+		sema_down (&c->wakeup);
+		while ((r = virtio_blk_reap (c->virtio, &ok)) != NULL) {
+			if (!ok)
+				PANIC ("%s: disk %s failed, sector=%"PRDSNu,
+						d->name, r->write ? "write" : "read", r->sec_no);
+			complete (r);
+		}
+
+		lock_acquire (&c->lock);
+		while (!list_empty (&c->queue)) {
+			r = pick (c);
+			if (!virtio_blk_post (c->virtio, r->sec_no, r->buffer, r->cnt,
+						r->write, r)) {
+				/* The ring is full.  A completion will wake us up. */
+				list_push_front (&c->queue, &r->elem);
+				break;
+			}
+			account (&r, 1);
+		}
+		lock_release (&c->lock);
+	}
+}
+
+/* Counts the N requests in BATCH, which cover consecutive sectors
+   in ascending order, as one command in their disk's statistics,
+   marks them given to the device, and moves the disk's head past
+   them.  Returns the number of sectors they cover. */
+static size_t
+account (struct disk_request **batch, size_t n) {
+	struct disk *d = batch[0]->disk;
+	struct disk_stats *st = &d->stats;
+	disk_sector_t sec_no = batch[0]->sec_no;
+	int64_t now = timer_usecs ();
+	size_t cnt = 0, i;
+
+	for (i = 0; i < n; i++) {
+		cnt += batch[i]->cnt;
+		batch[i]->started = now;
+	}
+	if (batch[0]->write) {
+		st->write_cnt += cnt;
+		st->write_bytes += cnt * DISK_SECTOR_SIZE;
+	} else {
+		st->read_cnt += cnt;
+		st->read_bytes += cnt * DISK_SECTOR_SIZE;
+	}
+	st->cmd_cnt++;
+	st->request_cnt += n;
+	if (sec_no == d->head)
+		st->seq_cnt++;
+	else
+		st->random_cnt++;
+	st->seek_dist += sec_no > d->head ? sec_no - d->head : d->head - sec_no;
+	d->head = sec_no + cnt;
+	return cnt;
+}
+
+/* Returns the latency histogram bucket for USECS microseconds. */
+static int
+latency_bucket (int64_t usecs) {
+	int bucket = 0;
+
+	while (usecs >= 2 && bucket < DISK_LATENCY_BUCKETS - 1) {
+		usecs >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+/* Reports request R complete.  R may be gone afterward. */
+static void
+complete (struct disk_request *r) {
+	struct disk_stats *st = &r->disk->stats;
+	int64_t now = timer_usecs ();
+
+	st->queue_time += r->started - r->queued;
+	st->device_time += now - r->started;
+	if (r->write)
+		st->write_latency[latency_bucket (now - r->queued)]++;
+	else
+		st->read_latency[latency_bucket (now - r->queued)]++;
+	r->disk->completed_cnt++;
+
+	if (r->done != NULL)
+		r->done (r, r->aux);
+	else
+		sema_up (&r->finished);
+}
+
+/* Carries out the N requests in BATCH, which cover consecutive
+   sectors in ascending order, with one command, by DMA if
+   possible, and completes them. */
+static void
+execute (struct disk_request **batch, size_t n) {
+	struct disk *d = batch[0]->disk;
+	size_t cnt = account (batch, n), i;
+	int64_t start;
+
+	start = timer_usecs ();
+	if (!dma_transfer (batch, n, cnt))
+		pio_transfer (batch, n, cnt);
+	if (batch[0]->write)
+		d->write_usecs += timer_usecs () - start;
+	else
+		d->read_usecs += timer_usecs () - start;
+
+	for (i = 0; i < n; i++)
+		complete (batch[i]);
+}
+
+/* Returns the buffer for sector IDX of the sectors covered by the
+   requests in BATCH. */
+static uint8_t *
+sector_buffer (struct disk_request **batch, size_t idx) {
+	while (idx >= (*batch)->cnt)
+		idx -= (*batch++)->cnt;
+	return (*batch)->buffer + idx * DISK_SECTOR_SIZE;
+}
+
+/* Carries out the N requests in BATCH, CNT sectors in all, as
+   execute() does, with one command whose data the CPU copies
+   through the data register.  With READ/WRITE MULTIPLE the disk
+   interrupts once per block of D->multiple sectors instead of once
+   per sector. */
+static void
+pio_transfer (struct disk_request **batch, size_t n UNUSED, size_t cnt) {
+	struct disk *d = batch[0]->disk;
+	struct channel *c = d->channel;
+	disk_sector_t sec_no = batch[0]->sec_no;
+	bool write = batch[0]->write;
+	size_t block = d->multiple > 0 ? (size_t) d->multiple : 1;
+	size_t done, i, k;
+
+	select_sector (d, sec_no, cnt);
+	if (write)
+		issue_pio_command (c, d->multiple > 0
+				? CMD_WRITE_MULTIPLE : CMD_WRITE_SECTOR_RETRY);
+	else
+		issue_pio_command (c, d->multiple > 0
+				? CMD_READ_MULTIPLE : CMD_READ_SECTOR_RETRY);
+	for (done = 0; done < cnt; done += k) {
+		k = cnt - done < block ? cnt - done : block;
+		if (write) {
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) done);
+			for (i = 0; i < k; i++)
+				output_sectors (c, sector_buffer (batch, done + i), 1);
+			wait_interrupt (d);
+		} else {
+			wait_interrupt (d);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) done);
+			for (i = 0; i < k; i++)
+				input_sectors (c, sector_buffer (batch, done + i), 1);
+		}
+	}
+}
+
+/* DMA. */
+
+/* Looks for a PCI IDE controller that can act as bus master, such
+   as the PIIX, and returns the base of its bus master registers,
+   or 0 if there is none. */
+static uint16_t
+find_bus_master (void) {
+	struct pci_dev pd;
+
+	/* Class 1, subclass 1: IDE controller.  BAR4 holds its bus
+	   master registers, in I/O space. */
+	if (!pci_find_class (0x01, 0x01, &pd)
+			|| !(pci_read_config (&pd, PCI_REG_BAR0 + 4 * 4) & 1)
+			|| pci_bar (&pd, 4) == 0)
+		return 0;
+	pci_enable (&pd, PCI_CMD_IO | PCI_CMD_MASTER);
+	return pci_bar (&pd, 4);
+}
+
+/* Fills channel C's PRD table with the physical regions of the
+   buffers of the N requests in BATCH.  Each buffer is split at page
+   boundaries, since consecutive virtual pages need not be
+   consecutive in physical memory, and pieces that turn out to be,
+   within a buffer or across buffers, are merged again as long as
+   the region stays within 64 kB bounds.  Returns false if some
+   piece has no physical address the controller can use. */
+static bool
+build_prdt (struct channel *c, struct disk_request **batch, size_t n) {
+	size_t prd_cnt = 0;
+	uint64_t start = 0;             /* Current region. */
+	size_t len = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		uint8_t *buffer = batch[i]->buffer;
+		size_t size = batch[i]->cnt * DISK_SECTOR_SIZE;
+
+		while (size > 0) {
+			size_t chunk = PGSIZE - pg_ofs (buffer);
+			uint64_t addr = vtop (buffer);
+
+			if (chunk > size)
+				chunk = size;
+			if (addr + chunk > UINT32_MAX || (addr & 1) || (chunk & 1))
+				return false;
+
+			if (len > 0 && start + len == addr
+					&& (start >> 16) == ((addr + chunk - 1) >> 16))
+				len += chunk;
+			else {
+				if (len > 0) {
+					if (prd_cnt == PRD_CNT)
+						return false;
+					c->prdt[prd_cnt++] = (struct prd) {start, len, 0};
+				}
+				start = addr;
+				len = chunk;
+			}
+			buffer += chunk;
+			size -= chunk;
+		}
+	}
+	if (len == 0 || prd_cnt == PRD_CNT)
+		return false;
+
+	/* A size of 0 stands for 64 kB. */
+	c->prdt[prd_cnt] = (struct prd) {start, len, PRD_EOT};
+	return true;
+}
+
+/* Carries out the N requests in BATCH, CNT sectors in all, as
+   execute() does, by bus master DMA.  The dispatcher sleeps until
+   the disk interrupts, leaving the CPU to other threads for the
+   whole transfer.  Returns false, having moved nothing, if DMA is
+   not available or a buffer is not suitable for it, and also if
+   the transfer failed, so that the caller falls back to programmed
+   I/O. */
+static bool
+dma_transfer (struct disk_request **batch, size_t n, size_t cnt) {
+	struct disk *d = batch[0]->disk;
+	struct channel *c = d->channel;
+	bool write = batch[0]->write;
+	uint8_t dir = write ? 0 : BMCMD_READ;
+
+	if (!d->dma || !build_prdt (c, batch, n))
+		return false;
+
+	/* Stop the engine, give it the table, clear old status. */
+	outb (reg_bmcmd (c), dir);
+	outl (reg_bmprdt (c), vtop (c->prdt));
+	outb (reg_bmstat (c), inb (reg_bmstat (c)) | BMSTAT_ERR | BMSTAT_INTR);
+
+	select_sector (d, batch[0]->sec_no, cnt);
+	c->dma_active = true;
+	issue_pio_command (c, write ? CMD_WRITE_DMA : CMD_READ_DMA);
+	outb (reg_bmcmd (c), dir | BMCMD_START);
+	wait_interrupt (d);
+	c->dma_active = false;
+
+	if ((c->dma_status & BMSTAT_ERR)
+			|| (inb (reg_alt_status (c)) & STA_ERR)) {
+		printf ("%s: DMA failed, sector=%"PRDSNu", using PIO\n",
+				d->name, batch[0]->sec_no);
+		d->dma = false;
+		return false;
+	}
+	return true;
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -359,13 +1290,47 @@ identify_ata_device (struct disk *d) {
 		d->is_ata = false;
 		return;
 	}
-	input_sector (c, id);
+	input_sectors (c, id, 1);
 
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	/* Word 49 tells whether the disk supports DMA. */
+	d->dma = (id[49] & 0x0100) != 0 && c->bm_base != 0;
+
+	/* Use the largest block READ/WRITE MULTIPLE allow. */
+	if ((id[47] & 0xff) > 0)
+		set_multiple_mode (d, id[47] & 0xff);
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
+	print_capacity (d);
+	printf (") disk, model \"");
+	print_ata_string ((char *) &id[27], 40);
+	printf ("\", serial \"");
+	print_ata_string ((char *) &id[10], 20);
+	printf ("\"\n");
+}
+
+/* Sends a SET MULTIPLE MODE command to disk D, so that READ and
+   WRITE MULTIPLE move BLOCK sectors per interrupt.  Sets
+   D->multiple to BLOCK if the disk accepts it. */
+static void
+set_multiple_mode (struct disk *d, int block) {
+	struct channel *c = d->channel;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), block);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	if (!(inb (reg_alt_status (c)) & STA_ERR))
+		d->multiple = block;
+}
+
+/* Prints the capacity of disk D in the largest fitting unit. */
+static void
+print_capacity (const struct disk *d) {
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
 		printf ("%"PRDSNu" GB",
 				d->capacity / (1024 / DISK_SECTOR_SIZE * 1024 * 1024));
@@ -375,11 +1340,6 @@ identify_ata_device (struct disk *d) {
 		printf ("%"PRDSNu" kB", d->capacity / (1024 / DISK_SECTOR_SIZE));
 	else
 		printf ("%"PRDSNu" byte", d->capacity * DISK_SECTOR_SIZE);
-	printf (") disk, model \"");
-	print_ata_string ((char *) &id[27], 40);
-	printf ("\", serial \"");
-	print_ata_string ((char *) &id[10], 20);
-	printf ("\"\n");
 }
 
 /* Prints STRING, which consists of SIZE bytes in a funky format:
@@ -402,17 +1362,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and CNT, which must be between 1 and MAX_NSECT,
+   to the disk's sector selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= MAX_NSECT);
+	ASSERT (sec_no < d->capacity && cnt <= d->capacity - sec_no);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt == MAX_NSECT ? 0 : cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -432,18 +1393,30 @@ issue_pio_command (struct channel *c, uint8_t command) {
 	outb (reg_command (c), command);
 }
 
-/* Reads a sector from channel C's data register in PIO mode into
-   SECTOR, which must have room for DISK_SECTOR_SIZE bytes. */
+/* Waits for the interrupt of a command issued to disk D, counting
+   in D's statistics how long after the interrupt we got to run. */
+static void
+wait_interrupt (struct disk *d) {
+	struct channel *c = d->channel;
+
+	sema_down (&c->completion_wait);
+	d->stats.intr_cnt++;
+	d->stats.intr_time += timer_usecs () - c->intr_usecs;
+}
+
+/* Reads CNT sectors from channel C's data register in PIO mode
+   into SECTORS, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes. */
 static void
-input_sector (struct channel *c, void *sector) {
-	insw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
+input_sectors (struct channel *c, void *sectors, size_t cnt) {
+	insw (reg_data (c), sectors, cnt * DISK_SECTOR_SIZE / 2);
 }
 
-/* Writes SECTOR to channel C's data register in PIO mode.
-   SECTOR must contain DISK_SECTOR_SIZE bytes. */
+/* Writes CNT sectors from SECTORS to channel C's data register in
+   PIO mode.  SECTORS must contain CNT * DISK_SECTOR_SIZE bytes. */
 static void
-output_sector (struct channel *c, const void *sector) {
-	outsw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
+output_sectors (struct channel *c, const void *sectors, size_t cnt) {
+	outsw (reg_data (c), sectors, cnt * DISK_SECTOR_SIZE / 2);
 }
 
 /* Low-level ATA primitives. */
@@ -519,7 +1492,14 @@ interrupt_handler (struct intr_frame *f) {
 	for (c = channels; c < channels + CHANNEL_CNT; c++)
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
+				if (c->dma_active) {
+					/* Stop the bus master and clear its interrupt. */
+					c->dma_status = inb (reg_bmstat (c));
+					outb (reg_bmcmd (c), inb (reg_bmcmd (c)) & ~BMCMD_START);
+					outb (reg_bmstat (c), BMSTAT_ERR | BMSTAT_INTR);
+				}
 				inb (reg_status (c));               /* Acknowledge interrupt. */
+				c->intr_usecs = timer_usecs ();
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
@@ -532,13 +1512,13 @@ interrupt_handler (struct intr_frame *f) {
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
-	f->R.rax = d->read_cnt;
+	f->R.rax = d->stats.read_cnt;
 }
 
 static void
 inspect_write_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
-	f->R.rax = d->write_cnt;
+	f->R.rax = d->stats.write_cnt;
 }
 
 /* Tool for testing disk r/w cnt. Calling this function via int 0x43 and int 0x44.
@@ -1,25 +1,72 @@
 #include "devices/input.h"
 #include <debug.h>
+#include <poll.h>
+#include <tty.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/synch.h"
+
+/* Console input and its line discipline.
+
+   Keys from the keyboard and serial port land in BUFFER from their
+   interrupt handlers.  In canonical mode, the default, readers get
+   input a line at a time: input_read() waits until a whole line is
+   there, or until the buffer is full and cannot take the rest of
+   one, and then hands over the line in one piece.  In raw mode,
+   input_read() hands over whatever is there as soon as there is
+   anything.  Either way, a reader is woken only once the buffer
+   holds something it will take, not for every key, and takes all
+   of it at once.  Threads in poll() are woken at the same points. */
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+static int mode;                        /* TTY_* flags. */
+static int line_cnt;                    /* Newlines in BUFFER. */
+
+static struct lock read_lock;           /* One reader at a time. */
+static bool reader_waiting;             /* A reader sleeps on READABLE. */
+static struct semaphore readable;       /* Up when the reader can go on. */
+static struct poll_queue pollers;       /* Threads polling for input. */
+
 /* Initializes the input buffer. */
 void
 input_init (void) {
 	intq_init (&buffer);
+	lock_init (&read_lock);
+	sema_init (&readable, 0);
+	poll_queue_init (&pollers);
+}
+
+/* Returns true if a read would take something from the buffer
+   without waiting.  Interrupts must be off. */
+static bool
+ready (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return !intq_empty (&buffer)
+		&& ((mode & TTY_RAW) || line_cnt > 0 || intq_full (&buffer));
 }
 
-/* Adds a key to the input buffer.
-   Interrupts must be off and the buffer must not be full. */
+/* Adds a key to the input buffer.  In canonical mode, carriage
+   returns become newlines, since that is what terminals send for
+   Enter.  Interrupts must be off and the buffer must not be full. */
 void
 input_putc (uint8_t key) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (!intq_full (&buffer));
 
+	if (key == '\r' && !(mode & TTY_RAW))
+		key = '\n';
+	if (key == '\n')
+		line_cnt++;
 	intq_putc (&buffer, key);
+	if (ready ()) {
+		if (reader_waiting) {
+			reader_waiting = false;
+			sema_up (&readable);
+		}
+		poll_queue_wake (&pollers);
+	}
 	serial_notify ();
 }
 
@@ -32,12 +79,96 @@ input_getc (void) {
 
 	old_level = intr_disable ();
 	key = intq_getc (&buffer);
+	if (key == '\n')
+		line_cnt--;
 	serial_notify ();
 	intr_set_level (old_level);
 
 	return key;
 }
 
+/* Reads up to SIZE bytes of input into BUF, a line at a time in
+   canonical mode: the bytes read then end at the first newline.
+   Waits until there is input to deliver, unless TTY_NONBLOCK is
+   set, in which case it returns 0 at once.  Returns the number of
+   bytes read. */
+size_t
+input_read (uint8_t *buf, size_t size) {
+	enum intr_level old_level;
+	size_t n = 0, i;
+
+	if (size == 0)
+		return 0;
+	if (mode & TTY_NONBLOCK) {
+		if (!lock_try_acquire (&read_lock))
+			return 0;
+	} else
+		lock_acquire (&read_lock);
+
+	old_level = intr_disable ();
+	while (!ready ()) {
+		if (mode & TTY_NONBLOCK)
+			goto done;
+		reader_waiting = true;
+		sema_down (&readable);
+	}
+	n = intq_getn (&buffer, buf, size, mode & TTY_RAW ? -1 : '\n');
+	for (i = 0; i < n; i++)
+		if (buf[i] == '\n')
+			line_cnt--;
+	serial_notify ();
+
+done:
+	intr_set_level (old_level);
+	lock_release (&read_lock);
+	return n;
+}
+
+/* Returns the number of bytes waiting in the input buffer if a
+   read would return at once, or 0 if it would wait. */
+int
+input_pending (void) {
+	enum intr_level old_level = intr_disable ();
+	int n = ready () ? intq_count (&buffer) : 0;
+	intr_set_level (old_level);
+	return n;
+}
+
+/* Returns POLLIN if a read would return at once, otherwise 0.  If
+   E is nonnull, first puts W on the queue of threads polling for
+   input through E. */
+int
+input_poll (struct poll_entry *e, struct poll_waiter *w) {
+	enum intr_level old_level = intr_disable ();
+	int events;
+
+	if (e != NULL)
+		poll_queue_add (&pollers, e, w);
+	events = ready () ? POLLIN : 0;
+	intr_set_level (old_level);
+	return events;
+}
+
+/* Sets the input mode to MODE, a combination of TTY_* flags, and
+   returns the previous mode.  Switching to raw mode lets a waiting
+   reader take a partial line. */
+int
+input_set_mode (int new_mode) {
+	enum intr_level old_level = intr_disable ();
+	int old_mode = mode;
+
+	mode = new_mode & (TTY_RAW | TTY_NONBLOCK);
+	if (ready ()) {
+		if (reader_waiting) {
+			reader_waiting = false;
+			sema_up (&readable);
+		}
+		poll_queue_wake (&pollers);
+	}
+	intr_set_level (old_level);
+	return old_mode;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
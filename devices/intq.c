@@ -28,6 +28,35 @@ intq_full (const struct intq *q) {
 	return next (q->head) == q->tail;
 }
 
+/* Returns the number of bytes in Q. */
+int
+intq_count (const struct intq *q) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return (q->head - q->tail + INTQ_BUFSIZE) % INTQ_BUFSIZE;
+}
+
+/* Removes up to SIZE bytes from Q into BUF, stopping early after a
+   byte equal to DELIM, unless DELIM is -1.  Never sleeps, so it
+   returns 0 if Q is empty.  Returns the number of bytes removed.
+   Wakes a thread waiting to add to Q once, however many bytes it
+   removes, rather than once per byte. */
+size_t
+intq_getn (struct intq *q, uint8_t *buf, size_t size, int delim) {
+	size_t n = 0;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	while (n < size && !intq_empty (q)) {
+		uint8_t byte = q->buf[q->tail];
+		q->tail = next (q->tail);
+		buf[n++] = byte;
+		if (byte == delim)
+			break;
+	}
+	if (n > 0)
+		signal (q, &q->not_full);
+	return n;
+}
+
 /* Removes a byte from Q and returns it.
    Q must not be empty if called from an interrupt handler.
    Otherwise, if Q is empty, first sleeps until a byte is
@@ -0,0 +1,134 @@
+#include "devices/pci.h"
+#include <debug.h>
+#include "threads/io.h"
+
+/* Access to PCI configuration space through the I/O ports of
+   configuration mechanism #1, which every PC chipset since the
+   PIIX supports.  Only bus 0 is scanned: that is where emulators
+   and simple PCs put all their devices. */
+
+#define CONFIG_ADDRESS 0xcf8        /* Selects a configuration register. */
+#define CONFIG_DATA 0xcfc           /* Reads or writes the selected one. */
+
+#define DEV_CNT 32                  /* Devices per bus. */
+#define FUNC_CNT 8                  /* Functions per device. */
+
+/* Returns the value of CONFIG_ADDRESS that selects register REG of
+   function FUNC of device DEV on bus BUS. */
+static uint32_t
+config_address (uint8_t bus, uint8_t dev, uint8_t func, uint8_t reg) {
+	return (0x80000000 | ((uint32_t) bus << 16) | ((uint32_t) dev << 11)
+			| ((uint32_t) func << 8) | (reg & 0xfc));
+}
+
+static uint32_t
+read_config (uint8_t bus, uint8_t dev, uint8_t func, uint8_t reg) {
+	outl (CONFIG_ADDRESS, config_address (bus, dev, func, reg));
+	return inl (CONFIG_DATA);
+}
+
+/* Calls MATCH on every function present on bus 0 from device
+   START_DEV, function START_FUNC on, and stores the first one for
+   which it returns true into *PD.  Returns true if there is one. */
+static bool
+scan (bool (*match) (const struct pci_dev *, uint32_t aux), uint32_t aux,
+		int start_dev, int start_func, struct pci_dev *pd) {
+	int dev, func;
+
+	for (dev = start_dev; dev < DEV_CNT; dev++, start_func = 0)
+		for (func = start_func; func < FUNC_CNT; func++) {
+			uint32_t id = read_config (0, dev, func, PCI_REG_ID);
+			uint32_t class;
+
+			if ((id & 0xffff) == 0xffff) {
+				/* No function 0 means no device at all. */
+				if (func == 0)
+					break;
+				continue;
+			}
+			class = read_config (0, dev, func, PCI_REG_CLASS);
+			pd->bus = 0;
+			pd->dev = dev;
+			pd->func = func;
+			pd->vendor_id = id & 0xffff;
+			pd->device_id = id >> 16;
+			pd->class = class >> 24;
+			pd->subclass = class >> 16;
+			pd->irq = read_config (0, dev, func, PCI_REG_IRQ);
+			if (match (pd, aux))
+				return true;
+		}
+	return false;
+}
+
+static bool
+class_matches (const struct pci_dev *pd, uint32_t aux) {
+	return pd->class == (aux >> 8) && pd->subclass == (aux & 0xff);
+}
+
+static bool
+id_matches (const struct pci_dev *pd, uint32_t aux) {
+	return pd->vendor_id == (aux >> 16) && pd->device_id == (aux & 0xffff);
+}
+
+/* Finds the first PCI function with the given CLASS and SUBCLASS
+   and stores it into *PD.  Returns true if successful, false if
+   there is none. */
+bool
+pci_find_class (uint8_t class, uint8_t subclass, struct pci_dev *pd) {
+	return scan (class_matches, ((uint32_t) class << 8) | subclass, 0, 0, pd);
+}
+
+/* Finds the first PCI function with the given VENDOR_ID and
+   DEVICE_ID and stores it into *PD.  Returns true if successful,
+   false if there is none. */
+bool
+pci_find_device (uint16_t vendor_id, uint16_t device_id,
+		struct pci_dev *pd) {
+	return scan (id_matches, ((uint32_t) vendor_id << 16) | device_id,
+			0, 0, pd);
+}
+
+/* Finds the next PCI function after *PD with the same vendor and
+   device IDs, and stores it into *PD.  Returns true if successful,
+   false if there is none. */
+bool
+pci_find_next_device (struct pci_dev *pd) {
+	return scan (id_matches, ((uint32_t) pd->vendor_id << 16) | pd->device_id,
+			pd->dev, pd->func + 1, pd);
+}
+
+/* Returns configuration register REG of PD.  REG is rounded down
+   to a multiple of 4. */
+uint32_t
+pci_read_config (const struct pci_dev *pd, uint8_t reg) {
+	return read_config (pd->bus, pd->dev, pd->func, reg);
+}
+
+/* Sets configuration register REG of PD to VALUE. */
+void
+pci_write_config (const struct pci_dev *pd, uint8_t reg, uint32_t value) {
+	outl (CONFIG_ADDRESS, config_address (pd->bus, pd->dev, pd->func, reg));
+	outl (CONFIG_DATA, value);
+}
+
+/* Returns the address in base address register BAR of PD, without
+   its type bits.  I/O space addresses are port numbers. */
+uint32_t
+pci_bar (const struct pci_dev *pd, int bar) {
+	uint32_t value;
+
+	ASSERT (bar >= 0 && bar < 6);
+	value = pci_read_config (pd, PCI_REG_BAR0 + 4 * bar);
+	return value & 1 ? value & ~0x3u : value & ~0xfu;
+}
+
+/* Sets the bits in COMMAND in PD's command register. */
+void
+pci_enable (const struct pci_dev *pd, uint16_t command) {
+	uint32_t value = pci_read_config (pd, PCI_REG_COMMAND);
+
+	/* The upper half is the status register, whose bits are
+	   cleared by writing 1s: write back zeros there. */
+	pci_write_config (pd, PCI_REG_COMMAND, (value & 0xffff) | command);
+}
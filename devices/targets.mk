@@ -2,6 +2,8 @@ devices_SRC  = devices/timer.c		# Timer device.
 devices_SRC += devices/kbd.c		# Keyboard device.
 devices_SRC += devices/vga.c		# Video device.
 devices_SRC += devices/serial.c		# Serial port device.
+devices_SRC += devices/pci.c		# PCI configuration space.
 devices_SRC += devices/disk.c		# IDE disk device.
+devices_SRC += devices/virtio-blk.c	# Virtio block device.
 devices_SRC += devices/input.c		# Serial and keyboard input.
 devices_SRC += devices/intq.c		# Interrupt queue.
@@ -8,6 +8,10 @@
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/fixed-point.h"
+#include "intrinsic.h"
+#ifdef USERPROG
+#include "userprog/vdata.h"
+#endif
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -21,10 +25,21 @@
 /* Number of timer ticks since OS booted. */
 static int64_t os_ticks;
 
+/* 8254 input clock cycles per timer tick.  Set by timer_init(). */
+static uint16_t pit_count;
+
+/* Last value returned by timer_usecs(). */
+static int64_t last_usecs;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time stamp counter cycles per timer tick, measured over
+   TSC_CALIBRATE_TICKS ticks.  Initialized by timer_calibrate(). */
+#define TSC_CALIBRATE_TICKS 4
+static uint64_t tsc_per_tick;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
@@ -39,6 +54,7 @@ void timer_init(void)
 	   nearest. */
 	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
 
+	pit_count = count;
 	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb(0x40, count & 0xff);
 	outb(0x40, count >> 8);
@@ -46,10 +62,13 @@ void timer_init(void)
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays, and
+   tsc_per_tick, used to tell time between ticks. */
 void timer_calibrate(void)
 {
 	unsigned high_bit, test_bit;
+	int64_t start;
+	uint64_t tsc;
 
 	ASSERT(intr_get_level() == INTR_ON);
 	printf("Calibrating timer...  ");
@@ -70,6 +89,24 @@ void timer_calibrate(void)
 			loops_per_tick |= test_bit;
 
 	printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+	/* Count time stamp counter cycles from one tick to a later
+	   one. */
+	start = os_ticks;
+	while (os_ticks == start)
+		barrier();
+	tsc = rdtsc();
+	start = os_ticks;
+	while (os_ticks < start + TSC_CALIBRATE_TICKS)
+		barrier();
+	tsc_per_tick = (rdtsc() - tsc) / TSC_CALIBRATE_TICKS;
+}
+
+/* Returns the number of time stamp counter cycles per timer tick,
+   or 0 if timer_calibrate() has not measured it yet. */
+uint64_t timer_tsc_per_tick(void)
+{
+	return tsc_per_tick;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -89,6 +126,36 @@ int64_t timer_elapsed(int64_t then)
 	return timer_ticks() - then;
 }
 
+/* Returns the number of microseconds since the OS booted.  Within
+   a tick, the time comes from the 8254's counter, which counts
+   down from pit_count once per input clock cycle, so it is good to
+   about a microsecond.  The values returned never decrease. */
+int64_t timer_usecs(void)
+{
+	enum intr_level old_level = intr_disable();
+	int64_t ticks = os_ticks;
+	unsigned remaining;
+	int64_t usecs;
+
+	outb(0x43, 0x00); /* CW: latch counter 0. */
+	remaining = inb(0x40);
+	remaining |= inb(0x40) << 8;
+
+	/* If the counter has started a new tick whose interrupt is
+	   still pending in the PIC, OS_TICKS is one behind. */
+	outb(0x20, 0x0a); /* OCW3: read IRR. */
+	if ((inb(0x20) & 1) && remaining > pit_count / 2u)
+		ticks++;
+
+	usecs = ticks * (1000000 / TIMER_FREQ)
+		+ (int64_t)(pit_count - remaining) * 1000000 / 1193180;
+	if (usecs < last_usecs)
+		usecs = last_usecs;
+	last_usecs = usecs;
+	intr_set_level(old_level);
+	return usecs;
+}
+
 /* timer_sleep() - 현재 스레드를 ticks만큼 BLOCKED 상태로 만들고, wakeup_tick 내림차순으로 sleep_list에 삽입한다.
  */
 void timer_sleep(int64_t ticks)
@@ -128,6 +195,9 @@ static void timer_interrupt(struct intr_frame *args UNUSED)
 	os_ticks++;
 	thread_tick();
 	thread_wakeup(os_ticks);
+#ifdef USERPROG
+	vdata_tick(os_ticks, (args->cs & 3) == 3);
+#endif
 
 	if (!thread_mlfqs)
 		return;
@@ -0,0 +1,380 @@
+#include "devices/virtio-blk.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/pci.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A driver for virtio block devices [VIRTIO], as QEMU provides
+   with "-device virtio-blk-pci", through the legacy PCI interface.
+
+   Each device has one virtqueue: a ring of descriptors that the
+   driver fills with requests and the device hands back as it
+   completes them, in any order.  Unlike an ATA channel, which
+   carries out one command at a time, the device takes as many
+   requests as the ring holds, so the host can work on all of them
+   at once.  The device interrupts when it has completed some. */
+
+/* PCI IDs of a transitional virtio block device, which offers the
+   legacy interface. */
+#define VIRTIO_VENDOR_ID 0x1af4
+#define VIRTIO_BLK_DEVICE_ID 0x1001
+
+/* Legacy virtio registers, in I/O space at BAR0. */
+#define reg_features(VB) ((VB)->io_base + 0x00)        /* Device features. */
+#define reg_guest_features(VB) ((VB)->io_base + 0x04)  /* Driver features. */
+#define reg_queue_pfn(VB) ((VB)->io_base + 0x08)       /* Ring page number. */
+#define reg_queue_size(VB) ((VB)->io_base + 0x0c)      /* Ring size (r/o). */
+#define reg_queue_select(VB) ((VB)->io_base + 0x0e)    /* Selects a ring. */
+#define reg_queue_notify(VB) ((VB)->io_base + 0x10)    /* Ring has work. */
+#define reg_status(VB) ((VB)->io_base + 0x12)          /* Device status. */
+#define reg_isr(VB) ((VB)->io_base + 0x13)             /* Interrupt status. */
+#define reg_capacity(VB) ((VB)->io_base + 0x14)        /* Sectors, 64 bits. */
+
+/* Device status register bits. */
+#define STATUS_ACK 0x01             /* Driver noticed the device. */
+#define STATUS_DRIVER 0x02          /* Driver knows how to drive it. */
+#define STATUS_DRIVER_OK 0x04       /* Driver is ready. */
+
+/* Interrupt status register bits. */
+#define ISR_QUEUE 0x01              /* A ring was updated. */
+
+/* A descriptor: one buffer of a request. */
+struct vring_desc {
+	uint64_t addr;              /* Physical address. */
+	uint32_t len;               /* Length in bytes. */
+	uint16_t flags;             /* VRING_DESC_F_* below. */
+	uint16_t next;              /* Next descriptor, if F_NEXT. */
+};
+#define VRING_DESC_F_NEXT 1     /* Request continues in NEXT. */
+#define VRING_DESC_F_WRITE 2    /* Device writes the buffer. */
+
+/* Ring of requests for the device, by first descriptor. */
+struct vring_avail {
+	uint16_t flags;
+	uint16_t idx;               /* Where the driver puts the next one. */
+	uint16_t ring[];
+};
+
+/* Ring of requests the device has completed. */
+struct vring_used_elem {
+	uint32_t id;                /* First descriptor of the request. */
+	uint32_t len;               /* Bytes written by the device. */
+};
+struct vring_used {
+	uint16_t flags;
+	uint16_t idx;               /* Where the device puts the next one. */
+	struct vring_used_elem ring[];
+};
+
+/* The used ring starts on a page of its own. */
+#define VRING_ALIGN 4096
+
+/* Request types and status. */
+#define VIRTIO_BLK_T_IN 0           /* Read. */
+#define VIRTIO_BLK_T_OUT 1          /* Write. */
+#define VIRTIO_BLK_T_GET_ID 8       /* Read the serial number. */
+#define VIRTIO_BLK_S_OK 0           /* Success. */
+
+/* Bytes of a serial number. */
+#define ID_BYTES 20
+
+/* First buffer of every request. */
+struct request_header {
+	uint32_t type;              /* VIRTIO_BLK_T_*. */
+	uint32_t reserved;
+	uint64_t sector;            /* First sector. */
+};
+
+/* State of a request the device has, stored at the index of its
+   first descriptor.  HEADER and STATUS are the first and last
+   buffers of the request. */
+struct slot {
+	struct request_header header;
+	uint8_t status;             /* VIRTIO_BLK_S_*, set by device. */
+	void *aux;                  /* Returned by virtio_blk_reap(). */
+};
+
+/* Descriptors per request: header, data, status. */
+#define REQUEST_DESCS 3
+
+/* A virtio block device. */
+struct virtio_blk {
+	uint16_t io_base;           /* Base I/O port. */
+	uint8_t irq;                /* Interrupt line. */
+	disk_sector_t capacity;     /* Capacity in sectors. */
+	char serial[ID_BYTES + 1];  /* Serial number, null-terminated. */
+
+	uint16_t size;              /* Descriptors in the ring. */
+	struct vring_desc *desc;    /* Descriptor table. */
+	struct vring_avail *avail;  /* Requests for the device. */
+	volatile struct vring_used *used;   /* Completed requests. */
+	struct slot *slots;         /* One per descriptor. */
+	uint16_t free_head;         /* First free descriptor. */
+	uint16_t free_cnt;          /* Number of free descriptors. */
+	uint16_t used_idx;          /* Next entry to reap in USED. */
+
+	struct semaphore *notify;   /* Up'd on interrupt, if nonnull. */
+};
+
+static struct virtio_blk devices[VIRTIO_BLK_CNT];
+static size_t device_cnt;
+
+static bool setup (struct virtio_blk *, const struct pci_dev *);
+static bool read_serial (struct virtio_blk *);
+static bool post (struct virtio_blk *, uint32_t type, uint64_t sector,
+		void *, size_t size, bool to_memory, void *aux);
+static void interrupt_handler (struct intr_frame *);
+
+/* Finds and sets up the virtio block devices on the PCI bus, up to
+   VIRTIO_BLK_CNT of them, and stores pointers to them into VBS.
+   Returns the number found. */
+size_t
+virtio_blk_init (struct virtio_blk *vbs[VIRTIO_BLK_CNT]) {
+	struct pci_dev pd;
+	uint16_t irqs = 0;          /* Interrupt lines with our handler. */
+	bool found;
+
+	for (found = pci_find_device (VIRTIO_VENDOR_ID, VIRTIO_BLK_DEVICE_ID, &pd);
+			found && device_cnt < VIRTIO_BLK_CNT;
+			found = pci_find_next_device (&pd)) {
+		struct virtio_blk *vb = &devices[device_cnt];
+
+		if (!setup (vb, &pd))
+			continue;
+
+		/* Devices may share an interrupt line.  The handler must
+		   see VB from now on, to acknowledge its interrupts. */
+		device_cnt++;
+		if (!(irqs & (1u << vb->irq))) {
+			irqs |= 1u << vb->irq;
+			intr_register_ext (vb->irq + 0x20, interrupt_handler, "virtio-blk");
+		}
+
+		if (!read_serial (vb)) {
+			printf ("virtio-blk: device at %02x:%x does not respond\n",
+					pd.dev, pd.func);
+			outb (reg_status (vb), 0);
+			device_cnt--;
+			continue;
+		}
+		vbs[device_cnt - 1] = vb;
+	}
+	return device_cnt;
+}
+
+/* Returns the size of VB in DISK_SECTOR_SIZE-byte sectors. */
+disk_sector_t
+virtio_blk_capacity (const struct virtio_blk *vb) {
+	return vb->capacity;
+}
+
+/* Returns VB's serial number, which is empty if the device has
+   none. */
+const char *
+virtio_blk_serial (const struct virtio_blk *vb) {
+	return vb->serial;
+}
+
+/* Makes VB's interrupt handler up NOTIFY whenever the device has
+   completed requests. */
+void
+virtio_blk_set_notify (struct virtio_blk *vb, struct semaphore *notify) {
+	enum intr_level old_level = intr_disable ();
+	vb->notify = notify;
+	intr_set_level (old_level);
+}
+
+/* Hands VB a request to read CNT sectors starting at SEC_NO into
+   BUFFER, or to write them from BUFFER if WRITE is true, and
+   returns true.  BUFFER must be a kernel address.  Returns false,
+   without doing anything, if VB's ring is full.  Once the request
+   is complete, virtio_blk_reap() returns AUX, which must not be a
+   null pointer.  Not thread-safe: only one thread may post and
+   reap requests of a given device. */
+bool
+virtio_blk_post (struct virtio_blk *vb, disk_sector_t sec_no, void *buffer,
+		size_t cnt, bool write, void *aux) {
+	ASSERT (aux != NULL);
+	ASSERT (is_kernel_vaddr (buffer));
+
+	return post (vb, write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN, sec_no,
+			buffer, cnt * DISK_SECTOR_SIZE, !write, aux);
+}
+
+/* Takes a completed request off VB's ring.  Returns the AUX it was
+   posted with and stores into *OK whether it succeeded, or returns
+   a null pointer if the device has completed no more requests. */
+void *
+virtio_blk_reap (struct virtio_blk *vb, bool *ok) {
+	struct slot *s;
+	uint16_t head, d;
+
+	if (vb->used->idx == vb->used_idx)
+		return NULL;
+	barrier ();
+	head = vb->used->ring[vb->used_idx % vb->size].id;
+	vb->used_idx++;
+
+	s = &vb->slots[head];
+	*ok = s->status == VIRTIO_BLK_S_OK;
+
+	/* Give the request's descriptors back. */
+	for (d = head; vb->desc[d].flags & VRING_DESC_F_NEXT; d = vb->desc[d].next)
+		vb->free_cnt++;
+	vb->free_cnt++;
+	vb->desc[d].next = vb->free_head;
+	vb->free_head = head;
+	return s->aux;
+}
+
+/* Resets the device described by PD, takes it as VB and sets up
+   its ring.  Returns true if successful. */
+static bool
+setup (struct virtio_blk *vb, const struct pci_dev *pd) {
+	size_t avail_ofs, used_ofs, ring_pages, slot_pages;
+	uint8_t *ring;
+	uint64_t capacity;
+	uint16_t i;
+
+	if (!(pci_read_config (pd, PCI_REG_BAR0) & 1) || pci_bar (pd, 0) == 0
+			|| pd->irq == 0 || pd->irq >= 16)
+		return false;
+	memset (vb, 0, sizeof *vb);
+	vb->io_base = pci_bar (pd, 0);
+	vb->irq = pd->irq;
+	pci_enable (pd, PCI_CMD_IO | PCI_CMD_MASTER);
+
+	/* Reset, then tell the device that we know it.  We need none
+	   of its optional features. */
+	outb (reg_status (vb), 0);
+	outb (reg_status (vb), STATUS_ACK);
+	outb (reg_status (vb), STATUS_ACK | STATUS_DRIVER);
+	inl (reg_features (vb));
+	outl (reg_guest_features (vb), 0);
+
+	/* Lay out ring 0 in physically contiguous pages. */
+	outw (reg_queue_select (vb), 0);
+	vb->size = inw (reg_queue_size (vb));
+	if (vb->size < REQUEST_DESCS)
+		goto fail;
+	avail_ofs = vb->size * sizeof (struct vring_desc);
+	used_ofs = ROUND_UP (avail_ofs + sizeof (struct vring_avail)
+			+ (vb->size + 1) * sizeof (uint16_t), VRING_ALIGN);
+	ring_pages = DIV_ROUND_UP (used_ofs + sizeof (struct vring_used)
+			+ vb->size * sizeof (struct vring_used_elem) + sizeof (uint16_t),
+			PGSIZE);
+	slot_pages = DIV_ROUND_UP (vb->size * sizeof (struct slot), PGSIZE);
+	ring = palloc_get_multiple (PAL_ZERO, ring_pages);
+	vb->slots = palloc_get_multiple (PAL_ZERO, slot_pages);
+	if (ring == NULL || vb->slots == NULL) {
+		if (ring != NULL)
+			palloc_free_multiple (ring, ring_pages);
+		if (vb->slots != NULL)
+			palloc_free_multiple (vb->slots, slot_pages);
+		goto fail;
+	}
+	vb->desc = (struct vring_desc *) ring;
+	vb->avail = (struct vring_avail *) (ring + avail_ofs);
+	vb->used = (struct vring_used *) (ring + used_ofs);
+	for (i = 0; i < vb->size; i++)
+		vb->desc[i].next = i + 1;
+	vb->free_head = 0;
+	vb->free_cnt = vb->size;
+	outl (reg_queue_pfn (vb), vtop (ring) / VRING_ALIGN);
+
+	capacity = inl (reg_capacity (vb)) | (uint64_t) inl (reg_capacity (vb) + 4) << 32;
+	vb->capacity = capacity < UINT32_MAX ? capacity : UINT32_MAX;
+
+	outb (reg_status (vb), STATUS_ACK | STATUS_DRIVER | STATUS_DRIVER_OK);
+	return true;
+
+fail:
+	outb (reg_status (vb), 0);
+	return false;
+}
+
+/* Reads VB's serial number into VB->serial, polling for the
+   answer, since no one waits for interrupts yet.  A device without
+   one leaves it empty.  Returns false if the device does not
+   answer within a second. */
+static bool
+read_serial (struct virtio_blk *vb) {
+	bool ok;
+	int i;
+
+	if (!post (vb, VIRTIO_BLK_T_GET_ID, 0, vb->serial, ID_BYTES, true,
+				vb->serial))
+		return false;
+	for (i = 0; i < 1000; i++) {
+		if (virtio_blk_reap (vb, &ok) != NULL) {
+			if (!ok)
+				vb->serial[0] = '\0';
+			vb->serial[ID_BYTES] = '\0';
+			return true;
+		}
+		timer_msleep (1);
+	}
+	return false;
+}
+
+/* Adds a request of TYPE for SECTOR to VB's ring, with SIZE bytes
+   of data at BUFFER, which the device writes if TO_MEMORY is true
+   and reads otherwise.  Returns false if the ring is full. */
+static bool
+post (struct virtio_blk *vb, uint32_t type, uint64_t sector, void *buffer,
+		size_t size, bool to_memory, void *aux) {
+	uint16_t d[REQUEST_DESCS];
+	struct slot *s;
+	int i;
+
+	if (vb->free_cnt < REQUEST_DESCS)
+		return false;
+	for (i = 0; i < REQUEST_DESCS; i++) {
+		d[i] = vb->free_head;
+		vb->free_head = vb->desc[d[i]].next;
+		vb->free_cnt--;
+	}
+
+	s = &vb->slots[d[0]];
+	s->header = (struct request_header) {type, 0, sector};
+	s->status = 0xff;
+	s->aux = aux;
+	vb->desc[d[0]] = (struct vring_desc) {
+		vtop (&s->header), sizeof s->header, VRING_DESC_F_NEXT, d[1]};
+	vb->desc[d[1]] = (struct vring_desc) {
+		vtop (buffer), size,
+		VRING_DESC_F_NEXT | (to_memory ? VRING_DESC_F_WRITE : 0), d[2]};
+	vb->desc[d[2]] = (struct vring_desc) {
+		vtop (&s->status), sizeof s->status, VRING_DESC_F_WRITE, 0};
+
+	/* The device may look at the ring entry as soon as it sees the
+	   new index. */
+	vb->avail->ring[vb->avail->idx % vb->size] = d[0];
+	barrier ();
+	vb->avail->idx++;
+	barrier ();
+	outw (reg_queue_notify (vb), 0);
+	return true;
+}
+
+/* virtio-blk interrupt handler, shared by the devices on the
+   interrupt line. */
+static void
+interrupt_handler (struct intr_frame *f) {
+	size_t i;
+
+	for (i = 0; i < device_cnt; i++) {
+		struct virtio_blk *vb = &devices[i];
+
+		/* Reading the status acknowledges the interrupt. */
+		if (f->vec_no == (uint64_t) vb->irq + 0x20
+				&& (inb (reg_isr (vb)) & ISR_QUEUE) && vb->notify != NULL)
+			sema_up (vb->notify);
+	}
+}
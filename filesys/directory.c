@@ -5,6 +5,9 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 
 /* A directory. */
 struct dir {
@@ -32,6 +35,7 @@ struct dir *
 dir_open (struct inode *inode) {
 	struct dir *dir = calloc (1, sizeof *dir);
 	if (inode != NULL && dir != NULL) {
+		inode_set_journaled (inode);
 		dir->inode = inode;
 		dir->pos = 0;
 		return dir;
@@ -46,7 +50,11 @@ dir_open (struct inode *inode) {
  * Return true if successful, false on failure. */
 struct dir *
 dir_open_root (void) {
+#ifdef EFILESYS
+	return dir_open (inode_open (cluster_to_sector (ROOT_DIR_CLUSTER)));
+#else
 	return dir_open (inode_open (ROOT_DIR_SECTOR));
+#endif
 }
 
 /* Opens and returns a new directory for the same inode as DIR.
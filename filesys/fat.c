@@ -1,11 +1,18 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
 
+/* Number of FAT entries held by one FAT sector. */
+#define ENTRIES_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
 /* Should be less than DISK_SECTOR_SIZE */
 struct fat_boot {
 	unsigned int magic;
@@ -24,12 +31,16 @@ struct fat_fs {
 	disk_sector_t data_start;
 	cluster_t last_clst;
 	struct lock write_lock;
+
+	struct bitmap *free_map;    /* One bit per cluster, true if in use. */
+	struct bitmap *dirty_map;   /* One bit per FAT sector, true if dirty. */
 };
 
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_index_build (void);
 
 void
 fat_init (void) {
@@ -53,6 +64,7 @@ fat_init (void) {
 
 void
 fat_open (void) {
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
@@ -78,8 +90,11 @@ fat_open (void) {
 			free (bounce);
 		}
 	}
+	fat_index_build ();
 }
 
+/* Writes the boot sector to the disk and hands the FAT sectors
+ * modified since the last flush to the journal. */
 void
 fat_close (void) {
 	// Write FAT boot sector
@@ -90,43 +105,69 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
+	lock_acquire (&fat_fs->write_lock);
+	fat_flush ();
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Hands every FAT sector modified since the last call to the
+ * journal.  Clean FAT sectors are skipped, so a commit after a
+ * handful of file operations logs a handful of sectors instead of
+ * the whole table.  The journal calls this when it commits, with
+ * no operation in progress. */
+void
+fat_flush (void) {
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
 	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
+	uint8_t *bounce;
+
 	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
+		off_t bytes_done = (off_t) i * DISK_SECTOR_SIZE;
+		off_t bytes_left = fat_size_in_bytes - bytes_done;
+		if (!bitmap_test (fat_fs->dirty_map, i))
+			continue;
 		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
+			journal_write (fat_fs->bs.fat_start + i, buffer + bytes_done);
 		} else {
 			bounce = calloc (1, DISK_SECTOR_SIZE);
 			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
+				PANIC ("FAT flush failed");
+			if (bytes_left > 0)
+				memcpy (bounce, buffer + bytes_done, bytes_left);
+			journal_write (fat_fs->bs.fat_start + i, bounce);
 			free (bounce);
 		}
 	}
+	bitmap_set_all (fat_fs->dirty_map, false);
 }
 
 void
 fat_create (void) {
+	const cluster_t journal_end =
+	    JOURNAL_CLUSTER + DIV_ROUND_UP (JOURNAL_SECTORS, SECTORS_PER_CLUSTER);
+	cluster_t clst;
+
 	// Create FAT boot
 	fat_boot_create ();
 	fat_fs_init ();
 
 	// Create FAT table
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_index_build ();
+
+	// Every sector of a fresh table must reach the disk.
+	bitmap_set_all (fat_fs->dirty_map, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
 
+	// Reserve the contiguous clusters of the metadata journal
+	for (clst = JOURNAL_CLUSTER; clst < journal_end; clst++)
+		fat_put (clst, clst + 1 < journal_end ? clst + 1 : EOChain);
+
 	// Fill up ROOT_DIR_CLUSTER region with 0
 	uint8_t *buf = calloc (1, DISK_SECTOR_SIZE);
 	if (buf == NULL)
@@ -152,42 +193,140 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	size_t data_sectors;
+
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	data_sectors = fat_fs->bs.total_sectors - fat_fs->data_start;
+
+	/* Cluster 0 is never handed out: it means "no cluster" to
+	 * fat_create_chain() callers.  Data clusters are numbered from 1. */
+	fat_fs->fat_length = data_sectors / SECTORS_PER_CLUSTER + 1;
+	if (fat_fs->fat_length > fat_fs->bs.fat_sectors * ENTRIES_PER_SECTOR)
+		fat_fs->fat_length = fat_fs->bs.fat_sectors * ENTRIES_PER_SECTOR;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER;
+	lock_init (&fat_fs->write_lock);
+
+	bitmap_destroy (fat_fs->free_map);
+	bitmap_destroy (fat_fs->dirty_map);
+	fat_fs->free_map = bitmap_create (fat_fs->fat_length);
+	fat_fs->dirty_map = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->free_map == NULL || fat_fs->dirty_map == NULL)
+		PANIC ("FAT init failed");
+}
+
+/* Rebuilds the in-memory free-cluster bitmap from the FAT, so that
+ * allocation never has to scan the table itself. */
+static void
+fat_index_build (void) {
+	cluster_t clst;
+
+	bitmap_set_all (fat_fs->free_map, false);
+	bitmap_mark (fat_fs->free_map, 0);
+	for (clst = 1; clst < fat_fs->fat_length; clst++)
+		if (fat_fs->fat[clst] != 0)
+			bitmap_mark (fat_fs->free_map, clst);
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Finds a free cluster, preferring HINT and the clusters after it so
+ * that a growing chain stays contiguous, marks it in use and returns
+ * it.  Returns 0 if the disk is full. */
+static cluster_t
+fat_alloc_cluster (cluster_t hint) {
+	size_t clst;
+
+	if (hint == 0 || hint >= fat_fs->fat_length)
+		hint = fat_fs->last_clst;
+	clst = bitmap_scan_and_flip (fat_fs->free_map, hint, 1, false);
+	if (clst == BITMAP_ERROR)
+		clst = bitmap_scan_and_flip (fat_fs->free_map, 1, 1, false);
+	if (clst == BITMAP_ERROR)
+		return 0;
+	fat_fs->last_clst = clst;
+	return clst;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t nclst;
+
+	ASSERT (clst < fat_fs->fat_length);
+
+	lock_acquire (&fat_fs->write_lock);
+	nclst = fat_alloc_cluster (clst != 0 ? clst + 1 : 0);
+	if (nclst != 0) {
+		fat_put (nclst, EOChain);
+		if (clst != 0)
+			fat_put (clst, nclst);
+	}
+	lock_release (&fat_fs->write_lock);
+	return nclst;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_put (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next;
+
+		ASSERT (clst < fat_fs->fat_length);
+		next = fat_fs->fat[clst];
+		fat_put (clst, 0);
+		bitmap_reset (fat_fs->free_map, clst);
+		journal_forget (cluster_to_sector (clst), SECTORS_PER_CLUSTER);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst < fat_fs->fat_length);
+
+	fat_fs->fat[clst] = val;
+	bitmap_mark (fat_fs->dirty_map, clst / ENTRIES_PER_SECTOR);
+	if (val != 0)
+		bitmap_mark (fat_fs->free_map, clst);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst < fat_fs->fat_length);
+
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Converts sector number SECTOR, which must be the first sector of
+ * a data cluster, back to its cluster #. */
+cluster_t
+sector_to_cluster (disk_sector_t sector) {
+	ASSERT (sector >= fat_fs->data_start);
+
+	return (sector - fat_fs->data_start) / SECTORS_PER_CLUSTER + 1;
+}
+
+/* Returns the number of free clusters. */
+size_t
+fat_free_cnt (void) {
+	return bitmap_count (fat_fs->free_map, 1, fat_fs->fat_length - 1, false);
 }
@@ -1,13 +1,22 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <poll.h>
 #include "filesys/inode.h"
+#include "filesys/pipe.h"
 #include "threads/malloc.h"
 
-/* An open file. */
+/* An open file.
+ *
+ * A file is either an open inode or an end of a pipe.  Pipes have
+ * no inode and no position; the functions that need those treat a
+ * pipe as an empty file that cannot be written at an offset. */
 struct file {
-	struct inode *inode;        /* File's inode. */
+	struct inode *inode;        /* File's inode, null for a pipe. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	struct pipe *pipe;          /* Pipe this is an end of, or null. */
+	bool write_end;             /* Whether it is the pipe's write end. */
+	int ref_cnt;                /* Holders, see file_dup(). */
 };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -20,6 +29,7 @@ file_open (struct inode *inode) {
 		file->inode = inode;
 		file->pos = 0;
 		file->deny_write = false;
+		file->ref_cnt = 1;
 		return file;
 	} else {
 		inode_close (inode);
@@ -28,18 +38,68 @@ file_open (struct inode *inode) {
 	}
 }
 
+/* Opens a new pipe and stores its read end in *READ_END and its
+ * write end in *WRITE_END.  Returns false if memory runs out. */
+bool
+file_open_pipe (struct file **read_end, struct file **write_end) {
+	struct pipe *pipe = pipe_create ();
+	struct file *r = calloc (1, sizeof *r);
+	struct file *w = calloc (1, sizeof *w);
+
+	if (pipe == NULL || r == NULL || w == NULL) {
+		if (pipe != NULL) {
+			/* Opening and closing an end frees the pipe. */
+			pipe_open_end (pipe, false);
+			pipe_close_end (pipe, false);
+		}
+		free (r);
+		free (w);
+		return false;
+	}
+	r->pipe = w->pipe = pipe;
+	w->write_end = true;
+	r->ref_cnt = w->ref_cnt = 1;
+	pipe_open_end (pipe, false);
+	pipe_open_end (pipe, true);
+	*read_end = r;
+	*write_end = w;
+	return true;
+}
+
+/* Returns true if FILE is an end of a pipe. */
+bool
+file_is_pipe (const struct file *file) {
+	return file->pipe != NULL;
+}
+
 /* Opens and returns a new file for the same inode as FILE.
- * Returns a null pointer if unsuccessful. */
+ * Returns a null pointer if unsuccessful, or if FILE is a pipe. */
 struct file *
 file_reopen (struct file *file) {
+	if (file->pipe != NULL)
+		return NULL;
 	return file_open (inode_reopen (file->inode));
 }
 
 /* Duplicate the file object including attributes and returns a new file for the
- * same inode as FILE. Returns a null pointer if unsuccessful. */
+ * same inode as FILE. Returns a null pointer if unsuccessful.
+ * For a pipe, returns another end of the same kind. */
 struct file *
 file_duplicate (struct file *file) {
-	struct file *nfile = file_open (inode_reopen (file->inode));
+	struct file *nfile;
+
+	if (file->pipe != NULL) {
+		nfile = calloc (1, sizeof *nfile);
+		if (nfile != NULL) {
+			nfile->pipe = file->pipe;
+			nfile->write_end = file->write_end;
+			nfile->ref_cnt = 1;
+			pipe_open_end (file->pipe, file->write_end);
+		}
+		return nfile;
+	}
+
+	nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
 		if (file->deny_write)
@@ -48,12 +108,25 @@ file_duplicate (struct file *file) {
 	return nfile;
 }
 
+/* Adds a holder to FILE and returns FILE.  Unlike a duplicate, it
+ * is the same open file, position included; file_close() closes it
+ * only when its last holder does. */
+struct file *
+file_dup (struct file *file) {
+	file->ref_cnt++;
+	return file;
+}
+
 /* Closes FILE. */
 void
 file_close (struct file *file) {
-	if (file != NULL) {
-		file_allow_write (file);
-		inode_close (file->inode);
+	if (file != NULL && --file->ref_cnt == 0) {
+		if (file->pipe != NULL)
+			pipe_close_end (file->pipe, file->write_end);
+		else {
+			file_allow_write (file);
+			inode_close (file->inode);
+		}
 		free (file);
 	}
 }
@@ -71,7 +144,12 @@ file_get_inode (struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
-	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+	off_t bytes_read;
+
+	if (file->pipe != NULL)
+		return file->write_end ? 0 : pipe_read (file->pipe, buffer, size);
+
+	bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
 	return bytes_read;
 }
@@ -83,6 +161,8 @@ file_read (struct file *file, void *buffer, off_t size) {
  * The file's current position is unaffected. */
 off_t
 file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
+	if (file->pipe != NULL)
+		return 0;
 	return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
@@ -95,7 +175,12 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
-	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+	off_t bytes_written;
+
+	if (file->pipe != NULL)
+		return file->write_end ? pipe_write (file->pipe, buffer, size) : 0;
+
+	bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
 	return bytes_written;
 }
@@ -110,15 +195,50 @@ file_write (struct file *file, const void *buffer, off_t size) {
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
 		off_t file_ofs) {
+	if (file->pipe != NULL)
+		return 0;
 	return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Copies SIZE bytes of file IN, starting at offset IN_OFS, into file
+ * OUT at offset OUT_OFS, without passing them through user memory.
+ * Returns the number of bytes actually copied, which may be less
+ * than SIZE if end of IN is reached or OUT cannot grow.
+ * The files' current positions are unaffected. */
+off_t
+file_copy_at (struct file *out, off_t out_ofs, struct file *in,
+		off_t in_ofs, off_t size) {
+	if (out->pipe != NULL || in->pipe != NULL)
+		return 0;
+	return inode_copy_at (out->inode, out_ofs, in->inode, in_ofs, size);
+}
+
+/* Writes everything written to FILE so far through to disk.
+ * Returns false if some of it could not be placed. */
+bool
+file_sync (struct file *file) {
+	if (file->pipe != NULL)
+		return true;
+	return inode_sync (file->inode);
+}
+
+/* Returns the POLL* events pending on FILE.  If E is nonnull, first
+ * puts W on FILE's poll queue through E, to be woken when they may
+ * change.  An inode never makes a reader or writer wait, so it is
+ * always ready and has no queue. */
+int
+file_poll (struct file *file, struct poll_entry *e, struct poll_waiter *w) {
+	if (file->pipe != NULL)
+		return pipe_poll (file->pipe, file->write_end, e, w);
+	return POLLIN | POLLOUT;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void
 file_deny_write (struct file *file) {
 	ASSERT (file != NULL);
-	if (!file->deny_write) {
+	if (!file->deny_write && file->pipe == NULL) {
 		file->deny_write = true;
 		inode_deny_write (file->inode);
 	}
@@ -140,6 +260,8 @@ file_allow_write (struct file *file) {
 off_t
 file_length (struct file *file) {
 	ASSERT (file != NULL);
+	if (file->pipe != NULL)
+		return 0;
 	return inode_length (file->inode);
 }
 
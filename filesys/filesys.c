@@ -6,7 +6,11 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/journal.h"
 #include "devices/disk.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
@@ -25,6 +29,7 @@ filesys_init (bool format) {
 
 #ifdef EFILESYS
 	fat_init ();
+	journal_init (cluster_to_sector (JOURNAL_CLUSTER), format);
 
 	if (format)
 		do_format ();
@@ -33,6 +38,7 @@ filesys_init (bool format) {
 #else
 	/* Original FS */
 	free_map_init ();
+	journal_init (JOURNAL_SECTOR, format);
 
 	if (format)
 		do_format ();
@@ -45,12 +51,15 @@ filesys_init (bool format) {
  * to disk. */
 void
 filesys_done (void) {
+	inode_done ();
+
 	/* Original FS */
 #ifdef EFILESYS
 	fat_close ();
 #else
 	free_map_close ();
 #endif
+	journal_done ();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -60,14 +69,29 @@ filesys_done (void) {
 bool
 filesys_create (const char *name, off_t initial_size) {
 	disk_sector_t inode_sector = 0;
-	struct dir *dir = dir_open_root ();
+	struct dir *dir;
+
+	journal_begin ();
+	dir = dir_open_root ();
+#ifdef EFILESYS
+	cluster_t inode_clst = dir != NULL ? fat_create_chain (0) : 0;
+	if (inode_clst != 0)
+		inode_sector = cluster_to_sector (inode_clst);
+	bool success = (inode_clst != 0
+			&& inode_create (inode_sector, initial_size)
+			&& dir_add (dir, name, inode_sector));
+	if (!success && inode_clst != 0)
+		fat_remove_chain (inode_clst, 0);
+#else
 	bool success = (dir != NULL
 			&& free_map_allocate (1, &inode_sector)
 			&& inode_create (inode_sector, initial_size)
 			&& dir_add (dir, name, inode_sector));
 	if (!success && inode_sector != 0)
 		free_map_release (inode_sector, 1);
+#endif
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
@@ -95,9 +119,14 @@ filesys_open (const char *name) {
  * or if an internal memory allocation fails. */
 bool
 filesys_remove (const char *name) {
-	struct dir *dir = dir_open_root ();
-	bool success = dir != NULL && dir_remove (dir, name);
+	struct dir *dir;
+	bool success;
+
+	journal_begin ();
+	dir = dir_open_root ();
+	success = dir != NULL && dir_remove (dir, name);
 	dir_close (dir);
+	journal_end ();
 
 	return success;
 }
@@ -110,6 +139,8 @@ do_format (void) {
 #ifdef EFILESYS
 	/* Create FAT and save it to the disk. */
 	fat_create ();
+	if (!dir_create (cluster_to_sector (ROOT_DIR_CLUSTER), 16))
+		PANIC ("root directory creation failed");
 	fat_close ();
 #else
 	free_map_create ();
@@ -117,6 +148,7 @@ do_format (void) {
 		PANIC ("root directory creation failed");
 	free_map_close ();
 #endif
+	journal_flush ();
 
 	printf ("done.\n");
 }
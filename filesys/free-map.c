@@ -4,6 +4,7 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
@@ -16,6 +17,7 @@ free_map_init (void) {
 		PANIC ("bitmap creation failed--disk is too large");
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
 	bitmap_mark (free_map, ROOT_DIR_SECTOR);
+	bitmap_set_multiple (free_map, JOURNAL_SECTOR, JOURNAL_SECTORS, true);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
@@ -36,12 +38,61 @@ free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
 	return sector != BITMAP_ERROR;
 }
 
+/* Allocates up to CNT consecutive sectors, preferring a run that
+ * begins exactly at GOAL, then the first run of CNT free sectors
+ * at or after GOAL, then anywhere, then shorter runs.  Stores the
+ * first sector into *SECTORP and returns the number of sectors
+ * allocated, which is 0 only if the disk is full. */
+size_t
+free_map_allocate_near (disk_sector_t goal, size_t cnt,
+		disk_sector_t *sectorp) {
+	size_t size = bitmap_size (free_map);
+	size_t sector, got;
+
+	ASSERT (cnt > 0);
+	if (goal >= size)
+		goal = 0;
+
+	if (!bitmap_test (free_map, goal)) {
+		/* Continue the caller's run right where it ends. */
+		sector = goal;
+		for (got = 1; got < cnt && goal + got < size
+				&& !bitmap_test (free_map, goal + got); got++)
+			continue;
+	} else {
+		for (got = cnt; got > 0; got /= 2) {
+			sector = bitmap_scan (free_map, goal, got, false);
+			if (sector == BITMAP_ERROR)
+				sector = bitmap_scan (free_map, 0, got, false);
+			if (sector != BITMAP_ERROR)
+				break;
+		}
+		if (got == 0)
+			return 0;
+	}
+
+	bitmap_set_multiple (free_map, sector, got, true);
+	if (free_map_file != NULL && !bitmap_write (free_map, free_map_file)) {
+		bitmap_set_multiple (free_map, sector, got, false);
+		return 0;
+	}
+	*sectorp = sector;
+	return got;
+}
+
 /* Makes CNT sectors starting at SECTOR available for use. */
 void
 free_map_release (disk_sector_t sector, size_t cnt) {
 	ASSERT (bitmap_all (free_map, sector, cnt));
 	bitmap_set_multiple (free_map, sector, cnt, false);
 	bitmap_write (free_map, free_map_file);
+	journal_forget (sector, cnt);
+}
+
+/* Returns the number of free sectors. */
+size_t
+free_map_free_cnt (void) {
+	return bitmap_count (free_map, 0, bitmap_size (free_map), false);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -50,6 +101,7 @@ free_map_open (void) {
 	free_map_file = file_open (inode_open (FREE_MAP_SECTOR));
 	if (free_map_file == NULL)
 		PANIC ("can't open free map");
+	inode_set_journaled (file_get_inode (free_map_file));
 	if (!bitmap_read (free_map, free_map_file))
 		PANIC ("can't read free map");
 }
@@ -64,14 +116,23 @@ free_map_close (void) {
  * it. */
 void
 free_map_create (void) {
+	struct file *file;
+
 	/* Create inode. */
 	if (!inode_create (FREE_MAP_SECTOR, bitmap_file_size (free_map)))
 		PANIC ("free map creation failed");
 
-	/* Write bitmap to file. */
-	free_map_file = file_open (inode_open (FREE_MAP_SECTOR));
-	if (free_map_file == NULL)
+	/* Write bitmap to file.  The first write allocates the file's
+	 * sectors, so it must happen before FREE_MAP_FILE is set, or
+	 * allocating them would write the free map recursively.  The
+	 * second write records those sectors as used. */
+	file = file_open (inode_open (FREE_MAP_SECTOR));
+	if (file == NULL)
 		PANIC ("can't open free map");
+	inode_set_journaled (file_get_inode (file));
+	if (!bitmap_write (free_map, file))
+		PANIC ("can't write free map");
+	free_map_file = file;
 	if (!bitmap_write (free_map, free_map_file))
 		PANIC ("can't write free map");
 }
@@ -1,11 +1,13 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "devices/disk.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
@@ -187,3 +189,72 @@ fsutil_get (char **argv) {
 	file_close (src);
 	free (buffer);
 }
+
+/* Prints, for each file in the root directory, how many runs of
+ * consecutive disk sectors hold its data.  A run count close to the
+ * sector count means sequential reads of the file seek on almost
+ * every sector. */
+void
+fsutil_frag (char **argv UNUSED) {
+	struct dir *dir;
+	char name[NAME_MAX + 1];
+	size_t file_cnt = 0, sector_cnt = 0, run_cnt = 0;
+
+	printf ("Fragmentation of files in the root directory:\n");
+	dir = dir_open_root ();
+	if (dir == NULL)
+		PANIC ("root dir open failed");
+	while (dir_readdir (dir, name)) {
+		struct file *file = filesys_open (name);
+		struct inode *inode;
+		size_t sectors, runs;
+
+		if (file == NULL)
+			PANIC ("%s: open failed", name);
+		inode = file_get_inode (file);
+		sectors = DIV_ROUND_UP (inode_length (inode), DISK_SECTOR_SIZE);
+		runs = inode_run_cnt (inode);
+		printf ("%-14s %8zu sectors in %6zu runs\n", name, sectors, runs);
+		file_cnt++;
+		sector_cnt += sectors;
+		run_cnt += runs;
+		file_close (file);
+	}
+	dir_close (dir);
+	printf ("%zu files, %zu sectors in %zu runs.\n",
+			file_cnt, sector_cnt, run_cnt);
+}
+
+/* Prints the logical size of each file in the root directory next
+ * to the disk space its data actually occupies.  Holes in sparse
+ * files take no space. */
+void
+fsutil_du (char **argv UNUSED) {
+	struct dir *dir;
+	char name[NAME_MAX + 1];
+	size_t logical_cnt = 0, allocated_cnt = 0;
+
+	printf ("Disk usage of files in the root directory:\n");
+	dir = dir_open_root ();
+	if (dir == NULL)
+		PANIC ("root dir open failed");
+	while (dir_readdir (dir, name)) {
+		struct file *file = filesys_open (name);
+		struct inode *inode;
+		size_t logical, allocated;
+
+		if (file == NULL)
+			PANIC ("%s: open failed", name);
+		inode = file_get_inode (file);
+		logical = DIV_ROUND_UP (inode_length (inode), DISK_SECTOR_SIZE);
+		allocated = inode_allocated_cnt (inode);
+		printf ("%-14s %8zu sectors logical %8zu allocated\n",
+				name, logical, allocated);
+		logical_cnt += logical;
+		allocated_cnt += allocated;
+		file_close (file);
+	}
+	dir_close (dir);
+	printf ("Total: %zu sectors logical, %zu allocated.\n",
+			logical_cnt, allocated_cnt);
+}
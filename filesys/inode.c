@@ -5,18 +5,70 @@
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A file that grows past its allocation reserves a window of
+ * sectors beyond what the write needs.  Windows start at
+ * PREALLOC_MIN sectors and double, up to PREALLOC_MAX, each time
+ * one is used up. */
+#define PREALLOC_MIN 8
+#define PREALLOC_MAX 128
+
+/* In delayed-allocation mode, an inode keeps at most DELALLOC_MAX
+ * sectors without disk space in memory before flushing them. */
+#define DELALLOC_MAX 64
+
+/* Bytes inode_copy_at() moves at a time.  64 kB of contiguous
+ * sectors still fit in a single disk command. */
+#define COPY_CHUNK (128 * DISK_SECTOR_SIZE)
+
+#ifndef EFILESYS
+/* Sector numbers held by an index block, and by the inode itself. */
+#define INDEX_CNT (DISK_SECTOR_SIZE / sizeof (disk_sector_t))
+#define DIRECT_CNT 123
+
+/* Largest number of data sectors an inode can map: 123 direct,
+ * 128 single-indirect and 128 * 128 doubly-indirect sectors, a bit
+ * over 8 MB. */
+#define INODE_SECTOR_CNT (DIRECT_CNT + INDEX_CNT + INDEX_CNT * INDEX_CNT)
+
+/* In-memory copy of an index block. */
+struct index_buf {
+	disk_sector_t sector;               /* Index block held, 0 if none. */
+	bool dirty;                         /* Changed since read. */
+	disk_sector_t entries[INDEX_CNT];   /* Data or index sectors, 0 for
+	                                       a hole. */
+};
+#endif
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ *
+ * A sector number of 0 in the index stands for a hole: sectors never
+ * written, which have no disk space and read as zeros. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
+#ifdef EFILESYS
+	cluster_t start;                    /* First data cluster, 0 if none.
+	                                       Past the end of the chain,
+	                                       the file is a hole. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
 	uint32_t unused[125];               /* Not used. */
+#else
+	off_t length;                       /* File size in bytes. */
+	unsigned magic;                     /* Magic number. */
+	disk_sector_t direct[DIRECT_CNT];   /* First data sectors. */
+	disk_sector_t indirect;             /* Index block of the next ones. */
+	disk_sector_t doubly_indirect;      /* Index block of index blocks. */
+	uint32_t unused;                    /* Not used. */
+#endif
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -26,6 +78,29 @@ bytes_to_sectors (off_t size) {
 	return DIV_ROUND_UP (size, DISK_SECTOR_SIZE);
 }
 
+#ifdef EFILESYS
+/* Every CHAIN_STRIDE-th cluster of an open inode's chain is
+ * remembered by chain_lookup(). */
+#define CHAIN_STRIDE 32
+
+/* Cached positions within an inode's cluster chain. */
+struct chain_cache {
+	size_t cur_idx;                     /* Index of CUR_CLST in chain. */
+	cluster_t cur_clst;                 /* Last cluster looked up, or 0. */
+	cluster_t *ckpts;                   /* ckpts[i] is cluster i*STRIDE. */
+	size_t ckpt_cnt;                    /* Number of valid checkpoints. */
+	size_t ckpt_cap;                    /* Allocated checkpoint slots. */
+};
+#endif
+
+/* A sector of data written in delayed-allocation mode that has not
+ * been given a place on disk yet. */
+struct pending_sector {
+	struct list_elem elem;              /* Element in inode's PENDING. */
+	size_t idx;                         /* Sector index within the file. */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Sector contents. */
+};
+
 /* In-memory inode. */
 struct inode {
 	struct list_elem elem;              /* Element in inode list. */
@@ -33,20 +108,593 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	unsigned gen;                       /* Changes on every write. */
 	struct inode_disk data;             /* Inode content. */
+	bool dirty;                         /* DATA changed since read. */
+	bool journaled;                     /* Holds metadata: data sectors go
+	                                       through the journal. */
+	size_t map_cnt;                     /* No data at or past this index. */
+	size_t prealloc;                    /* Size of next reservation window. */
+	struct list pending;                /* Delayed-allocation sectors. */
+	size_t pending_cnt;                 /* Number of elements in PENDING. */
+#ifdef EFILESYS
+	struct chain_cache chain;           /* Cluster positions in the chain. */
+#else
+	struct index_buf *indirect;         /* Single-indirect block. */
+	struct index_buf *doubly_indirect;  /* Doubly-indirect block. */
+	struct index_buf *leaf;             /* Last block it points to used. */
+#endif
 };
 
-/* Returns the disk sector that contains byte offset POS within
- * INODE.
- * Returns -1 if INODE does not contain data for a byte at offset
- * POS. */
+/* True to choose disk sectors for written data only when it is
+ * flushed, instead of at write time (kernel option -delalloc). */
+bool inode_delalloc;
+
+/* Sectors buffered by all inodes in delayed-allocation mode.  Free
+ * space is held back for them so that a flush cannot fail. */
+static size_t delalloc_reserved;
+
+#ifdef EFILESYS
+/* Returns the cluster holding cluster index IDX of INODE's chain.
+ *
+ * Walking a FAT chain from its head costs one link per cluster, so
+ * every open inode remembers where it last stopped (the cursor) and
+ * the cluster at every CHAIN_STRIDE-th index it has passed (the
+ * checkpoints).  A lookup then starts from whichever of the two is
+ * closest below IDX and follows fewer than CHAIN_STRIDE links for
+ * any position seen before. */
+static cluster_t
+chain_lookup (struct inode *inode, size_t idx) {
+	struct chain_cache *cc = &inode->chain;
+	size_t pos;
+	cluster_t clst;
+
+	/* Start from the closest known position at or below IDX. */
+	pos = 0;
+	clst = inode->data.start;
+	if (cc->ckpt_cnt > 0) {
+		size_t k = idx / CHAIN_STRIDE;
+		if (k >= cc->ckpt_cnt)
+			k = cc->ckpt_cnt - 1;
+		pos = k * CHAIN_STRIDE;
+		clst = cc->ckpts[k];
+	}
+	if (cc->cur_clst != 0 && cc->cur_idx <= idx && cc->cur_idx > pos) {
+		pos = cc->cur_idx;
+		clst = cc->cur_clst;
+	}
+
+	while (clst != 0 && clst != EOChain) {
+		if (pos % CHAIN_STRIDE == 0 && pos / CHAIN_STRIDE == cc->ckpt_cnt) {
+			if (cc->ckpt_cnt == cc->ckpt_cap) {
+				size_t cap = cc->ckpt_cap ? cc->ckpt_cap * 2 : 8;
+				cluster_t *ckpts = realloc (cc->ckpts, cap * sizeof *ckpts);
+				if (ckpts != NULL) {
+					cc->ckpts = ckpts;
+					cc->ckpt_cap = cap;
+				}
+			}
+			if (cc->ckpt_cnt < cc->ckpt_cap)
+				cc->ckpts[cc->ckpt_cnt++] = clst;
+		}
+		if (pos == idx)
+			break;
+		clst = fat_get (clst);
+		pos++;
+	}
+	if (clst == 0 || clst == EOChain)
+		return 0;
+
+	cc->cur_idx = idx;
+	cc->cur_clst = clst;
+	return clst;
+}
+
+/* Forgets every cached position of INODE's chain. */
+static void
+chain_invalidate (struct inode *inode) {
+	free (inode->chain.ckpts);
+	memset (&inode->chain, 0, sizeof inode->chain);
+}
+#endif
+
+#ifndef EFILESYS
+/* Writes index block BUF back to disk if it changed. */
+static void
+index_sync (struct index_buf *buf) {
+	if (buf != NULL && buf->dirty) {
+		journal_write (buf->sector, buf->entries);
+		buf->dirty = false;
+	}
+}
+
+/* Writes back every changed index block INODE holds. */
+static void
+index_sync_all (struct inode *inode) {
+	index_sync (inode->indirect);
+	index_sync (inode->doubly_indirect);
+	index_sync (inode->leaf);
+}
+
+/* Makes *BUFP hold index block SECTOR, writing back the block it
+ * held before.  Returns false if memory runs out. */
+static bool
+index_load (struct index_buf **bufp, disk_sector_t sector) {
+	struct index_buf *buf = *bufp;
+
+	if (buf == NULL) {
+		buf = *bufp = malloc (sizeof *buf);
+		if (buf == NULL)
+			return false;
+		buf->sector = 0;
+		buf->dirty = false;
+	}
+	if (buf->sector != sector) {
+		index_sync (buf);
+		journal_read (sector, buf->entries);
+		buf->sector = sector;
+	}
+	return true;
+}
+
+/* Drops index block SECTOR from BUF without writing it back. */
+static void
+index_forget (struct index_buf *buf, disk_sector_t sector) {
+	if (buf != NULL && buf->sector == sector) {
+		buf->sector = 0;
+		buf->dirty = false;
+	}
+}
+
+/* Makes sure *SLOTP names an index block.  If it is 0 and GOALP is
+ * nonnull, allocates a zeroed block as close to *GOALP as possible,
+ * stores it in *SLOTP, sets *DIRTYP and moves *GOALP past it.
+ * Returns false if there is no block. */
+static bool
+index_ensure (disk_sector_t *slotp, bool *dirtyp, disk_sector_t *goalp) {
+	static const disk_sector_t zeros[INDEX_CNT];
+	disk_sector_t sector;
+
+	if (*slotp != 0)
+		return true;
+	if (goalp == NULL || free_map_allocate_near (*goalp, 1, &sector) == 0)
+		return false;
+	journal_write (sector, zeros);
+	*slotp = sector;
+	*dirtyp = true;
+	*goalp = sector + 1;
+	return true;
+}
+
+/* Returns the slot that holds the disk sector of data sector IDX of
+ * INODE, either in the inode or in a cached index block, and points
+ * *DIRTYP at the flag to set after changing it.
+ *
+ * The first DIRECT_CNT sectors are found in the inode, the next
+ * INDEX_CNT through the single-indirect block, and the rest through
+ * the doubly-indirect block, so any sector is at most two index
+ * blocks away, and those are usually cached.  A missing index block
+ * is created near *GOALP if GOALP is nonnull; otherwise, or if the
+ * disk or memory runs out, returns a null pointer. */
+static disk_sector_t *
+index_slot (struct inode *inode, size_t idx, bool **dirtyp,
+		disk_sector_t *goalp) {
+	struct inode_disk *d = &inode->data;
+	struct index_buf *top;
+	disk_sector_t *leafp;
+
+	if (idx < DIRECT_CNT) {
+		*dirtyp = &inode->dirty;
+		return &d->direct[idx];
+	}
+	idx -= DIRECT_CNT;
+
+	if (idx < INDEX_CNT) {
+		if (!index_ensure (&d->indirect, &inode->dirty, goalp)
+				|| !index_load (&inode->indirect, d->indirect))
+			return NULL;
+		*dirtyp = &inode->indirect->dirty;
+		return &inode->indirect->entries[idx];
+	}
+	idx -= INDEX_CNT;
+
+	if (idx >= INDEX_CNT * INDEX_CNT
+			|| !index_ensure (&d->doubly_indirect, &inode->dirty, goalp)
+			|| !index_load (&inode->doubly_indirect, d->doubly_indirect))
+		return NULL;
+	top = inode->doubly_indirect;
+	leafp = &top->entries[idx / INDEX_CNT];
+	if (!index_ensure (leafp, &top->dirty, goalp)
+			|| !index_load (&inode->leaf, *leafp))
+		return NULL;
+	*dirtyp = &inode->leaf->dirty;
+	return &inode->leaf->entries[idx % INDEX_CNT];
+}
+#endif
+
+/* Returns the disk sector holding sector IDX of INODE's data, or 0
+ * if IDX lies in a hole. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
-	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
+lookup_sector (struct inode *inode, size_t idx) {
+	if (idx >= inode->map_cnt)
+		return 0;
+#ifdef EFILESYS
+	cluster_t clst = chain_lookup (inode, idx / SECTORS_PER_CLUSTER);
+	if (clst == 0)
+		return 0;
+	return cluster_to_sector (clst) + idx % SECTORS_PER_CLUSTER;
+#else
+	disk_sector_t *slot;
+	bool *dirty;
+
+	slot = index_slot (inode, idx, &dirty, NULL);
+	return slot != NULL ? *slot : 0;
+#endif
+}
+
+/* Returns a sector index of INODE's data at and past which no
+ * sector is allocated. */
+static size_t
+count_mapped (struct inode *inode) {
+#ifdef EFILESYS
+	size_t cnt = 0;
+	cluster_t clst;
+
+	for (clst = inode->data.start; clst != 0 && clst != EOChain;
+			clst = fat_get (clst))
+		cnt += SECTORS_PER_CLUSTER;
+
+	/* Walk the chain once through the cache as well, so that every
+	 * later lookup starts from a checkpoint fewer than CHAIN_STRIDE
+	 * links away, however far into the file it is. */
+	if (cnt > 0)
+		chain_lookup (inode, cnt / SECTORS_PER_CLUSTER - 1);
+	return cnt;
+#else
+	/* Preallocated sectors past end of file are given back when the
+	 * file is closed, so nothing lies past it. */
+	return bytes_to_sectors (inode->data.length);
+#endif
+}
+
+#ifdef EFILESYS
+/* Allocates disk sectors for up to CNT sectors of INODE's data from
+ * sector index IDX on, which must not be allocated yet, and returns
+ * how many were allocated: 0 only if the disk is full.
+ *
+ * A cluster chain cannot describe a hole in the middle of a file,
+ * so the clusters between the end of the chain and IDX are
+ * allocated and zeroed as well.  New clusters go right after the
+ * chain's last one whenever that is free. */
+static size_t
+allocate_at (struct inode *inode, size_t idx, size_t cnt) {
+	static const uint8_t zeros[DISK_SECTOR_SIZE];
+	size_t end = idx + cnt;
+	cluster_t tail = 0;
+
+	ASSERT (idx >= inode->map_cnt);
+
+	if (inode->map_cnt > 0)
+		tail = chain_lookup (inode, inode->map_cnt / SECTORS_PER_CLUSTER - 1);
+	while (inode->map_cnt < end) {
+		cluster_t clst = fat_create_chain (tail);
+		size_t i;
+
+		if (clst == 0)
+			break;
+		if (tail == 0)
+			inode->data.start = clst;
+		for (i = 0; i < SECTORS_PER_CLUSTER; i++)
+			if (inode->map_cnt + i < idx)
+				disk_write (filesys_disk, cluster_to_sector (clst) + i, zeros);
+		tail = clst;
+		inode->map_cnt += SECTORS_PER_CLUSTER;
+		inode->dirty = true;
+	}
+	return inode->map_cnt > idx ? inode->map_cnt - idx : 0;
+}
+
+/* Releases the data sectors of INODE from sector index KEEP on. */
+static void
+release_from (struct inode *inode, size_t keep) {
+	size_t keep_clst = DIV_ROUND_UP (keep, SECTORS_PER_CLUSTER);
+
+	if (inode->map_cnt <= keep_clst * SECTORS_PER_CLUSTER)
+		return;
+	if (keep_clst == 0) {
+		fat_remove_chain (inode->data.start, 0);
+		inode->data.start = 0;
+	} else {
+		cluster_t last = chain_lookup (inode, keep_clst - 1);
+		fat_remove_chain (fat_get (last), last);
+	}
+	chain_invalidate (inode);
+	inode->map_cnt = keep_clst * SECTORS_PER_CLUSTER;
+	inode->dirty = true;
+}
+#else
+/* Allocates disk sectors for up to CNT sectors of INODE's data from
+ * sector index IDX on, which must lie in a hole, and returns how
+ * many were allocated: 0 only if the disk is full.  Allocation stops
+ * at the first sector that is already allocated.
+ *
+ * The sectors are placed right after the data sector before IDX,
+ * so a file filled in order stays one run, while other files
+ * growing at the same time are laid out elsewhere.  Index blocks
+ * the run needs are allocated first, so they sit in front of the
+ * run instead of splitting it. */
+static size_t
+allocate_at (struct inode *inode, size_t idx, size_t cnt) {
+	disk_sector_t goal = inode->sector + 1, prev, start;
+	disk_sector_t *slot;
+	bool *dirty;
+	size_t got = 0, i;
+
+	if (idx >= INODE_SECTOR_CNT)
+		return 0;
+	if (cnt > INODE_SECTOR_CNT - idx)
+		cnt = INODE_SECTOR_CNT - idx;
+	if (idx > 0 && (prev = lookup_sector (inode, idx - 1)) != 0)
+		goal = prev + 1;
+
+	for (i = 0; i < cnt; i++) {
+		slot = index_slot (inode, idx + i, &dirty, &goal);
+		if (slot == NULL || *slot != 0)
+			break;
+	}
+	if (i > 0)
+		got = free_map_allocate_near (goal, i, &start);
+	for (i = 0; i < got; i++) {
+		slot = index_slot (inode, idx + i, &dirty, NULL);
+		*slot = start + i;
+		*dirty = true;
+	}
+	if (idx + got > inode->map_cnt)
+		inode->map_cnt = idx + got;
+	index_sync_all (inode);
+	return got;
+}
+
+/* Releases the data sectors of INODE from sector index KEEP on, and
+ * the index blocks that no longer map anything. */
+static void
+release_from (struct inode *inode, size_t keep) {
+	struct inode_disk *d = &inode->data;
+	disk_sector_t run_start = 0;
+	size_t run_len = 0, idx;
+
+	if (inode->map_cnt <= keep)
+		return;
+
+	/* Free data sectors, coalescing consecutive ones. */
+	for (idx = keep; idx < inode->map_cnt; idx++) {
+		bool *dirty;
+		disk_sector_t *slot = index_slot (inode, idx, &dirty, NULL);
+
+		if (slot == NULL || *slot == 0)
+			continue;
+		if (run_len > 0 && run_start + run_len == *slot)
+			run_len++;
+		else {
+			if (run_len > 0)
+				free_map_release (run_start, run_len);
+			run_start = *slot;
+			run_len = 1;
+		}
+		*slot = 0;
+		*dirty = true;
+	}
+	if (run_len > 0)
+		free_map_release (run_start, run_len);
+
+	/* Free index blocks past KEEP. */
+	if (d->doubly_indirect != 0
+			&& index_load (&inode->doubly_indirect, d->doubly_indirect)) {
+		struct index_buf *top = inode->doubly_indirect;
+		size_t first = 0, k;
+
+		if (keep > DIRECT_CNT + INDEX_CNT)
+			first = DIV_ROUND_UP (keep - DIRECT_CNT - INDEX_CNT, INDEX_CNT);
+		for (k = first; k < INDEX_CNT; k++)
+			if (top->entries[k] != 0) {
+				index_forget (inode->leaf, top->entries[k]);
+				free_map_release (top->entries[k], 1);
+				top->entries[k] = 0;
+				top->dirty = true;
+			}
+		if (first == 0) {
+			index_forget (top, d->doubly_indirect);
+			free_map_release (d->doubly_indirect, 1);
+			d->doubly_indirect = 0;
+		}
+	}
+	if (keep <= DIRECT_CNT && d->indirect != 0) {
+		index_forget (inode->indirect, d->indirect);
+		free_map_release (d->indirect, 1);
+		d->indirect = 0;
+	}
+
+	inode->map_cnt = keep;
+	inode->dirty = true;
+	index_sync_all (inode);
+}
+#endif
+
+/* Returns true if CNT more sectors can be allocated without using
+ * space held back for delayed allocation. */
+static bool
+space_available (size_t cnt) {
+	size_t free_cnt;
+
+	if (delalloc_reserved == 0)
+		return true;
+#ifdef EFILESYS
+	free_cnt = fat_free_cnt () * SECTORS_PER_CLUSTER;
+#else
+	free_cnt = free_map_free_cnt ();
+#endif
+	return free_cnt >= delalloc_reserved + cnt;
+}
+
+/* Allocates disk sectors for a write to up to CNT sectors of INODE
+ * from the unallocated sector IDX on, and returns how many were
+ * allocated for the write.
+ *
+ * Allocating one sector per write would interleave files that grow
+ * at the same time, so a write that appends to the file also
+ * reserves a window of sectors beyond it.  Later appends land in
+ * the window without touching the allocator, and the part left
+ * unused is given back when the file is last closed. */
+static size_t
+allocate_for_write (struct inode *inode, size_t idx, size_t cnt) {
+	size_t eof = bytes_to_sectors (inode->data.length);
+	size_t want = cnt, got;
+
+	if (!space_available (cnt))
+		return 0;
+	if (idx <= eof && idx + cnt > eof) {
+		if (space_available (cnt + inode->prealloc))
+			want += inode->prealloc;
+		if (inode->prealloc < PREALLOC_MAX)
+			inode->prealloc *= 2;
+	}
+	got = allocate_at (inode, idx, want);
+	return got < cnt ? got : cnt;
+}
+
+/* Returns true if writes to holes in INODE are buffered for delayed
+ * allocation.  Metadata, such as the free map that is written while
+ * sectors are being allocated, always gets its space right away. */
+static bool
+delalloc_enabled (const struct inode *inode) {
+	return inode_delalloc && !inode->journaled;
+}
+
+/* Returns how many of the CNT data sectors of INODE from index IDX
+ * on, the first of which is at disk sector SECTOR, follow each
+ * other on disk.  Sectors of a journaled inode are taken one at a
+ * time. */
+static size_t
+contiguous_cnt (struct inode *inode, size_t idx, disk_sector_t sector,
+		size_t cnt) {
+	size_t n = 1;
+
+	if (inode->journaled)
+		return 1;
+	while (n < cnt && lookup_sector (inode, idx + n) == sector + n)
+		n++;
+	return n;
+}
+
+/* Reads data sector SECTOR of INODE into BUF. */
+static void
+data_read (const struct inode *inode, disk_sector_t sector, void *buf) {
+	if (inode->journaled)
+		journal_read (sector, buf);
+	else
+		disk_read (filesys_disk, sector, buf);
+}
+
+/* Writes BUF to data sector SECTOR of INODE. */
+static void
+data_write (const struct inode *inode, disk_sector_t sector,
+		const void *buf) {
+	if (inode->journaled)
+		journal_write (sector, buf);
 	else
-		return -1;
+		disk_write (filesys_disk, sector, buf);
+}
+
+/* Returns INODE's delayed-allocation sector with index IDX, or a
+ * null pointer if there is none. */
+static struct pending_sector *
+pending_find (struct inode *inode, size_t idx) {
+	struct list_elem *e;
+
+	for (e = list_begin (&inode->pending); e != list_end (&inode->pending);
+			e = list_next (e)) {
+		struct pending_sector *p = list_entry (e, struct pending_sector, elem);
+		if (p->idx == idx)
+			return p;
+	}
+	return NULL;
+}
+
+/* Frees delayed-allocation sector P of INODE. */
+static void
+pending_free (struct inode *inode, struct pending_sector *p) {
+	list_remove (&p->elem);
+	free (p);
+	inode->pending_cnt--;
+	delalloc_reserved--;
+}
+
+/* Discards INODE's delayed-allocation sectors. */
+static void
+pending_discard (struct inode *inode) {
+	while (!list_empty (&inode->pending))
+		pending_free (inode, list_entry (list_front (&inode->pending),
+					struct pending_sector, elem));
+}
+
+/* Gives INODE's delayed-allocation sectors their places on disk
+ * and writes them out.  Each run of consecutive buffered sectors is
+ * allocated with one request, so it lands in as few runs as the
+ * free space allows.  Returns false, keeping what could not be
+ * placed buffered, if the disk or the inode's mapping is full. */
+static bool
+pending_flush (struct inode *inode) {
+	while (!list_empty (&inode->pending)) {
+		struct pending_sector *p;
+		struct list_elem *e;
+		size_t first = SIZE_MAX, cnt, got, i;
+
+		/* Find the first run of consecutive buffered sectors. */
+		for (e = list_begin (&inode->pending); e != list_end (&inode->pending);
+				e = list_next (e)) {
+			p = list_entry (e, struct pending_sector, elem);
+			if (p->idx < first)
+				first = p->idx;
+		}
+		for (cnt = 1; pending_find (inode, first + cnt) != NULL; cnt++)
+			continue;
+
+		/* The space is held back in DELALLOC_RESERVED; release it
+		 * for this run. */
+		delalloc_reserved -= cnt;
+		got = allocate_at (inode, first, cnt);
+		delalloc_reserved += cnt;
+		if (got == 0)
+			return false;
+
+		for (i = 0; i < got; i++) {
+			p = pending_find (inode, first + i);
+			disk_write (filesys_disk, lookup_sector (inode, first + i), p->data);
+			pending_free (inode, p);
+		}
+	}
+	return true;
+}
+
+/* Returns INODE's delayed-allocation sector with index IDX,
+ * creating a zeroed one if needed.  Returns a null pointer if
+ * memory or disk space runs out, or if INODE already buffers
+ * DELALLOC_MAX sectors. */
+static struct pending_sector *
+pending_get (struct inode *inode, size_t idx) {
+	struct pending_sector *p = pending_find (inode, idx);
+
+	if (p == NULL && inode->pending_cnt < DELALLOC_MAX
+			&& space_available (1)) {
+		p = calloc (1, sizeof *p);
+		if (p != NULL) {
+			p->idx = idx;
+			list_push_back (&inode->pending, &p->elem);
+			inode->pending_cnt++;
+			delalloc_reserved++;
+		}
+	}
+	return p;
 }
 
 /* List of open inodes, so that opening a single inode twice
@@ -59,6 +707,26 @@ inode_init (void) {
 	list_init (&open_inodes);
 }
 
+/* Writes the delayed-allocation data and changed metadata of every
+ * open inode to disk, giving back preallocated sectors past end of
+ * file on the way. */
+void
+inode_done (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
+			e = list_next (e)) {
+		struct inode *inode = list_entry (e, struct inode, elem);
+
+		pending_flush (inode);
+		release_from (inode, bytes_to_sectors (inode->data.length));
+		if (inode->dirty) {
+			journal_write (inode->sector, &inode->data);
+			inode->dirty = false;
+		}
+	}
+}
+
 /* Initializes an inode with LENGTH bytes of data and
  * writes the new inode to sector SECTOR on the file system
  * disk.
@@ -75,23 +743,15 @@ inode_create (disk_sector_t sector, off_t length) {
 	 * one sector in size, and you should fix that. */
 	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
 
+	/* The new inode maps no data: all LENGTH bytes are a hole, which
+	 * reads as zeros and gets disk space on first write. */
 	disk_inode = calloc (1, sizeof *disk_inode);
 	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
+		journal_write (sector, disk_inode);
 		free (disk_inode);
+		success = true;
 	}
 	return success;
 }
@@ -125,7 +785,19 @@ inode_open (disk_sector_t sector) {
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	inode->gen = 0;
+	inode->dirty = false;
+	inode->journaled = false;
+	inode->prealloc = PREALLOC_MIN;
+	list_init (&inode->pending);
+	inode->pending_cnt = 0;
+#ifdef EFILESYS
+	memset (&inode->chain, 0, sizeof inode->chain);
+#else
+	inode->indirect = inode->doubly_indirect = inode->leaf = NULL;
+#endif
+	journal_read (inode->sector, &inode->data);
+	inode->map_cnt = count_mapped (inode);
 	return inode;
 }
 
@@ -137,6 +809,22 @@ inode_reopen (struct inode *inode) {
 	return inode;
 }
 
+/* Marks INODE as holding file system metadata, such as a directory
+ * or the free map, whose changes must go through the journal. */
+void
+inode_set_journaled (struct inode *inode) {
+	inode->journaled = true;
+}
+
+/* Returns INODE's generation, a number that changes whenever
+ * INODE is written to or removed.  Whoever keeps something derived
+ * from INODE's contents can compare generations to tell whether it
+ * is still current. */
+unsigned
+inode_generation (const struct inode *inode) {
+	return inode->gen;
+}
+
 /* Returns INODE's inode number. */
 disk_sector_t
 inode_get_inumber (const struct inode *inode) {
@@ -156,14 +844,36 @@ inode_close (struct inode *inode) {
 	if (--inode->open_cnt == 0) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
+		journal_begin ();
 
-		/* Deallocate blocks if removed. */
 		if (inode->removed) {
+			/* Deallocate blocks if removed. */
+			pending_discard (inode);
+			release_from (inode, 0);
+#ifdef EFILESYS
+			fat_remove_chain (sector_to_cluster (inode->sector), 0);
+#else
 			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+#endif
+		} else {
+			/* Write out buffered data, give back the unused part of
+			 * the preallocation window and save the inode.  Data that
+			 * still finds no space is lost. */
+			if (!pending_flush (inode))
+				pending_discard (inode);
+			release_from (inode, bytes_to_sectors (inode->data.length));
+			if (inode->dirty)
+				journal_write (inode->sector, &inode->data);
 		}
+		journal_end ();
 
+#ifdef EFILESYS
+		chain_invalidate (inode);
+#else
+		free (inode->indirect);
+		free (inode->doubly_indirect);
+		free (inode->leaf);
+#endif
 		free (inode); 
 	}
 }
@@ -174,6 +884,7 @@ void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
 	inode->removed = true;
+	inode->gen++;
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -187,7 +898,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		disk_sector_t sector_idx = lookup_sector (inode,
+				offset / DISK_SECTOR_SIZE);
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
@@ -200,9 +912,27 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+		if (sector_idx == 0) {
+			/* No disk sector yet: the data is still buffered for
+			 * delayed allocation, or was never written. */
+			struct pending_sector *p = pending_find (inode,
+					offset / DISK_SECTOR_SIZE);
+			if (p != NULL)
+				memcpy (buffer + bytes_read, p->data + sector_ofs, chunk_size);
+			else
+				memset (buffer + bytes_read, 0, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+			/* Read full sectors directly into caller's buffer, all
+			 * that lie next to each other on disk in one go. */
+			off_t left = size < inode_left ? size : inode_left;
+			size_t cnt = contiguous_cnt (inode, offset / DISK_SECTOR_SIZE,
+					sector_idx, left / DISK_SECTOR_SIZE);
+			if (cnt > 1)
+				disk_read_multiple (filesys_disk, sector_idx,
+						buffer + bytes_read, cnt);
+			else
+				data_read (inode, sector_idx, buffer + bytes_read);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
@@ -211,7 +941,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 				if (bounce == NULL)
 					break;
 			}
-			disk_read (filesys_disk, sector_idx, bounce);
+			data_read (inode, sector_idx, bounce);
 			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
 		}
 
@@ -227,37 +957,83 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the disk or memory runs out.  A write past end
+ * of file extends the inode; the bytes between the old end of file
+ * and OFFSET are left as a hole that reads as zeros. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
 	uint8_t *bounce = NULL;
+	size_t old_sectors = bytes_to_sectors (inode->data.length);
+	size_t fresh_start = 0, fresh_end = 0;
 
 	if (inode->deny_write_cnt)
 		return 0;
+	inode->gen++;
+	journal_begin ();
+
+	/* Preallocated sectors that a write past end of file skips over
+	 * become part of the file, so they must read as zeros. */
+	if (size > 0 && (size_t) offset / DISK_SECTOR_SIZE > old_sectors) {
+		static const uint8_t zeros[DISK_SECTOR_SIZE];
+		size_t idx;
+
+		for (idx = old_sectors; idx < (size_t) offset / DISK_SECTOR_SIZE
+				&& idx < inode->map_cnt; idx++) {
+			disk_sector_t sector = lookup_sector (inode, idx);
+			if (sector != 0)
+				data_write (inode, sector, zeros);
+		}
+	}
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		size_t idx = offset / DISK_SECTOR_SIZE;
+		disk_sector_t sector_idx;
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
-		/* Bytes left in inode, bytes left in sector, lesser of the two. */
-		off_t inode_left = inode_length (inode) - offset;
+		/* Bytes left in sector. */
 		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
-		int min_left = inode_left < sector_left ? inode_left : sector_left;
 
 		/* Number of bytes to actually write into this sector. */
-		int chunk_size = size < min_left ? size : min_left;
-		if (chunk_size <= 0)
-			break;
+		int chunk_size = size < sector_left ? size : sector_left;
+
+		/* Flushing may allocate this sector, so it goes first. */
+		if (inode->pending_cnt >= DELALLOC_MAX)
+			pending_flush (inode);
+		sector_idx = lookup_sector (inode, idx);
+
+		if (sector_idx == 0 && !delalloc_enabled (inode)) {
+			/* First write to a hole: allocate the sectors this
+			 * write covers. */
+			size_t cnt = bytes_to_sectors (offset + size) - idx;
+			fresh_start = idx;
+			fresh_end = idx + allocate_for_write (inode, idx, cnt);
+			if (fresh_end == idx)
+				break;
+			sector_idx = lookup_sector (inode, idx);
+		}
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
+		if (sector_idx == 0) {
+			/* Delayed allocation: keep the sector in memory until
+			 * the inode is flushed. */
+			struct pending_sector *p = pending_get (inode, idx);
+			if (p == NULL)
+				break;
+			memcpy (p->data + sector_ofs, buffer + bytes_written, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+			/* Write full sectors directly to disk, all that lie next
+			 * to each other on disk in one go. */
+			size_t cnt = contiguous_cnt (inode, idx, sector_idx,
+					size / DISK_SECTOR_SIZE);
+			if (cnt > 1)
+				disk_write_multiple (filesys_disk, sector_idx,
+						buffer + bytes_written, cnt);
+			else
+				data_write (inode, sector_idx, buffer + bytes_written);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* We need a bounce buffer. */
 			if (bounce == NULL) {
@@ -268,13 +1044,17 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
 			/* If the sector contains data before or after the chunk
 			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
+			   first.  Otherwise we start with a sector of all zeros.
+			   Sectors just allocated, and preallocated sectors past
+			   the old end of file, hold no data yet. */
+			if ((sector_ofs > 0 || chunk_size < sector_left)
+					&& idx < old_sectors
+					&& !(idx >= fresh_start && idx < fresh_end))
+				data_read (inode, sector_idx, bounce);
 			else
 				memset (bounce, 0, DISK_SECTOR_SIZE);
 			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
+			data_write (inode, sector_idx, bounce); 
 		}
 
 		/* Advance. */
@@ -284,9 +1064,74 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	}
 	free (bounce);
 
+	if (bytes_written > 0 && offset > inode->data.length) {
+		inode->data.length = offset;
+		inode->dirty = true;
+	}
+	journal_end ();
 	return bytes_written;
 }
 
+/* Copies SIZE bytes of INODE SRC, starting at position SRC_OFS, into
+ * INODE DST at DST_OFS, as a single file system operation.  The data
+ * passes through a kernel buffer of up to COPY_CHUNK bytes and never
+ * reaches user memory; full sectors that lie next to each other on
+ * disk move with one command each way.  Returns the number of bytes
+ * actually copied, which may be less than SIZE if end of SRC is
+ * reached or DST cannot take more.  The ranges must not overlap if
+ * SRC and DST are the same inode. */
+off_t
+inode_copy_at (struct inode *dst, off_t dst_ofs, struct inode *src,
+		off_t src_ofs, off_t size) {
+	off_t chunk = COPY_CHUNK, bytes_copied = 0;
+	uint8_t *buf;
+
+	buf = malloc (chunk);
+	if (buf == NULL) {
+		chunk = DISK_SECTOR_SIZE;
+		buf = malloc (chunk);
+		if (buf == NULL)
+			return 0;
+	}
+
+	journal_begin ();
+	while (size > 0) {
+		off_t n = size < chunk ? size : chunk;
+		off_t written;
+
+		n = inode_read_at (src, buf, n, src_ofs + bytes_copied);
+		if (n == 0)
+			break;
+		written = inode_write_at (dst, buf, n, dst_ofs + bytes_copied);
+		bytes_copied += written;
+		size -= written;
+		if (written < n)
+			break;
+	}
+	journal_end ();
+	free (buf);
+	return bytes_copied;
+}
+
+/* Writes INODE's delayed-allocation data and changed metadata to
+ * disk and commits the journal, so that everything written to INODE
+ * so far survives a crash.  Returns false if some buffered data
+ * found no place on disk. */
+bool
+inode_sync (struct inode *inode) {
+	bool success;
+
+	journal_begin ();
+	success = pending_flush (inode);
+	if (inode->dirty) {
+		journal_write (inode->sector, &inode->data);
+		inode->dirty = false;
+	}
+	journal_end ();
+	journal_flush ();
+	return success;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
@@ -311,3 +1156,32 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Returns the number of runs of consecutive disk sectors that hold
+ * INODE's data.  A file laid out in one piece has one run; holes do
+ * not count. */
+size_t
+inode_run_cnt (struct inode *inode) {
+	disk_sector_t prev = 0;
+	size_t runs = 0, idx;
+
+	for (idx = 0; idx < inode->map_cnt; idx++) {
+		disk_sector_t sector = lookup_sector (inode, idx);
+		if (sector != 0 && sector != prev + 1)
+			runs++;
+		prev = sector;
+	}
+	return runs;
+}
+
+/* Returns the number of disk sectors allocated to INODE's data,
+ * which is less than its length calls for if it has holes. */
+size_t
+inode_allocated_cnt (struct inode *inode) {
+	size_t cnt = 0, idx;
+
+	for (idx = 0; idx < inode->map_cnt; idx++)
+		if (lookup_sector (inode, idx) != 0)
+			cnt++;
+	return cnt;
+}
@@ -0,0 +1,513 @@
+#include "filesys/journal.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
+
+/* Write-ahead journal of file system metadata.
+ *
+ * Sectors that hold metadata (inodes, index blocks, directories,
+ * the free map and the FAT) are not written in place.
+ * journal_write() records the new contents in the running
+ * transaction, where a later write to the same sector replaces the
+ * earlier one.  Committing the transaction appends its sectors to
+ * the log in one sequential run, between a descriptor block naming
+ * their home locations and a commit block that seals them.  The
+ * latest committed contents reach their home locations only at a
+ * checkpoint, when the log is full or the file system shuts down,
+ * after which the log starts over.
+ *
+ * File system operations run between journal_begin() and
+ * journal_end().  A transaction is committed once no operation is
+ * in progress and it holds JOURNAL_BATCH sectors or its first change
+ * is JOURNAL_DELAY ticks old, so the metadata updates of many
+ * operations, from any number of processes, share one log write.
+ * The last operation to end commits a transaction that is due; the
+ * commit thread commits one that comes due while the file system
+ * is idle, so that no change stays in memory much longer than
+ * JOURNAL_DELAY.
+ *
+ * At boot, journal_init() replays every transaction whose commit
+ * block reached the disk.  A crash loses the transactions not yet
+ * committed, but never leaves metadata half updated.
+ *
+ * Layout of the journal region:
+ *
+ *   sector 0:       header
+ *   sectors 1...:   log: transactions, each a descriptor block, the
+ *                   sectors it names and a commit block. */
+
+#define HEADER_MAGIC 0x4c4e524a         /* "JRNL" */
+#define DESC_MAGIC 0x4353454a           /* "JESC" */
+#define COMMIT_MAGIC 0x4d4f434a         /* "JCOM" */
+
+/* Sectors of the log proper. */
+#define LOG_SECTORS (JOURNAL_SECTORS - 1)
+
+/* Most sectors one transaction can hold: what one descriptor block
+ * can name. */
+#define DESC_CNT ((DISK_SECTOR_SIZE - 3 * sizeof (uint32_t)) \
+		/ sizeof (disk_sector_t))
+
+/* A transaction is committed when it holds at least JOURNAL_BATCH
+ * sectors or is JOURNAL_DELAY ticks old. */
+#define JOURNAL_BATCH 64
+#define JOURNAL_DELAY TIMER_FREQ
+
+/* Journal header. */
+struct journal_header {
+	uint32_t magic;                     /* HEADER_MAGIC. */
+	uint32_t seq;                       /* Sequence number of the
+	                                       transaction at log start. */
+	uint8_t unused[DISK_SECTOR_SIZE - 2 * sizeof (uint32_t)];
+};
+
+/* Descriptor block, first block of a transaction in the log. */
+struct journal_desc {
+	uint32_t magic;                     /* DESC_MAGIC. */
+	uint32_t seq;                       /* Transaction sequence number. */
+	uint32_t cnt;                       /* Number of sectors logged. */
+	disk_sector_t sectors[DESC_CNT];    /* Their home locations. */
+};
+
+/* Commit block, last block of a transaction in the log. */
+struct journal_commit {
+	uint32_t magic;                     /* COMMIT_MAGIC. */
+	uint32_t seq;                       /* Transaction sequence number. */
+	uint32_t checksum;                  /* Over the descriptor and data. */
+	uint8_t unused[DISK_SECTOR_SIZE - 3 * sizeof (uint32_t)];
+};
+
+/* New contents of a metadata sector. */
+struct journal_block {
+	struct hash_elem elem;              /* Element in RUNNING or COMMITTED. */
+	disk_sector_t sector;               /* Home location. */
+	struct disk_request req;            /* Writes DATA home. */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Contents. */
+};
+
+static disk_sector_t journal_start;     /* Sector of the header. */
+static struct lock journal_lock;        /* Protects everything below. */
+static struct hash running;             /* Blocks of running transaction. */
+static struct hash committed;           /* Blocks logged, not yet home. */
+static int64_t running_since;           /* When RUNNING got its first block. */
+static struct semaphore running_sema;   /* Upped when RUNNING gets its
+                                           first block. */
+static int op_cnt;                      /* Operations in progress. */
+static uint32_t next_seq;               /* Number of running transaction. */
+static size_t log_used;                 /* Log sectors in use. */
+
+/* Scratch space, used with JOURNAL_LOCK held.  LOG_BUF holds one
+ * transaction as laid out in the log, so that it moves to or from
+ * the disk in a single command. */
+static struct journal_block key;
+static uint8_t *log_buf;
+
+/* Statistics. */
+static unsigned long long commit_cnt;   /* Transactions committed. */
+static unsigned long long logged_cnt;   /* Sectors written to the log. */
+static unsigned long long absorbed_cnt; /* Rewrites of a logged sector. */
+static unsigned long long ckpt_cnt;     /* Checkpoints. */
+
+static void checkpoint (void);
+static void commit_thread (void *);
+
+static uint64_t
+block_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct journal_block *b = hash_entry (e, struct journal_block, elem);
+	return hash_int (b->sector);
+}
+
+static bool
+block_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct journal_block *a = hash_entry (a_, struct journal_block, elem);
+	const struct journal_block *b = hash_entry (b_, struct journal_block, elem);
+	return a->sector < b->sector;
+}
+
+static void
+block_free (struct hash_elem *e, void *aux UNUSED) {
+	free (hash_entry (e, struct journal_block, elem));
+}
+
+/* Moves a block of the transaction just committed into COMMITTED,
+ * replacing the one it supersedes. */
+static void
+block_commit (struct hash_elem *e, void *aux UNUSED) {
+	struct hash_elem *old = hash_replace (&committed, e);
+	if (old != NULL)
+		block_free (old, NULL);
+}
+
+/* Returns the block for SECTOR in H, or a null pointer. */
+static struct journal_block *
+block_find (struct hash *h, disk_sector_t sector) {
+	struct hash_elem *e;
+
+	key.sector = sector;
+	e = hash_find (h, &key.elem);
+	return e != NULL ? hash_entry (e, struct journal_block, elem) : NULL;
+}
+
+/* Removes the block for SECTOR from H.  Returns true if there was
+ * one. */
+static bool
+block_drop (struct hash *h, disk_sector_t sector) {
+	struct hash_elem *e;
+
+	key.sector = sector;
+	e = hash_delete (h, &key.elem);
+	if (e != NULL)
+		block_free (e, NULL);
+	return e != NULL;
+}
+
+/* Mixes SIZE bytes at DATA into checksum SUM. */
+static uint32_t
+checksum (uint32_t sum, const void *data, size_t size) {
+	const uint32_t *p = data;
+	size_t i;
+
+	for (i = 0; i < size / sizeof *p; i++)
+		sum = sum * 31 + p[i];
+	return sum;
+}
+
+/* Writes the header: the log is empty and the next transaction is
+ * NEXT_SEQ. */
+static void
+write_header (void) {
+	static struct journal_header header;
+
+	header.magic = HEADER_MAGIC;
+	header.seq = next_seq;
+	disk_write (filesys_disk, journal_start, &header);
+}
+
+/* Appends the running transaction to the log. */
+static void
+commit (void) {
+	struct journal_desc *desc = (struct journal_desc *) log_buf;
+	struct journal_commit *cb;
+	struct hash_iterator i;
+	uint8_t *data = log_buf + DISK_SECTOR_SIZE;
+	size_t cnt = hash_size (&running);
+
+	if (cnt == 0)
+		return;
+	ASSERT (cnt <= DESC_CNT);
+	if (log_used + cnt + 2 > LOG_SECTORS)
+		checkpoint ();
+
+	memset (desc, 0, DISK_SECTOR_SIZE);
+	desc->magic = DESC_MAGIC;
+	desc->seq = next_seq;
+	hash_first (&i, &running);
+	while (hash_next (&i)) {
+		struct journal_block *b = hash_entry (hash_cur (&i),
+				struct journal_block, elem);
+		desc->sectors[desc->cnt++] = b->sector;
+		memcpy (data, b->data, DISK_SECTOR_SIZE);
+		data += DISK_SECTOR_SIZE;
+	}
+
+	cb = (struct journal_commit *) data;
+	memset (cb, 0, DISK_SECTOR_SIZE);
+	cb->magic = COMMIT_MAGIC;
+	cb->seq = next_seq;
+	cb->checksum = checksum (0, log_buf, (cnt + 1) * DISK_SECTOR_SIZE);
+	disk_write_multiple (filesys_disk, journal_start + 1 + log_used,
+			log_buf, cnt + 2);
+
+	hash_clear (&running, block_commit);
+	log_used += cnt + 2;
+	next_seq++;
+	commit_cnt++;
+	logged_cnt += cnt;
+}
+
+/* Commits the running transaction, together with whatever metadata
+ * is kept in memory until commit time. */
+static void
+commit_all (void) {
+#ifdef EFILESYS
+	fat_flush ();
+#endif
+	commit ();
+}
+
+/* Writes every committed block to its home location and empties
+ * the log.  The writes are all queued before any is waited for, so
+ * that the disk's elevator can put them in order and merge those
+ * to adjacent sectors. */
+static void
+checkpoint (void) {
+	struct hash_iterator i;
+
+	if (log_used == 0)
+		return;
+	hash_first (&i, &committed);
+	while (hash_next (&i)) {
+		struct journal_block *b = hash_entry (hash_cur (&i),
+				struct journal_block, elem);
+		disk_request_init (&b->req, filesys_disk, b->sector, b->data, 1, true);
+		disk_submit (&b->req);
+	}
+	hash_first (&i, &committed);
+	while (hash_next (&i))
+		disk_wait (&hash_entry (hash_cur (&i), struct journal_block, elem)->req);
+	hash_clear (&committed, block_free);
+	log_used = 0;
+	write_header ();
+	ckpt_cnt++;
+}
+
+/* Reads the transaction at log position POS into LOG_BUF and
+ * returns its number of sectors if it is transaction NEXT_SEQ and
+ * made it to the log completely, 0 otherwise. */
+static size_t
+read_transaction (size_t pos) {
+	struct journal_desc *desc = (struct journal_desc *) log_buf;
+	struct journal_commit *cb;
+	size_t cnt;
+
+	if (pos + 2 > LOG_SECTORS)
+		return 0;
+	disk_read (filesys_disk, journal_start + 1 + pos, desc);
+	cnt = desc->cnt;
+	if (desc->magic != DESC_MAGIC || desc->seq != next_seq
+			|| cnt == 0 || cnt > DESC_CNT || pos + cnt + 2 > LOG_SECTORS)
+		return 0;
+	disk_read_multiple (filesys_disk, journal_start + 2 + pos,
+			log_buf + DISK_SECTOR_SIZE, cnt + 1);
+	cb = (struct journal_commit *) (log_buf + (cnt + 1) * DISK_SECTOR_SIZE);
+	if (cb->magic != COMMIT_MAGIC || cb->seq != next_seq
+			|| cb->checksum != checksum (0, log_buf,
+				(cnt + 1) * DISK_SECTOR_SIZE))
+		return 0;
+	return cnt;
+}
+
+/* Writes the transactions left in the log home, in order, up to the
+ * first one that was not completely committed. */
+static void
+replay (void) {
+	static struct journal_header header;
+	struct journal_desc *desc = (struct journal_desc *) log_buf;
+	int replayed = 0;
+	size_t cnt, i;
+
+	disk_read (filesys_disk, journal_start, &header);
+	next_seq = header.magic == HEADER_MAGIC ? header.seq : 1;
+	if (header.magic == HEADER_MAGIC)
+		while ((cnt = read_transaction (log_used)) > 0) {
+			for (i = 0; i < cnt; i++)
+				disk_write (filesys_disk, desc->sectors[i],
+						log_buf + (i + 1) * DISK_SECTOR_SIZE);
+			log_used += cnt + 2;
+			next_seq++;
+			replayed++;
+		}
+
+	if (replayed > 0)
+		printf ("journal: replayed %d transactions.\n", replayed);
+	log_used = 0;
+	write_header ();
+}
+
+/* Initializes the journal kept in the JOURNAL_SECTORS sectors that
+ * start at START.  If FORMAT is true, starts with an empty log;
+ * otherwise, replays the transactions committed before the last
+ * shutdown or crash. */
+void
+journal_init (disk_sector_t start, bool format) {
+	ASSERT (sizeof (struct journal_header) == DISK_SECTOR_SIZE);
+	ASSERT (sizeof (struct journal_desc) == DISK_SECTOR_SIZE);
+	ASSERT (sizeof (struct journal_commit) == DISK_SECTOR_SIZE);
+
+	lock_init (&journal_lock);
+	sema_init (&running_sema, 0);
+	log_buf = malloc ((DESC_CNT + 2) * DISK_SECTOR_SIZE);
+	if (log_buf == NULL
+			|| !hash_init (&running, block_hash, block_less, NULL)
+			|| !hash_init (&committed, block_hash, block_less, NULL))
+		PANIC ("journal init failed");
+	journal_start = start;
+	log_used = 0;
+	op_cnt = 0;
+
+	if (format) {
+		/* A stale transaction from an earlier file system at the
+		 * start of the log must not look like the first one. */
+		static const uint8_t zeros[DISK_SECTOR_SIZE];
+		disk_write (filesys_disk, journal_start + 1, zeros);
+		next_seq = 1;
+		write_header ();
+	} else
+		replay ();
+
+	if (thread_create ("journal", PRI_DEFAULT, commit_thread, NULL)
+			== TID_ERROR)
+		PANIC ("journal init failed");
+}
+
+/* Commits each transaction once it is JOURNAL_DELAY ticks old, if
+ * no operation is in progress by then.  Otherwise the last
+ * operation to end commits it in journal_end(). */
+static void
+commit_thread (void *aux UNUSED) {
+	for (;;) {
+		int64_t wait;
+
+		sema_down (&running_sema);
+		lock_acquire (&journal_lock);
+		while (!hash_empty (&running)
+				&& (wait = JOURNAL_DELAY - timer_elapsed (running_since)) > 0) {
+			lock_release (&journal_lock);
+			timer_sleep (wait);
+			lock_acquire (&journal_lock);
+		}
+		if (op_cnt == 0 && !hash_empty (&running))
+			commit_all ();
+		lock_release (&journal_lock);
+	}
+}
+
+/* Commits all metadata changes and writes them home. */
+void
+journal_flush (void) {
+	lock_acquire (&journal_lock);
+	commit_all ();
+	checkpoint ();
+	lock_release (&journal_lock);
+}
+
+/* Flushes the journal at shutdown. */
+void
+journal_done (void) {
+	journal_flush ();
+}
+
+/* Marks the start of a file system operation.  No transaction is
+ * committed while one is in progress, so that each operation's
+ * metadata changes reach the disk all together or not at all.
+ * Operations may nest. */
+void
+journal_begin (void) {
+	lock_acquire (&journal_lock);
+	op_cnt++;
+	lock_release (&journal_lock);
+}
+
+/* Marks the end of a file system operation, committing the running
+ * transaction if it was the last one in progress and the
+ * transaction is big or old enough. */
+void
+journal_end (void) {
+	lock_acquire (&journal_lock);
+	ASSERT (op_cnt > 0);
+	if (--op_cnt == 0 && !hash_empty (&running)
+			&& (hash_size (&running) >= JOURNAL_BATCH
+				|| timer_elapsed (running_since) >= JOURNAL_DELAY))
+		commit_all ();
+	lock_release (&journal_lock);
+}
+
+/* Records DATA as the new contents of metadata sector SECTOR. */
+void
+journal_write (disk_sector_t sector, const void *data) {
+	bool held = lock_held_by_current_thread (&journal_lock);
+	struct journal_block *b;
+
+	if (!held)
+		lock_acquire (&journal_lock);
+	b = block_find (&running, sector);
+	if (b != NULL)
+		absorbed_cnt++;
+	else {
+		/* An operation too big for one transaction is split, giving
+		 * up its atomicity rather than failing. */
+		if (hash_size (&running) >= DESC_CNT)
+			commit ();
+		b = malloc (sizeof *b);
+		if (b != NULL) {
+			b->sector = sector;
+			hash_insert (&running, &b->elem);
+			if (hash_size (&running) == 1) {
+				running_since = timer_ticks ();
+				sema_up (&running_sema);
+			}
+		}
+	}
+	if (b != NULL)
+		memcpy (b->data, data, DISK_SECTOR_SIZE);
+	else {
+		/* Out of memory: write in place, after making sure the
+		 * log holds no older copy that replay could bring back. */
+		if (block_drop (&committed, sector))
+			checkpoint ();
+		disk_write (filesys_disk, sector, data);
+	}
+	if (!held)
+		lock_release (&journal_lock);
+}
+
+/* Reads metadata sector SECTOR into DATA, including changes that
+ * have not reached its home location yet. */
+void
+journal_read (disk_sector_t sector, void *data) {
+	bool held = lock_held_by_current_thread (&journal_lock);
+	struct journal_block *b;
+
+	if (!held)
+		lock_acquire (&journal_lock);
+	b = block_find (&running, sector);
+	if (b == NULL)
+		b = block_find (&committed, sector);
+	if (b != NULL)
+		memcpy (data, b->data, DISK_SECTOR_SIZE);
+	else
+		disk_read (filesys_disk, sector, data);
+	if (!held)
+		lock_release (&journal_lock);
+}
+
+/* Called when the CNT sectors starting at SECTOR are freed.  They
+ * may be reused for file data, which is written in place, so no
+ * copy of them may stay in the journal: replaying it after a crash
+ * would overwrite the new data. */
+void
+journal_forget (disk_sector_t sector, size_t cnt) {
+	bool held = lock_held_by_current_thread (&journal_lock);
+	bool logged = false;
+	size_t i;
+
+	if (!held)
+		lock_acquire (&journal_lock);
+	for (i = 0; i < cnt; i++) {
+		block_drop (&running, sector + i);
+		if (block_drop (&committed, sector + i))
+			logged = true;
+	}
+	if (logged)
+		checkpoint ();
+	if (!held)
+		lock_release (&journal_lock);
+}
+
+/* Prints journal statistics. */
+void
+journal_print_stats (void) {
+	printf ("Journal: %llu transactions, %llu sectors logged, "
+			"%llu writes absorbed, %llu checkpoints\n",
+			commit_cnt, logged_cnt, absorbed_cnt, ckpt_cnt);
+}
@@ -0,0 +1,257 @@
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Pipes.
+
+   A pipe is a ring buffer of PIPE_SIZE bytes between the processes
+   holding its write ends and those holding its read ends.  Only
+   writers advance TAIL and only readers advance HEAD, so a reader
+   and a writer work on the ring at the same time without sharing
+   a lock: each copies its bytes and then publishes them by
+   advancing its own index.  Readers take READ_LOCK among
+   themselves, and writers WRITE_LOCK, so that each side of the ring
+   has a single owner at a time even when several processes share an
+   end, as they do after fork().
+
+   A reader sleeps on READABLE only when the ring is empty, and a
+   writer on WRITABLE only when it is full.  Before sleeping, each
+   sets its WAITING flag and then looks at the ring once more; the
+   other side, after moving its index, wakes whoever has the flag
+   set.  Since the flag is set before the final look and checked
+   after the index moves, a wakeup cannot be lost.  A spurious one
+   is harmless because sleepers look at the ring again when they
+   wake.  Pintos runs on one CPU, so keeping the compiler from
+   reordering these accesses is enough.
+
+   Threads in poll() wait on POLLERS instead, which is woken along
+   with either side. */
+
+/* Bytes a pipe holds.  Must be a power of 2. */
+#define PIPE_SIZE PGSIZE
+
+/* Keeps the compiler from moving memory accesses across it. */
+#define barrier() asm volatile ("" : : : "memory")
+
+struct pipe {
+	uint8_t *buf;                       /* PIPE_SIZE bytes, one page. */
+	volatile uint32_t head;             /* Next byte to read. */
+	volatile uint32_t tail;             /* Next byte to write. */
+
+	volatile bool reader_waiting;       /* A reader sleeps on READABLE. */
+	volatile bool writer_waiting;       /* A writer sleeps on WRITABLE. */
+	struct semaphore readable;          /* Up when data arrives. */
+	struct semaphore writable;          /* Up when space frees up. */
+	struct poll_queue pollers;          /* Threads polling either end. */
+	struct lock read_lock;              /* Serializes readers. */
+	struct lock write_lock;             /* Serializes writers. */
+
+	struct lock lock;                   /* Protects the counts below. */
+	volatile int readers;               /* Open read ends. */
+	volatile int writers;               /* Open write ends. */
+};
+
+/* Creates and returns a pipe with no ends open, or a null pointer
+   if memory runs out. */
+struct pipe *
+pipe_create (void) {
+	struct pipe *p = malloc (sizeof *p);
+
+	if (p == NULL)
+		return NULL;
+	p->buf = palloc_get_page (0);
+	if (p->buf == NULL) {
+		free (p);
+		return NULL;
+	}
+	p->head = p->tail = 0;
+	p->reader_waiting = p->writer_waiting = false;
+	sema_init (&p->readable, 0);
+	sema_init (&p->writable, 0);
+	poll_queue_init (&p->pollers);
+	lock_init (&p->read_lock);
+	lock_init (&p->write_lock);
+	lock_init (&p->lock);
+	p->readers = p->writers = 0;
+	return p;
+}
+
+/* Wakes the reader sleeping on P, if any, and P's pollers. */
+static void
+wake_reader (struct pipe *p) {
+	barrier ();
+	if (p->reader_waiting) {
+		p->reader_waiting = false;
+		sema_up (&p->readable);
+	}
+	poll_queue_wake (&p->pollers);
+}
+
+/* Wakes the writer sleeping on P, if any, and P's pollers. */
+static void
+wake_writer (struct pipe *p) {
+	barrier ();
+	if (p->writer_waiting) {
+		p->writer_waiting = false;
+		sema_up (&p->writable);
+	}
+	poll_queue_wake (&p->pollers);
+}
+
+/* Opens another read end of P, or write end if WRITE_END. */
+void
+pipe_open_end (struct pipe *p, bool write_end) {
+	lock_acquire (&p->lock);
+	if (write_end)
+		p->writers++;
+	else
+		p->readers++;
+	lock_release (&p->lock);
+}
+
+/* Closes a read end of P, or write end if WRITE_END.  Closing the
+   last write end lets readers see end of file; closing the last
+   read end makes writers give up.  Frees P once no end is open. */
+void
+pipe_close_end (struct pipe *p, bool write_end) {
+	bool dead;
+
+	lock_acquire (&p->lock);
+	if (write_end) {
+		ASSERT (p->writers > 0);
+		p->writers--;
+	} else {
+		ASSERT (p->readers > 0);
+		p->readers--;
+	}
+	dead = p->readers == 0 && p->writers == 0;
+	if (!dead) {
+		/* Still under the lock, so that closing the other side's
+		   last end cannot free P meanwhile. */
+		if (write_end)
+			wake_reader (p);
+		else
+			wake_writer (p);
+	}
+	lock_release (&p->lock);
+
+	if (dead) {
+		palloc_free_page (p->buf);
+		free (p);
+	}
+}
+
+/* Reads up to SIZE bytes from P into BUFFER.  Waits until at least
+   one byte is there, then returns what is there, up to SIZE bytes.
+   Returns 0 at end of file, once the ring is empty and no write end
+   is open. */
+off_t
+pipe_read (struct pipe *p, void *buffer, off_t size) {
+	uint8_t *dst = buffer;
+	uint32_t head, avail, ofs, first;
+
+	if (size <= 0)
+		return 0;
+
+	lock_acquire (&p->read_lock);
+	head = p->head;
+	for (;;) {
+		avail = p->tail - head;
+		if (avail > 0 || p->writers == 0)
+			break;
+		p->reader_waiting = true;
+		barrier ();
+		if (p->tail != head || p->writers == 0) {
+			p->reader_waiting = false;
+			continue;
+		}
+		sema_down (&p->readable);
+	}
+	barrier ();
+
+	if (avail > (uint32_t) size)
+		avail = size;
+	ofs = head % PIPE_SIZE;
+	first = PIPE_SIZE - ofs < avail ? PIPE_SIZE - ofs : avail;
+	memcpy (dst, p->buf + ofs, first);
+	memcpy (dst + first, p->buf, avail - first);
+	barrier ();
+	p->head = head + avail;
+	lock_release (&p->read_lock);
+
+	if (avail > 0)
+		wake_writer (p);
+	return avail;
+}
+
+/* Writes SIZE bytes from BUFFER into P, waiting for room as
+   needed.  Returns the number of bytes written, which is less than
+   SIZE only if every read end is closed. */
+off_t
+pipe_write (struct pipe *p, const void *buffer, off_t size) {
+	const uint8_t *src = buffer;
+	off_t written = 0;
+
+	lock_acquire (&p->write_lock);
+	while (written < size) {
+		uint32_t tail = p->tail, room, ofs, first;
+
+		if (p->readers == 0)
+			break;
+		room = PIPE_SIZE - (tail - p->head);
+		if (room == 0) {
+			p->writer_waiting = true;
+			barrier ();
+			if (p->tail - p->head == PIPE_SIZE && p->readers > 0)
+				sema_down (&p->writable);
+			else
+				p->writer_waiting = false;
+			continue;
+		}
+		barrier ();
+
+		if (room > (uint32_t) (size - written))
+			room = size - written;
+		ofs = tail % PIPE_SIZE;
+		first = PIPE_SIZE - ofs < room ? PIPE_SIZE - ofs : room;
+		memcpy (p->buf + ofs, src + written, first);
+		memcpy (p->buf, src + written + first, room - first);
+		barrier ();
+		p->tail = tail + room;
+		written += room;
+		wake_reader (p);
+	}
+	lock_release (&p->write_lock);
+	return written;
+}
+
+/* Returns the POLL* events pending on P's read end, or its write
+   end if WRITE_END.  If E is nonnull, first puts W on P's poll
+   queue through E, to be woken when that may change. */
+int
+pipe_poll (struct pipe *p, bool write_end, struct poll_entry *e,
+		struct poll_waiter *w) {
+	int events = 0;
+
+	if (e != NULL)
+		poll_queue_add (&p->pollers, e, w);
+	barrier ();
+	if (write_end) {
+		if (p->readers == 0)
+			events |= POLLERR;
+		else if (p->tail - p->head < PIPE_SIZE)
+			events |= POLLOUT;
+	} else {
+		if (p->tail != p->head)
+			events |= POLLIN;
+		if (p->writers == 0)
+			events |= POLLHUP;
+	}
+	return events;
+}
@@ -2,7 +2,12 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <disk-stats.h>
+#include <list.h>
+#include "threads/synch.h"
 
 /* Size of a disk sector in bytes. */
 #define DISK_SECTOR_SIZE 512
@@ -15,13 +20,53 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* Most sectors one request may cover. */
+#define DISK_REQUEST_MAX 256
+
+struct disk_request;
+
+/* Called when a request submitted with disk_submit() has
+ * completed, from the channel's dispatcher thread. */
+typedef void disk_done_func (struct disk_request *, void *aux);
+
+/* A request to move sectors between a disk and memory, queued by
+ * disk_submit().  Set up with disk_request_init(). */
+struct disk_request {
+	struct list_elem elem;      /* Element in the channel's queue. */
+	struct disk *disk;          /* Disk to access. */
+	disk_sector_t sec_no;       /* First sector. */
+	size_t cnt;                 /* Number of sectors. */
+	uint8_t *buffer;            /* Kernel buffer, CNT sectors long. */
+	bool write;                 /* True to write, false to read. */
+	int64_t deadline;           /* Tick by which to start it. */
+	int64_t queued;             /* timer_usecs() when queued. */
+	int64_t started;            /* timer_usecs() when given to the
+	                               device. */
+	disk_done_func *done;       /* Completion callback, or NULL. */
+	void *aux;                  /* Passed to DONE. */
+	struct semaphore finished;  /* Up'd on completion if DONE is NULL. */
+};
+
+extern bool disk_pio;
+extern bool disk_fifo;
+
 void disk_init (void);
 void disk_print_stats (void);
+void disk_get_stats (struct disk *, struct disk_stats *);
 
 struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_read_multiple (struct disk *, disk_sector_t, void *, size_t cnt);
+void disk_write_multiple (struct disk *, disk_sector_t, const void *,
+		size_t cnt);
+
+
+void disk_request_init (struct disk_request *, struct disk *, disk_sector_t,
+		void *, size_t cnt, bool write);
+void disk_submit (struct disk_request *);
+void disk_wait (struct disk_request *);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
@@ -2,11 +2,19 @@
 #define DEVICES_INPUT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+struct poll_entry;
+struct poll_waiter;
+
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
+size_t input_read (uint8_t *, size_t size);
+int input_pending (void);
+int input_poll (struct poll_entry *, struct poll_waiter *);
+int input_set_mode (int mode);
 bool input_full (void);
 
 #endif /* devices/input.h */
@@ -36,7 +36,9 @@ struct intq {
 void intq_init (struct intq *);
 bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
+int intq_count (const struct intq *);
 uint8_t intq_getc (struct intq *);
+size_t intq_getn (struct intq *, uint8_t *, size_t size, int delim);
 void intq_putc (struct intq *, uint8_t);
 
 #endif /* devices/intq.h */
@@ -0,0 +1,42 @@
+#ifndef DEVICES_PCI_H
+#define DEVICES_PCI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A PCI function, as found by pci_find_class() or
+   pci_find_device(). */
+struct pci_dev {
+	uint8_t bus;                /* Bus number. */
+	uint8_t dev;                /* Device number on the bus. */
+	uint8_t func;               /* Function number in the device. */
+	uint16_t vendor_id;         /* Vendor ID. */
+	uint16_t device_id;         /* Device ID. */
+	uint8_t class;              /* Base class code. */
+	uint8_t subclass;           /* Subclass code. */
+	uint8_t irq;                /* Interrupt line, as set by the BIOS. */
+};
+
+/* Configuration space registers. */
+#define PCI_REG_ID 0x00             /* Device ID:Vendor ID. */
+#define PCI_REG_COMMAND 0x04        /* Status:Command. */
+#define PCI_REG_CLASS 0x08          /* Class:Subclass:Prog IF:Revision. */
+#define PCI_REG_BAR0 0x10           /* First base address register. */
+#define PCI_REG_IRQ 0x3c            /* ...:Interrupt Pin:Interrupt Line. */
+
+/* Command register bits. */
+#define PCI_CMD_IO 0x0001           /* Respond to I/O space accesses. */
+#define PCI_CMD_MEMORY 0x0002       /* Respond to memory space accesses. */
+#define PCI_CMD_MASTER 0x0004       /* May act as bus master. */
+
+bool pci_find_class (uint8_t class, uint8_t subclass, struct pci_dev *);
+bool pci_find_device (uint16_t vendor_id, uint16_t device_id,
+		struct pci_dev *);
+bool pci_find_next_device (struct pci_dev *);
+
+uint32_t pci_read_config (const struct pci_dev *, uint8_t reg);
+void pci_write_config (const struct pci_dev *, uint8_t reg, uint32_t);
+uint32_t pci_bar (const struct pci_dev *, int bar);
+void pci_enable (const struct pci_dev *, uint16_t command);
+
+#endif /* devices/pci.h */
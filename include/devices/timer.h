@@ -12,6 +12,8 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_usecs (void);
+uint64_t timer_tsc_per_tick (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
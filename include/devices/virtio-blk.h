@@ -0,0 +1,23 @@
+#ifndef DEVICES_VIRTIO_BLK_H
+#define DEVICES_VIRTIO_BLK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+#include "threads/synch.h"
+
+/* Most virtio block devices supported. */
+#define VIRTIO_BLK_CNT 4
+
+struct virtio_blk;
+
+size_t virtio_blk_init (struct virtio_blk *[VIRTIO_BLK_CNT]);
+disk_sector_t virtio_blk_capacity (const struct virtio_blk *);
+const char *virtio_blk_serial (const struct virtio_blk *);
+void virtio_blk_set_notify (struct virtio_blk *, struct semaphore *);
+
+bool virtio_blk_post (struct virtio_blk *, disk_sector_t, void *, size_t cnt,
+		bool write, void *aux);
+void *virtio_blk_reap (struct virtio_blk *, bool *ok);
+
+#endif /* devices/virtio-blk.h */
@@ -17,12 +17,14 @@ typedef uint32_t cluster_t;  /* Index of a cluster within FAT. */
 #define SECTORS_PER_CLUSTER 1 /* Number of sectors per cluster */
 #define FAT_BOOT_SECTOR 0     /* FAT boot sector. */
 #define ROOT_DIR_CLUSTER 1    /* Cluster for the root directory */
+#define JOURNAL_CLUSTER 2     /* First cluster of the metadata journal */
 
 void fat_init (void);
 void fat_open (void);
 void fat_close (void);
 void fat_create (void);
 void fat_close (void);
+void fat_flush (void);
 
 cluster_t fat_create_chain (
     cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
@@ -34,5 +36,7 @@ void fat_remove_chain (
 cluster_t fat_get (cluster_t clst);
 void fat_put (cluster_t clst, cluster_t val);
 disk_sector_t cluster_to_sector (cluster_t clst);
+cluster_t sector_to_cluster (disk_sector_t sector);
+size_t fat_free_cnt (void);
 
 #endif /* filesys/fat.h */
@@ -1,15 +1,21 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
+struct poll_entry;
+struct poll_waiter;
 
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
+struct file *file_dup (struct file *);
 void file_close (struct file *);
+bool file_open_pipe (struct file **read_end, struct file **write_end);
+bool file_is_pipe (const struct file *);
 struct inode *file_get_inode (struct file *);
 
 /* Reading and writing. */
@@ -17,6 +23,10 @@ off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
 off_t file_write (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+off_t file_copy_at (struct file *out, off_t out_ofs, struct file *in,
+		off_t in_ofs, off_t size);
+bool file_sync (struct file *);
+int file_poll (struct file *, struct poll_entry *, struct poll_waiter *);
 
 /* Preventing writes. */
 void file_deny_write (struct file *);
@@ -2,22 +2,33 @@
 #define FILESYS_INODE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 
 struct bitmap;
 
+extern bool inode_delalloc;
+
 void inode_init (void);
+void inode_done (void);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
 struct inode *inode_reopen (struct inode *);
+void inode_set_journaled (struct inode *);
 disk_sector_t inode_get_inumber (const struct inode *);
+unsigned inode_generation (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_copy_at (struct inode *dst, off_t dst_ofs,
+		struct inode *src, off_t src_ofs, off_t size);
+bool inode_sync (struct inode *);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+size_t inode_run_cnt (struct inode *);
+size_t inode_allocated_cnt (struct inode *);
 
 #endif /* filesys/inode.h */
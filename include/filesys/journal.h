@@ -0,0 +1,25 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* Sectors reserved on the file system disk for the metadata
+ * journal, its header included. */
+#define JOURNAL_SECTORS 256
+
+void journal_init (disk_sector_t start, bool format);
+void journal_done (void);
+void journal_flush (void);
+
+void journal_begin (void);
+void journal_end (void);
+
+void journal_write (disk_sector_t, const void *);
+void journal_read (disk_sector_t, void *);
+void journal_forget (disk_sector_t, size_t cnt);
+
+void journal_print_stats (void);
+
+#endif /* filesys/journal.h */
@@ -0,0 +1,19 @@
+#ifndef FILESYS_PIPE_H
+#define FILESYS_PIPE_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct pipe;
+struct poll_entry;
+struct poll_waiter;
+
+struct pipe *pipe_create (void);
+void pipe_open_end (struct pipe *, bool write_end);
+void pipe_close_end (struct pipe *, bool write_end);
+off_t pipe_read (struct pipe *, void *, off_t size);
+off_t pipe_write (struct pipe *, const void *, off_t size);
+int pipe_poll (struct pipe *, bool write_end, struct poll_entry *,
+		struct poll_waiter *);
+
+#endif /* filesys/pipe.h */
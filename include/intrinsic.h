@@ -128,4 +128,12 @@ static __inline void write_msr(uint32_t ecx, uint64_t val) {
 			:: "c" (ecx), "d" (edx), "a" (eax) );
 }
 
+/* Reads the time stamp counter. */
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return (uint64_t) hi << 32 | lo;
+}
+
 #endif /* intrinsic.h */
@@ -0,0 +1,53 @@
+#ifndef __LIB_DISK_STATS_H
+#define __LIB_DISK_STATS_H
+
+#include <stdint.h>
+
+/* Number of buckets in a latency histogram.  Bucket 0 counts
+   requests that took less than 2 us, bucket I those that took from
+   2**I us up to 2**(I+1) us, and the last bucket also all those
+   that took longer. */
+#define DISK_LATENCY_BUCKETS 24
+
+/* Statistics of a disk, kept by the kernel since boot and returned
+   by the disk_stats() system call.  Times are in microseconds.
+
+   A request's latency runs from when it is queued to when it
+   completes, and splits into the time it waits in the queue and
+   the time it spends with the device.  The time submitters wait
+   for the channel lock before they can queue requests comes on
+   top. */
+struct disk_stats {
+	int64_t read_cnt;           /* Sectors read. */
+	int64_t write_cnt;          /* Sectors written. */
+	int64_t read_bytes;         /* Bytes read. */
+	int64_t write_bytes;        /* Bytes written. */
+	int64_t request_cnt;        /* Requests served. */
+	int64_t cmd_cnt;            /* Commands, each for one or more
+	                               merged requests. */
+	int64_t seq_cnt;            /* Commands starting at the sector
+	                               after the previous one. */
+	int64_t random_cnt;         /* Other commands. */
+	int64_t seek_dist;          /* Sectors the head moved between
+	                               commands. */
+
+	int64_t lock_cnt;           /* Acquisitions of the channel lock
+	                               by submitters. */
+	int64_t lock_contended;     /* Those that found the lock held. */
+	int64_t lock_time;          /* Time spent waiting for it. */
+	int64_t queue_time;         /* Time requests spent queued. */
+	int64_t device_time;        /* Time requests spent with the
+	                               device. */
+	int64_t intr_cnt;           /* Disk interrupts waited for. */
+	int64_t intr_time;          /* Time from those interrupts to the
+	                               dispatcher running again. */
+
+	int64_t depth_sum;          /* Requests outstanding on the disk as
+	                               each request arrived, summed. */
+	int64_t depth_max;          /* Most requests outstanding at once. */
+
+	int64_t read_latency[DISK_LATENCY_BUCKETS];
+	int64_t write_latency[DISK_LATENCY_BUCKETS];
+};
+
+#endif /* lib/disk-stats.h */
@@ -0,0 +1,12 @@
+#ifndef __LIB_FUTEX_H
+#define __LIB_FUTEX_H
+
+/* Operations of the futex() system call. */
+enum futex_op {
+	FUTEX_WAIT,                 /* Sleep if *addr == val. */
+	FUTEX_WAKE,                 /* Wake up to val sleepers on addr. */
+	FUTEX_REQUEUE,              /* Wake up to val sleepers on addr and
+	                               move the rest to addr2. */
+};
+
+#endif /* lib/futex.h */
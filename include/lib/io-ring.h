@@ -0,0 +1,102 @@
+#ifndef __LIB_IO_RING_H
+#define __LIB_IO_RING_H
+
+#include <stdint.h>
+
+/* Entries in each queue of an I/O ring. */
+#define IO_RING_ENTRIES 64
+
+/* Operations a submission queue entry can ask for. */
+enum io_op {
+	IO_OP_NOP,                  /* Do nothing, complete with 0. */
+	IO_OP_READ,                 /* read (fd, addr, len). */
+	IO_OP_WRITE,                /* write (fd, addr, len). */
+	IO_OP_PREAD,                /* pread (fd, addr, len, off). */
+	IO_OP_PWRITE,               /* pwrite (fd, addr, len, off). */
+	IO_OP_OPEN,                 /* open (addr), addr naming a file. */
+	IO_OP_CLOSE,                /* close (fd). */
+	IO_OP_FSYNC,                /* Write fd's data through to disk. */
+};
+
+/* Submission queue entry: one operation for the kernel. */
+struct io_sqe {
+	uint8_t opcode;             /* One of enum io_op. */
+	uint8_t pad[3];
+	int32_t fd;                 /* File descriptor. */
+	int64_t off;                /* File offset, for PREAD and PWRITE. */
+	uint64_t addr;              /* Buffer or file name. */
+	uint32_t len;               /* Buffer length in bytes. */
+	uint32_t pad2;
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* Completion queue entry: the outcome of one operation. */
+struct io_cqe {
+	uint64_t user_data;         /* From the submission. */
+	int32_t res;                /* What the system call would have
+	                               returned. */
+	uint32_t pad;
+};
+
+/* An I/O ring, one page shared between a process and the kernel and
+   set up with io_setup().
+
+   The process fills submission queue entries and advances sq_tail;
+   io_enter() hands the entries from sq_head up to sq_tail to kernel
+   workers and advances sq_head as it takes them.  The kernel posts
+   a completion for each, in the order they finish, and advances
+   cq_tail; the process consumes completions from cq_head and
+   advances cq_head.  Each index only ever grows and is taken modulo
+   IO_RING_ENTRIES.  A process must not have more entries submitted
+   and unreaped than the completion queue holds; io_enter() stops
+   taking submissions while that many are outstanding. */
+struct io_ring {
+	volatile uint32_t sq_head;  /* Next submission the kernel takes. */
+	volatile uint32_t sq_tail;  /* Next submission the process fills. */
+	volatile uint32_t cq_head;  /* Next completion the process reads. */
+	volatile uint32_t cq_tail;  /* Next completion the kernel posts. */
+	uint32_t pad[4];
+	struct io_sqe sqes[IO_RING_ENTRIES];
+	struct io_cqe cqes[IO_RING_ENTRIES];
+};
+
+/* Keeps the compiler from moving memory accesses across it.  The
+   CPU does not reorder stores with stores or loads with loads, so
+   this is enough to order the queue entries against the indexes. */
+#define io_ring_barrier() asm volatile ("" : : : "memory")
+
+/* Returns the next free submission queue entry of RING, or a null
+   pointer if the queue is full.  Hand it to the kernel with
+   io_ring_push() once it is filled in. */
+static inline struct io_sqe *
+io_ring_get_sqe (struct io_ring *ring) {
+	if (ring->sq_tail - ring->sq_head >= IO_RING_ENTRIES)
+		return 0;
+	return &ring->sqes[ring->sq_tail % IO_RING_ENTRIES];
+}
+
+/* Makes the entry from io_ring_get_sqe() visible to the kernel. */
+static inline void
+io_ring_push (struct io_ring *ring) {
+	io_ring_barrier ();
+	ring->sq_tail++;
+}
+
+/* Returns the oldest unread completion of RING, or a null pointer
+   if there is none. */
+static inline struct io_cqe *
+io_ring_peek_cqe (struct io_ring *ring) {
+	if (ring->cq_head == ring->cq_tail)
+		return 0;
+	io_ring_barrier ();
+	return &ring->cqes[ring->cq_head % IO_RING_ENTRIES];
+}
+
+/* Frees the completion io_ring_peek_cqe() returned for reuse. */
+static inline void
+io_ring_cqe_seen (struct io_ring *ring) {
+	io_ring_barrier ();
+	ring->cq_head++;
+}
+
+#endif /* lib/io-ring.h */
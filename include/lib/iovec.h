@@ -0,0 +1,16 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+#include <stddef.h>
+
+/* Most segments one readv() or writev() call takes. */
+#define IOV_MAX 1024
+
+/* A segment of memory to read into or write from, for readv() and
+   writev(). */
+struct iovec {
+	void *iov_base;             /* First byte. */
+	size_t iov_len;             /* Length in bytes. */
+};
+
+#endif /* lib/iovec.h */
@@ -0,0 +1,24 @@
+#ifndef __LIB_POLL_H
+#define __LIB_POLL_H
+
+/* Events, for poll(). */
+#define POLLIN   0x01           /* Reading would not wait. */
+#define POLLOUT  0x04           /* Writing would not wait. */
+#define POLLERR  0x08           /* Writing would fail: a pipe's read
+                                   ends are all closed.  Always
+                                   reported. */
+#define POLLHUP  0x10           /* A pipe's write ends are all closed.
+                                   Always reported. */
+#define POLLNVAL 0x20           /* Not an open file descriptor.  Always
+                                   reported. */
+
+/* A file descriptor for poll() to watch. */
+struct pollfd {
+	int fd;                     /* File descriptor, or negative to
+	                               skip this entry. */
+	short events;               /* Events to watch for. */
+	short revents;              /* Events that occurred, set by
+	                               poll(). */
+};
+
+#endif /* lib/poll.h */
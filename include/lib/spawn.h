@@ -0,0 +1,22 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* Most file actions one spawn() call takes. */
+#define SPAWN_ACTIONS_MAX 16
+
+/* What a file action does to the child's file descriptors. */
+enum spawn_op {
+	SPAWN_CLOSE,                /* Close fd. */
+	SPAWN_DUP2,                 /* Make newfd a copy of fd, closing
+	                               whatever newfd had open first. */
+};
+
+/* A change to the file descriptors a child of spawn() inherits,
+   applied in order before the child's program starts. */
+struct spawn_action {
+	int op;                     /* One of enum spawn_op. */
+	int fd;                     /* Descriptor acted on. */
+	int newfd;                  /* Target of SPAWN_DUP2. */
+};
+
+#endif /* lib/spawn.h */
@@ -36,6 +36,24 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	SYS_DISK_STATS,             /* Report a disk's statistics. */
+	SYS_READV,                  /* Read from a file into several buffers. */
+	SYS_WRITEV,                 /* Write to a file from several buffers. */
+	SYS_PREAD,                  /* Read from a file at a given position. */
+	SYS_PWRITE,                 /* Write to a file at a given position. */
+	SYS_SENDFILE,               /* Copy a file to a file or the console. */
+	SYS_COPY_FILE_RANGE,        /* Copy part of a file to another file. */
+	SYS_IO_SETUP,               /* Set up an I/O ring. */
+	SYS_IO_ENTER,               /* Submit to and wait on an I/O ring. */
+	SYS_SPAWN,                  /* Start a program in a new process. */
+	SYS_PIPE,                   /* Create a pipe. */
+	SYS_SHM_OPEN,               /* Find or create shared memory. */
+	SYS_SHM_MAP,                /* Map shared memory. */
+	SYS_FUTEX,                  /* Sleep on or wake a futex. */
+	SYS_TTY_MODE,               /* Set the console input mode. */
+	SYS_TTY_POLL,               /* Check for console input. */
+	SYS_POLL,                   /* Wait for file descriptors. */
 };
 
 #endif /* lib/syscall-nr.h */
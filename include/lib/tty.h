@@ -0,0 +1,11 @@
+#ifndef __LIB_TTY_H
+#define __LIB_TTY_H
+
+/* Console input modes, for tty_mode(). */
+#define TTY_RAW      0x1        /* Deliver bytes as they arrive, rather
+                                   than a line at a time. */
+#define TTY_NONBLOCK 0x2        /* Reads return 0 at once when there is
+                                   nothing to deliver, instead of
+                                   waiting. */
+
+#endif /* lib/tty.h */
@@ -0,0 +1,33 @@
+#ifndef __LIB_USER_SYNC_H
+#define __LIB_USER_SYNC_H
+
+#include <stdbool.h>
+
+/* A mutex for processes that share memory.  Put it in memory that
+   all of them map, such as a shared memory segment, and initialize
+   it once with mutex_init(). */
+struct mutex {
+	int state;                  /* 0: unlocked, 1: locked,
+	                               2: locked, maybe with sleepers. */
+};
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* A condition variable, used with a mutex as in a Mesa-style
+   monitor.  Like a mutex, it has to live in shared memory, and that
+   memory must be mapped at the same address in every process that
+   uses it, as it is after fork(). */
+struct cond {
+	int seq;                    /* Bumped by every signal. */
+	struct mutex *mutex;        /* Mutex of the last waiter. */
+};
+
+void cond_init (struct cond *);
+void cond_wait (struct cond *, struct mutex *);
+void cond_signal (struct cond *);
+void cond_broadcast (struct cond *);
+
+#endif /* lib/user/sync.h */
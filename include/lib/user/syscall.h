@@ -4,6 +4,13 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <disk-stats.h>
+#include <iovec.h>
+#include <io-ring.h>
+#include <spawn.h>
+#include <futex.h>
+#include <tty.h>
+#include <poll.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -25,6 +32,8 @@ void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
 pid_t fork (const char *thread_name);
 int exec (const char *file);
+pid_t spawn (const char *cmd_line, const struct spawn_action *actions,
+		int action_cnt);
 int wait (pid_t);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
@@ -37,10 +46,27 @@ unsigned tell (int fd);
 void close (int fd);
 
 int dup2(int oldfd, int newfd);
+int pipe (int fds[2]);
+
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int sendfile (int out_fd, int in_fd, off_t *offset, unsigned count);
+int copy_file_range (int in_fd, off_t *in_offset, int out_fd,
+		off_t *out_offset, unsigned length);
+int io_setup (struct io_ring *ring);
+int io_enter (unsigned to_submit, unsigned min_complete);
 
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int shm_open (const char *name, size_t size);
+void *shm_map (int id, void *addr, bool writable);
+int futex (int *addr, int op, int val, int *addr2);
+int tty_mode (int mode);
+int tty_poll (void);
+int poll (struct pollfd *fds, int nfds, int timeout);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -50,6 +76,8 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+bool disk_stats (int chan_no, int dev_no, struct disk_stats *);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
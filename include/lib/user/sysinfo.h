@@ -0,0 +1,13 @@
+#ifndef __LIB_USER_SYSINFO_H
+#define __LIB_USER_SYSINFO_H
+
+#include <stdint.h>
+
+/* Time and statistics read from the kernel data pages, without
+   system calls. */
+int64_t sysinfo_ticks (void);
+int64_t sysinfo_usecs (void);
+int sysinfo_load_avg (void);
+void sysinfo_cpu_ticks (int64_t *user, int64_t *kernel);
+
+#endif /* lib/user/sysinfo.h */
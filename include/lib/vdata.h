@@ -0,0 +1,43 @@
+#ifndef __LIB_VDATA_H
+#define __LIB_VDATA_H
+
+#include <stdint.h>
+
+/* User addresses of the pages of kernel data that every process has
+   mapped read-only, just above its stack: the system data page,
+   shared by all processes, and then the process's own page. */
+#define VDATA_ADDR      0x47500000UL
+#define VDATA_PROC_ADDR (VDATA_ADDR + 4096)
+
+/* System data, updated by the kernel on every timer tick.
+
+   Read it as a seqlock: read SEQ, and if it is even, read the other
+   members, then read SEQ again.  If it changed, or was odd to begin
+   with, the kernel was updating the page meanwhile and the reads
+   have to be done over.  The helpers in lib/user/sysinfo.c do
+   this. */
+struct vdata {
+	volatile uint32_t seq;      /* Odd while an update is under way. */
+	uint32_t timer_freq;        /* Timer ticks per second. */
+	int64_t ticks;              /* Timer ticks since boot. */
+	uint64_t tick_tsc;          /* Time stamp counter at the last
+	                               tick. */
+	uint64_t tsc_per_tick;      /* Time stamp counter cycles per tick,
+	                               as timer_calibrate() measured them,
+	                               or 0 before it has. */
+	int32_t load_avg;           /* 100 times the load average, as of
+	                               the tick before the last. */
+	uint32_t pad;
+};
+
+/* Data of one process, updated by the kernel on every timer tick
+   that finds the process running.  Read it like struct vdata. */
+struct vdata_proc {
+	volatile uint32_t seq;      /* Odd while an update is under way. */
+	uint32_t pad;
+	int64_t user_ticks;         /* Ticks spent running user code. */
+	int64_t kernel_ticks;       /* Ticks spent in the kernel on the
+	                               process's behalf. */
+};
+
+#endif /* lib/vdata.h */
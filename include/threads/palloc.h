@@ -20,4 +20,7 @@ void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
 
+void clear_page (void *);
+void copy_page (void *dst, const void *src);
+
 #endif /* threads/palloc.h */
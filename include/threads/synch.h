@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
@@ -39,6 +40,35 @@ void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 bool cond_priority(const struct list_elem *a, const struct list_elem  *b, void *aux);
 
+/* A thread waiting for any of several poll queues to be woken. */
+struct poll_waiter {
+	struct thread *thread;      /* The waiting thread. */
+	bool woken;                 /* Set when any of its queues is woken. */
+	bool sleeping;              /* Blocked in poll_waiter_sleep(). */
+	bool timed;                 /* ...on the timer's sleep list. */
+};
+
+/* A poll waiter's place on one poll queue. */
+struct poll_entry {
+	struct list_elem elem;      /* Element in the queue's ENTRIES. */
+	struct poll_queue *queue;   /* Queue, or null if not on one. */
+	struct poll_waiter *waiter;
+};
+
+/* Waiters to be told when something, such as a pipe or the
+   console, may have become ready. */
+struct poll_queue {
+	struct list entries;        /* List of poll entries. */
+};
+
+void poll_waiter_init (struct poll_waiter *);
+bool poll_waiter_sleep (struct poll_waiter *, int64_t deadline);
+void poll_queue_init (struct poll_queue *);
+void poll_queue_add (struct poll_queue *, struct poll_entry *,
+		struct poll_waiter *);
+void poll_queue_remove (struct poll_entry *);
+void poll_queue_wake (struct poll_queue *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -6,6 +6,9 @@
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "include/threads/synch.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 #ifdef VM
 #include "vm/vm.h"
 #endif
@@ -29,10 +32,6 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
-/* Project 2: File Descriptor Table */
-#define FDT_PAGES 3
-#define FDT_SIZE (FDT_PAGES * (1<<9))
-
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -119,13 +118,12 @@ struct thread {
 	uint64_t *pml4;                     /* Page map level 4 */
 	/* Project 2 */
 	int exit_status;
-	struct file **fdt;           // file descriptor table
-	struct list child_list;      // child list
-	struct list_elem child_elem; // child list element
-	struct semaphore load_sema;  // load semaphore
-	struct semaphore wait_sema;  // wait semaphore
-	struct semaphore exit_sema;  // exit semaphore
+	struct fd_table fdt;         // file descriptor table
+	struct list children;        // exit records of children
+	struct exit_record *exit_record; // own exit record, see process.c
 	struct file *self_file;      // self file
+	struct io_ctx *io_ring;      // I/O ring, see userprog/io-ring.c
+	struct vdata_proc *vdata;    // own kernel data page, see userprog/vdata.c
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
@@ -161,6 +159,7 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_try_yield (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
@@ -174,6 +173,7 @@ void do_iret (struct intr_frame *tf);
 
 void thread_sleep(int64_t ticks);
 void thread_wakeup(int64_t ticks);
+void thread_cancel_sleep(struct thread *t);
 bool less_wakeup_ticks(const struct list_elem *a, const struct list_elem *b, void *aux);
 bool higher_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
 
@@ -0,0 +1,35 @@
+#ifndef USERPROG_EXEC_CACHE_H
+#define USERPROG_EXEC_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/* Where one loadable segment of an executable goes, in the terms
+   load_segment() takes. */
+struct exec_segment {
+	off_t file_page;            /* Page-aligned offset in the file. */
+	uint64_t mem_page;          /* Page-aligned user address. */
+	uint32_t read_bytes;        /* Bytes to read from the file. */
+	uint32_t zero_bytes;        /* Bytes to zero after those. */
+	bool writable;              /* Whether the pages are writable. */
+};
+
+/* The parsed and validated layout of an executable: all load()
+   needs besides the file itself. */
+struct exec_image {
+	uint64_t entry;             /* Entry point. */
+	int refs;                   /* References, see exec_image_release(). */
+	int segment_cnt;            /* Number of SEGMENTS. */
+	struct exec_segment segments[];
+};
+
+void exec_cache_init (void);
+struct exec_image *exec_cache_lookup (struct inode *);
+void exec_cache_insert (struct inode *, struct exec_image *);
+void exec_cache_prune (void);
+void exec_image_release (struct exec_image *);
+
+#endif /* userprog/exec-cache.h */
@@ -0,0 +1,34 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+
+struct file;
+
+/* Most file descriptors a process can have, counting the console's
+   0 and 1. */
+#define FD_MAX 1536
+
+/* A process's file descriptor table.
+
+   Descriptors 0 and 1 are always in use.  They are the console
+   unless a file has been put on them, and go back to being the
+   console when it is removed.  The table starts with room for a
+   few descriptors and doubles whenever a process needs one beyond
+   its end. */
+struct fd_table {
+	struct file **files;        /* File open on each descriptor. */
+	unsigned long *used;        /* Bitmap of descriptors in use. */
+	int size;                   /* Descriptors FILES has room for. */
+};
+
+bool fd_table_init (struct fd_table *);
+void fd_table_destroy (struct fd_table *);
+
+int fd_table_add (struct fd_table *, struct file *);
+bool fd_table_install (struct fd_table *, int fd, struct file *);
+struct file *fd_table_get (const struct fd_table *, int fd);
+struct file *fd_table_remove (struct fd_table *, int fd);
+int fd_table_next (const struct fd_table *, int fd);
+
+#endif /* userprog/fdtable.h */
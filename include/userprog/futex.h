@@ -0,0 +1,9 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+void futex_init (void);
+int futex_wait (int *uaddr, int val);
+int futex_wake (int *uaddr, int cnt);
+int futex_requeue (int *uaddr, int cnt, int *uaddr2);
+
+#endif /* userprog/futex.h */
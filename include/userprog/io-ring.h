@@ -0,0 +1,13 @@
+#ifndef USERPROG_IO_RING_H
+#define USERPROG_IO_RING_H
+
+#include <io-ring.h>
+#include "threads/thread.h"
+
+void io_ring_init (void);
+int io_ring_setup (struct io_ring *);
+int io_ring_enter (unsigned to_submit, unsigned min_complete);
+void io_ring_drain (struct thread *);
+void io_ring_destroy (struct thread *);
+
+#endif /* userprog/io-ring.h */
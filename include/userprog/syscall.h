@@ -1,7 +1,14 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+struct file;
+
 void syscall_init (void);
 struct lock filesys_lock;
 
+int add_file_to_fdt (struct file *file);
+struct file *get_file_from_fd (int fd);
+void exit (int status);
+void close (int fd);
+
 #endif /* userprog/syscall.h */
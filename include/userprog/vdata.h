@@ -0,0 +1,15 @@
+#ifndef USERPROG_VDATA_H
+#define USERPROG_VDATA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void vdata_init (void);
+void vdata_tick (int64_t ticks, bool user);
+bool vdata_map (void);
+void vdata_unmap (void);
+void vdata_exit (void);
+bool vdata_overlaps (const void *uaddr, size_t size);
+
+#endif /* userprog/vdata.h */
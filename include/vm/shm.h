@@ -0,0 +1,29 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct frame;
+struct shm_segment;
+
+/* Longest segment name. */
+#define SHM_NAME_MAX 15
+
+/* Largest segment, in bytes. */
+#define SHM_SIZE_MAX (4 * 1024 * 1024)
+
+/* A page of a shared memory segment mapped into one process. */
+struct shm_page {
+	struct shm_segment *seg;    /* Segment the page belongs to. */
+	size_t idx;                 /* Page number within SEG. */
+};
+
+void vm_shm_init (void);
+int shm_get (const char *name, size_t size);
+bool shm_attach (int id, void *addr, bool writable);
+void shm_detach (void *addr);
+bool shm_copy_page (struct page *src);
+struct frame *shm_get_frame (struct page *page);
+
+#endif
@@ -13,6 +13,8 @@ enum vm_type {
 	VM_FILE = 2,
 	/* page that hold the page cache, for project 4 */
 	VM_PAGE_CACHE = 3,
+	/* anonymous page shared between processes */
+	VM_SHM = 4,
 
 	/* Bit flags to store state */
 
@@ -28,6 +30,7 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/shm.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
@@ -65,6 +68,7 @@ struct page {
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
+		struct shm_page shm;
 #ifdef EFILESYS
 		struct page_cache page_cache;
 #endif
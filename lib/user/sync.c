@@ -0,0 +1,120 @@
+#include <sync.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* Mutexes and condition variables on top of futex().
+
+   A mutex is an int that is changed only with atomic instructions.
+   Taking a free mutex and releasing one that nobody waits for are a
+   single atomic instruction each, with no system call.  Only a
+   process that finds the mutex taken sleeps in the kernel, after
+   marking the mutex as contended, and only the release of a
+   contended mutex makes a system call to wake a sleeper.  This is
+   the mutex from Ulrich Drepper, "Futexes Are Tricky".
+
+   A condition variable is a sequence number that every signal
+   bumps.  A waiter reads it, releases the mutex, and sleeps only if
+   the number has not moved since, so a signal between the release
+   and the sleep is not lost.  A broadcast wakes one waiter and
+   moves the rest onto the mutex, to be woken one at a time as it
+   is released. */
+
+/* Atomically sets *P to NEW if it holds OLD.  Returns the value *P
+   held. */
+static inline int
+cmpxchg (int *p, int old, int new) {
+	__atomic_compare_exchange_n (p, &old, new, false, __ATOMIC_SEQ_CST,
+			__ATOMIC_SEQ_CST);
+	return old;
+}
+
+/* Atomically sets *P to NEW.  Returns the value *P held. */
+static inline int
+xchg (int *p, int new) {
+	return __atomic_exchange_n (p, new, __ATOMIC_SEQ_CST);
+}
+
+/* Initializes M as unlocked. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Takes M, sleeping until it is free if need be. */
+void
+mutex_lock (struct mutex *m) {
+	int c = cmpxchg (&m->state, 0, 1);
+
+	if (c == 0)
+		return;
+
+	/* Mark the mutex contended, so that its holder wakes us, and
+	   sleep until we are the ones who take it. */
+	if (c != 2)
+		c = xchg (&m->state, 2);
+	while (c != 0) {
+		futex (&m->state, FUTEX_WAIT, 2, NULL);
+		c = xchg (&m->state, 2);
+	}
+}
+
+/* Takes M if it is free.  Returns true if it did. */
+bool
+mutex_trylock (struct mutex *m) {
+	return cmpxchg (&m->state, 0, 1) == 0;
+}
+
+/* Releases M, which the caller holds, and wakes a process sleeping
+   on it, if there may be one. */
+void
+mutex_unlock (struct mutex *m) {
+	if (__atomic_fetch_sub (&m->state, 1, __ATOMIC_SEQ_CST) != 1) {
+		__atomic_store_n (&m->state, 0, __ATOMIC_SEQ_CST);
+		futex (&m->state, FUTEX_WAKE, 1, NULL);
+	}
+}
+
+/* Initializes C with no waiters. */
+void
+cond_init (struct cond *c) {
+	c->seq = 0;
+	c->mutex = NULL;
+}
+
+/* Releases M, which the caller holds, sleeps until C is signaled,
+   and takes M again.  Wakeups may be spurious, so check the
+   condition waited for again afterward. */
+void
+cond_wait (struct cond *c, struct mutex *m) {
+	int seq = __atomic_load_n (&c->seq, __ATOMIC_SEQ_CST);
+
+	c->mutex = m;
+	mutex_unlock (m);
+	futex (&c->seq, FUTEX_WAIT, seq, NULL);
+
+	/* A broadcast may have moved other waiters onto the mutex, so
+	   take it in the contended state, which makes its release wake
+	   the next of them. */
+	while (xchg (&m->state, 2) != 0)
+		futex (&m->state, FUTEX_WAIT, 2, NULL);
+}
+
+/* Wakes one process waiting on C, if any. */
+void
+cond_signal (struct cond *c) {
+	__atomic_fetch_add (&c->seq, 1, __ATOMIC_SEQ_CST);
+	futex (&c->seq, FUTEX_WAKE, 1, NULL);
+}
+
+/* Wakes all processes waiting on C.  The caller should hold the
+   mutex they wait with. */
+void
+cond_broadcast (struct cond *c) {
+	struct mutex *m = c->mutex;
+
+	__atomic_fetch_add (&c->seq, 1, __ATOMIC_SEQ_CST);
+	if (m != NULL)
+		futex (&c->seq, FUTEX_REQUEUE, 1, &m->state);
+	else
+		futex (&c->seq, FUTEX_WAKE, INT_MAX, NULL);
+}
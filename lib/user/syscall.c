@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -90,6 +90,12 @@ exec (const char *file) {
 	return (pid_t) syscall1 (SYS_EXEC, file);
 }
 
+pid_t
+spawn (const char *cmd_line, const struct spawn_action *actions,
+		int action_cnt) {
+	return (pid_t) syscall3 (SYS_SPAWN, cmd_line, actions, action_cnt);
+}
+
 int
 wait (pid_t pid) {
 	return syscall1 (SYS_WAIT, pid);
@@ -145,6 +151,53 @@ dup2 (int oldfd, int newfd){
 	return syscall2 (SYS_DUP2, oldfd, newfd);
 }
 
+int
+pipe (int fds[2]) {
+	return syscall1 (SYS_PIPE, fds);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+sendfile (int out_fd, int in_fd, off_t *offset, unsigned count) {
+	return syscall4 (SYS_SENDFILE, out_fd, in_fd, offset, count);
+}
+
+int
+copy_file_range (int in_fd, off_t *in_offset, int out_fd, off_t *out_offset,
+		unsigned length) {
+	return syscall5 (SYS_COPY_FILE_RANGE, in_fd, in_offset, out_fd,
+			out_offset, length);
+}
+
+int
+io_setup (struct io_ring *ring) {
+	return syscall1 (SYS_IO_SETUP, ring);
+}
+
+int
+io_enter (unsigned to_submit, unsigned min_complete) {
+	return syscall2 (SYS_IO_ENTER, to_submit, min_complete);
+}
+
 void *
 mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 	return (void *) syscall5 (SYS_MMAP, addr, length, writable, fd, offset);
@@ -155,6 +208,36 @@ munmap (void *addr) {
 	syscall1 (SYS_MUNMAP, addr);
 }
 
+int
+shm_open (const char *name, size_t size) {
+	return syscall2 (SYS_SHM_OPEN, name, size);
+}
+
+void *
+shm_map (int id, void *addr, bool writable) {
+	return (void *) syscall3 (SYS_SHM_MAP, id, addr, writable);
+}
+
+int
+futex (int *addr, int op, int val, int *addr2) {
+	return syscall4 (SYS_FUTEX, addr, op, val, addr2);
+}
+
+int
+tty_mode (int mode) {
+	return syscall1 (SYS_TTY_MODE, mode);
+}
+
+int
+tty_poll (void) {
+	return syscall0 (SYS_TTY_POLL);
+}
+
+int
+poll (struct pollfd *fds, int nfds, int timeout) {
+	return syscall3 (SYS_POLL, fds, nfds, timeout);
+}
+
 bool
 chdir (const char *dir) {
 	return syscall1 (SYS_CHDIR, dir);
@@ -194,3 +277,8 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+bool
+disk_stats (int chan_no, int dev_no, struct disk_stats *stats) {
+	return syscall3 (SYS_DISK_STATS, chan_no, dev_no, stats);
+}
@@ -0,0 +1,107 @@
+#include <sysinfo.h>
+#include <stdbool.h>
+#include <vdata.h>
+
+/* Readers of the kernel data pages.
+
+   The kernel maps its data pages read-only into every process and
+   updates them on each timer tick, bumping a page's sequence number
+   before and after.  A reader takes a consistent snapshot by
+   reading the members between two reads of the sequence number and
+   starting over if the number was odd or changed meanwhile, which
+   only happens if a tick interrupted the reads.  None of this
+   enters the kernel. */
+
+#define barrier() asm volatile ("" : : : "memory")
+
+static const struct vdata *const vdata = (const struct vdata *) VDATA_ADDR;
+static const struct vdata_proc *const vdata_proc
+	= (const struct vdata_proc *) VDATA_PROC_ADDR;
+
+/* Returns the sequence number *SEQ once no update is under way. */
+static inline uint32_t
+read_begin (const volatile uint32_t *seq) {
+	uint32_t start;
+
+	while ((start = *seq) & 1)
+		continue;
+	barrier ();
+	return start;
+}
+
+/* Returns true if the reads since read_begin() returned START have
+   to be done over. */
+static inline bool
+read_retry (const volatile uint32_t *seq, uint32_t start) {
+	barrier ();
+	return *seq != start;
+}
+
+/* Reads the time stamp counter. */
+static inline uint64_t
+rdtsc (void) {
+	uint32_t lo, hi;
+
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return (uint64_t) hi << 32 | lo;
+}
+
+/* Returns the number of timer ticks since the OS booted.  A single
+   aligned load cannot see half an update, so it needs no retry. */
+int64_t
+sysinfo_ticks (void) {
+	return vdata->ticks;
+}
+
+/* Returns the number of microseconds since the OS booted.  Between
+   ticks, the time comes from the time stamp counter, so it is good
+   to well under a microsecond once the kernel has measured the
+   counter's rate, and to a tick before then.  The values returned
+   never decrease. */
+int64_t
+sysinfo_usecs (void) {
+	uint64_t tick_tsc, tsc_per_tick, elapsed;
+	int64_t ticks, usecs_per_tick;
+	uint32_t seq;
+
+	do {
+		seq = read_begin (&vdata->seq);
+		ticks = vdata->ticks;
+		tick_tsc = vdata->tick_tsc;
+		tsc_per_tick = vdata->tsc_per_tick;
+		usecs_per_tick = 1000000 / vdata->timer_freq;
+	} while (read_retry (&vdata->seq, seq));
+
+	if (tsc_per_tick == 0)
+		return ticks * usecs_per_tick;
+
+	/* If the next tick is due but its interrupt has not come yet,
+	   stop just short of it, so that time does not run backward
+	   once it comes. */
+	elapsed = rdtsc () - tick_tsc;
+	if (elapsed >= tsc_per_tick)
+		elapsed = tsc_per_tick - 1;
+	return ticks * usecs_per_tick
+		+ (int64_t) (elapsed * usecs_per_tick / tsc_per_tick);
+}
+
+/* Returns 100 times the system load average. */
+int
+sysinfo_load_avg (void) {
+	return vdata->load_avg;
+}
+
+/* Stores in *USER and *KERNEL the number of timer ticks the
+   running process has spent running its own code and in the kernel
+   on its behalf.  A forked child starts from zero; exec() does not
+   reset the counts. */
+void
+sysinfo_cpu_ticks (int64_t *user, int64_t *kernel) {
+	uint32_t seq;
+
+	do {
+		seq = read_begin (&vdata_proc->seq);
+		*user = vdata_proc->user_ticks;
+		*kernel = vdata_proc->kernel_ticks;
+	} while (read_retry (&vdata_proc->seq, seq));
+}
@@ -0,0 +1,76 @@
+/* Writes a 1 MB file and copies it to a new file, then checks the
+   copy.  Run it as "bench-copy MODE", where MODE selects how:
+
+     rw        read() into a 4 kB user buffer and write() it out,
+               256 times each;
+     sendfile  one sendfile() call;
+     copy      one copy_file_range() call.
+
+   With sendfile() and copy_file_range() the data never crosses
+   into user memory, and the kernel moves it in 64 kB pieces, each
+   a single disk command per side when the sectors lie next to
+   each other. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-copy";
+
+#define FILE_SIZE (1024 * 1024)
+#define BLOCK 4096
+
+static char buf[BLOCK];
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "copy";
+  int in, out, i, n = 0;
+  size_t ofs;
+
+  msg ("begin");
+  CHECK (create ("source", 0), "create \"source\"");
+  CHECK ((in = open ("source")) > 1, "open \"source\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK)
+    {
+      memset (buf, ofs / BLOCK, BLOCK);
+      if (write (in, buf, BLOCK) != BLOCK)
+        fail ("write at offset %zu failed", ofs);
+    }
+  seek (in, 0);
+  CHECK (create ("dest", 0), "create \"dest\"");
+  CHECK ((out = open ("dest")) > 1, "open \"dest\"");
+
+  if (!strcmp (mode, "rw"))
+    for (i = 0; i < FILE_SIZE / BLOCK; i++)
+      {
+        if (read (in, buf, BLOCK) != BLOCK || write (out, buf, BLOCK) != BLOCK)
+          fail ("copy of block %d failed", i);
+        n += BLOCK;
+      }
+  else if (!strcmp (mode, "sendfile"))
+    n = sendfile (out, in, NULL, FILE_SIZE);
+  else if (!strcmp (mode, "copy"))
+    n = copy_file_range (in, NULL, out, NULL, FILE_SIZE);
+  else
+    fail ("unknown mode \"%s\"", mode);
+  if (n != FILE_SIZE)
+    fail ("copied %d bytes instead of %d", n, FILE_SIZE);
+  msg ("copied %d bytes with %s", n, mode);
+
+  seek (out, 0);
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK)
+    {
+      if (read (out, buf, BLOCK) != BLOCK)
+        fail ("read at offset %zu failed", ofs);
+      for (i = 0; i < BLOCK; i++)
+        if (buf[i] != (char) (ofs / BLOCK))
+          fail ("byte %zu of the copy is wrong", ofs + i);
+    }
+  msg ("verified the copy");
+  close (in);
+  close (out);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,46 @@
+/* Creates 100 files, writes a byte to each and removes every other
+   one, then reports how many disk writes that took.
+
+   Every step changes only metadata: the free map or FAT, inodes
+   and the root directory.  With the metadata journal, those
+   changes are absorbed in memory and reach the disk in a few
+   sequential log writes instead of several scattered writes per
+   file. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 100
+
+void
+test_main (void)
+{
+  long long writes;
+  char name[16];
+  int fd, i;
+
+  writes = get_fs_disk_write_cnt ();
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!create (name, 0))
+        fail ("create \"%s\" failed", name);
+      if ((fd = open (name)) < 2)
+        fail ("open \"%s\" failed", name);
+      if (write (fd, "x", 1) != 1)
+        fail ("write \"%s\" failed", name);
+      close (fd);
+    }
+  for (i = 0; i < FILE_CNT; i += 2)
+    {
+      snprintf (name, sizeof name, "f%d", i);
+      if (!remove (name))
+        fail ("remove \"%s\" failed", name);
+    }
+  writes = get_fs_disk_write_cnt () - writes;
+
+  msg ("%d creates and %d removes took %lld disk writes",
+       FILE_CNT, FILE_CNT / 2, writes);
+}
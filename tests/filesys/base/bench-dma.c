@@ -0,0 +1,50 @@
+/* Writes a 2 MB file and reads it back three times, 64 kB at a
+   time: 8 MB of disk transfers in all.
+
+   Run it once as is and once with the -pio kernel option, and
+   divide the kernel ticks in the "Thread:" statistics printed at
+   power off by 8 to get the CPU time spent per MB.  With DMA, the
+   disk moves the data while the CPU idles or runs other threads;
+   with programmed I/O, the CPU copies every byte itself. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (2 * 1024 * 1024)
+#define BLOCK (64 * 1024)
+#define READ_PASSES 3
+
+static char buf[BLOCK];
+
+void
+test_main (void)
+{
+  size_t ofs;
+  int fd, pass;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK)
+    {
+      memset (buf, ofs / BLOCK, sizeof buf);
+      if (write (fd, buf, BLOCK) != BLOCK)
+        fail ("write at offset %zu failed", ofs);
+    }
+
+  for (pass = 0; pass < READ_PASSES; pass++)
+    {
+      seek (fd, 0);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK)
+        {
+          if (read (fd, buf, BLOCK) != BLOCK)
+            fail ("read at offset %zu failed", ofs);
+          if (buf[0] != (char) (ofs / BLOCK) || buf[BLOCK - 1] != buf[0])
+            fail ("wrong data at offset %zu", ofs);
+        }
+    }
+  close (fd);
+
+  msg ("transferred %d MB", (FILE_SIZE + FILE_SIZE * READ_PASSES) >> 20);
+}
@@ -0,0 +1,71 @@
+/* Writes a 4 MB file, then has four processes at once read random
+   sectors of it, 2,048 reads in all.
+
+   Run it with PINTOSOPTS=--virtio, which attaches the file system
+   disk as a virtio-blk device, and again with KERNELFLAGS=-pio on
+   the IDE disk, and divide 2,048 by the run time for the reads per
+   tick.  The IDE channel carries out one command at a time and the
+   CPU copies every sector; the virtio device takes many requests
+   at once and moves the data itself. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (4 * 1024 * 1024)
+#define BLOCK 512
+#define CHILD_CNT 4
+#define READ_CNT 512
+
+static char buf[4096];
+
+static void
+reader (int id)
+{
+  int fd, i;
+
+  random_init (id);
+  if ((fd = open ("data")) < 2)
+    fail ("child %d: open \"data\" failed", id);
+  for (i = 0; i < READ_CNT; i++)
+    {
+      seek (fd, random_ulong () % (FILE_SIZE / BLOCK) * BLOCK);
+      if (read (fd, buf, BLOCK) != BLOCK)
+        fail ("child %d: read %d failed", id, i);
+    }
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  pid_t pids[CHILD_CNT];
+  size_t ofs;
+  int fd, i;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += sizeof buf)
+    if (write (fd, buf, sizeof buf) != sizeof buf)
+      fail ("write at offset %zu failed", ofs);
+  close (fd);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("reader");
+      if (pids[i] == 0)
+        {
+          reader (i + 1);
+          exit (0);
+        }
+      if (pids[i] < 0)
+        fail ("fork %d failed", i);
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != 0)
+      fail ("child %d failed", i);
+
+  msg ("%d processes did %d random %d-byte reads each",
+       CHILD_CNT, READ_CNT, BLOCK);
+}
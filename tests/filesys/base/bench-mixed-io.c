@@ -0,0 +1,76 @@
+/* Writes a 2 MB file, then has four processes at once read and
+   rewrite random 4 kB blocks of it, three reads to each write.
+
+   Run it once as is and once with the -fifo kernel option, and
+   compare the "sectors of seeking" and the sectors per second that
+   the disk statistics report at power off.  With requests from
+   several processes queued at a time, the elevator serves them in
+   one sweep across the disk instead of in arrival order, and
+   merges those for adjacent sectors. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (2 * 1024 * 1024)
+#define BLOCK 4096
+#define CHILD_CNT 4
+#define OP_CNT 256
+
+static char buf[BLOCK];
+
+static void
+mix (int id)
+{
+  int fd, i;
+
+  random_init (id);
+  if ((fd = open ("data")) < 2)
+    fail ("child %d: open \"data\" failed", id);
+  for (i = 0; i < OP_CNT; i++)
+    {
+      seek (fd, random_ulong () % (FILE_SIZE / BLOCK) * BLOCK);
+      if (random_ulong () % 4 == 0)
+        {
+          if (write (fd, buf, BLOCK) != BLOCK)
+            fail ("child %d: write %d failed", id, i);
+        }
+      else if (read (fd, buf, BLOCK) != BLOCK)
+        fail ("child %d: read %d failed", id, i);
+    }
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  pid_t pids[CHILD_CNT];
+  size_t ofs;
+  int fd, i;
+
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK)
+    if (write (fd, buf, BLOCK) != BLOCK)
+      fail ("write at offset %zu failed", ofs);
+  close (fd);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pids[i] = fork ("child");
+      if (pids[i] == 0)
+        {
+          mix (i + 1);
+          exit (0);
+        }
+      if (pids[i] < 0)
+        fail ("fork %d failed", i);
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (pids[i]) != 0)
+      fail ("child %d failed", i);
+
+  msg ("%d processes did %d random %d-byte reads and writes each",
+       CHILD_CNT, OP_CNT, BLOCK);
+}
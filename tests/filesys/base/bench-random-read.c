@@ -0,0 +1,47 @@
+/* Writes a 1 MB file, then reads 1,024 sectors of it in random
+   order and reports how many disk reads that took.
+
+   The indexed inode of the original file system reaches any sector
+   through at most two cached index blocks; under EFILESYS each
+   lookup follows the in-memory FAT from the nearest cached chain
+   position.  Build it in both userprog/ and filesys/ and compare
+   disk reads and run time. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (1024 * 1024)
+#define BLOCK 512
+#define READ_CNT 1024
+
+static char buf[4096];
+
+void
+test_main (void)
+{
+  long long reads;
+  size_t ofs;
+  int fd, i;
+
+  random_init (0);
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += sizeof buf)
+    if (write (fd, buf, sizeof buf) != sizeof buf)
+      fail ("write at offset %zu failed", ofs);
+
+  reads = get_fs_disk_read_cnt ();
+  for (i = 0; i < READ_CNT; i++)
+    {
+      seek (fd, random_ulong () % (FILE_SIZE / BLOCK) * BLOCK);
+      if (read (fd, buf, BLOCK) != BLOCK)
+        fail ("random read %d failed", i);
+    }
+  reads = get_fs_disk_read_cnt () - reads;
+  close (fd);
+
+  msg ("%d random reads of %d bytes took %lld disk reads",
+       READ_CNT, BLOCK, reads);
+}
@@ -0,0 +1,107 @@
+/* Writes a file of 2,048 fixed-size records, then reads 256 runs
+   of 16 consecutive records at random places in it.  Each record's
+   header and body go to separate arrays.  Run it as
+   "bench-records MODE", where MODE selects how the runs are read:
+
+     seek   seek() to the run, then read() each header and body
+            (33 system calls per run);
+     pread  pread() each header and body (32 calls per run);
+     readv  seek() to the run, then one readv() with a segment per
+            header and body (2 calls per run).
+
+   readv() takes the file system lock and enters the inode layer
+   once per run instead of once per piece. */
+
+#include <stdio.h>
+#include <string.h>
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-records";
+
+#define RECORD_CNT 2048
+#define HEADER 16
+#define BODY 112
+#define RECORD (HEADER + BODY)
+#define RUN 16
+#define RUN_CNT 256
+
+static char headers[RUN][HEADER];
+static char bodies[RUN][BODY];
+static char record[RECORD];
+
+/* Reads the RUN records from record FIRST on into HEADERS and
+   BODIES from FD in the way MODE names. */
+static void
+read_run (int fd, const char *mode, int first)
+{
+  struct iovec iov[RUN * 2];
+  int ofs = first * RECORD;
+  int i;
+
+  if (!strcmp (mode, "seek"))
+    {
+      seek (fd, ofs);
+      for (i = 0; i < RUN; i++)
+        if (read (fd, headers[i], HEADER) != HEADER
+            || read (fd, bodies[i], BODY) != BODY)
+          fail ("read of record %d failed", first + i);
+    }
+  else if (!strcmp (mode, "pread"))
+    {
+      for (i = 0; i < RUN; i++, ofs += RECORD)
+        if (pread (fd, headers[i], HEADER, ofs) != HEADER
+            || pread (fd, bodies[i], BODY, ofs + HEADER) != BODY)
+          fail ("pread of record %d failed", first + i);
+    }
+  else if (!strcmp (mode, "readv"))
+    {
+      for (i = 0; i < RUN; i++)
+        {
+          iov[2 * i] = (struct iovec) {headers[i], HEADER};
+          iov[2 * i + 1] = (struct iovec) {bodies[i], BODY};
+        }
+      seek (fd, ofs);
+      if (readv (fd, iov, RUN * 2) != RUN * RECORD)
+        fail ("readv of records %d...%d failed", first, first + RUN - 1);
+    }
+  else
+    fail ("unknown mode \"%s\"", mode);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "readv";
+  int fd, i, j;
+
+  msg ("begin");
+  random_init (0);
+  CHECK (create ("records", 0), "create \"records\"");
+  CHECK ((fd = open ("records")) > 1, "open \"records\"");
+  for (i = 0; i < RECORD_CNT; i++)
+    {
+      snprintf (record, sizeof record, "%d", i);
+      if (write (fd, record, RECORD) != RECORD)
+        fail ("write of record %d failed", i);
+    }
+
+  for (i = 0; i < RUN_CNT; i++)
+    {
+      int first = random_ulong () % (RECORD_CNT - RUN + 1);
+
+      read_run (fd, mode, first);
+      for (j = 0; j < RUN; j++)
+        {
+          snprintf (record, HEADER, "%d", first + j);
+          if (strcmp (headers[j], record))
+            fail ("record %d has header \"%s\"", first + j, headers[j]);
+        }
+    }
+  close (fd);
+
+  msg ("read %d runs of %d records with %s", RUN_CNT, RUN, mode);
+  msg ("end");
+  return 0;
+}
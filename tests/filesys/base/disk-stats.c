@@ -0,0 +1,64 @@
+/* Writes and reads back a file, then checks that the statistics
+   disk_stats() reports for the file system disk are consistent
+   with each other and have not gone backward. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[16384];
+
+/* Returns the number of requests counted in histogram HIST. */
+static int64_t
+total (const int64_t hist[DISK_LATENCY_BUCKETS])
+{
+  int64_t sum = 0;
+  int i;
+
+  for (i = 0; i < DISK_LATENCY_BUCKETS; i++)
+    sum += hist[i];
+  return sum;
+}
+
+void
+test_main (void)
+{
+  struct disk_stats before, after;
+  int fd;
+
+  CHECK (disk_stats (0, 1, &before), "get statistics of hd0:1");
+  CHECK (create ("data", 0), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf, "write \"data\"");
+  seek (fd, 0);
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read \"data\"");
+  msg ("close \"data\"");
+  close (fd);
+  CHECK (disk_stats (0, 1, &after), "get statistics of hd0:1 again");
+  CHECK (!disk_stats (2, 0, &after), "no statistics for hd2:0");
+
+  /* Loading this program read the disk. */
+  if (before.read_cnt == 0 || total (before.read_latency) == 0)
+    fail ("no reads counted");
+  if (after.read_cnt < before.read_cnt
+      || after.write_cnt < before.write_cnt
+      || after.request_cnt < before.request_cnt
+      || total (after.read_latency) < total (before.read_latency)
+      || total (after.write_latency) < total (before.write_latency))
+    fail ("counts went backward");
+
+  if (after.read_bytes != after.read_cnt * 512
+      || after.write_bytes != after.write_cnt * 512)
+    fail ("bytes do not match sectors");
+  if (after.seq_cnt + after.random_cnt != after.cmd_cnt)
+    fail ("commands are neither sequential nor random");
+  if (after.cmd_cnt > after.request_cnt)
+    fail ("more commands than requests");
+  if (total (after.read_latency) + total (after.write_latency)
+      > after.request_cnt)
+    fail ("more latencies than requests");
+  if (after.lock_contended > after.lock_cnt
+      || after.depth_max < 1 || after.depth_sum < after.request_cnt)
+    fail ("bad lock or queue depth counts");
+  msg ("statistics are consistent");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(disk-stats) begin
+(disk-stats) get statistics of hd0:1
+(disk-stats) create "data"
+(disk-stats) open "data"
+(disk-stats) write "data"
+(disk-stats) read "data"
+(disk-stats) close "data"
+(disk-stats) get statistics of hd0:1 again
+(disk-stats) no statistics for hd2:0
+(disk-stats) statistics are consistent
+(disk-stats) end
+EOF
+pass;
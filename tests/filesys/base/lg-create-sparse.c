@@ -0,0 +1,50 @@
+/* Creates a 1 MB file and checks that creating it writes only a
+   few sectors, because a new file is one big hole.  Then checks
+   that the hole reads as zeros and that a write into the middle of
+   it reads back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define TEST_SIZE (1024 * 1024)
+
+static char buf[4096];
+
+void
+test_main (void)
+{
+  static const char data[] = "sparse";
+  long long write_cnt;
+  size_t i;
+  int fd;
+
+  write_cnt = get_fs_disk_write_cnt ();
+  CHECK (create ("sparse", TEST_SIZE), "create \"sparse\"");
+  CHECK (get_fs_disk_write_cnt () - write_cnt < 8,
+         "create wrote fewer than 8 sectors");
+
+  CHECK ((fd = open ("sparse")) > 1, "open \"sparse\"");
+  CHECK (filesize (fd) == TEST_SIZE, "check file size");
+
+  seek (fd, TEST_SIZE / 2);
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read middle of hole");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu of hole is %d, not 0", TEST_SIZE / 2 + i, buf[i]);
+
+  seek (fd, 700000);
+  CHECK (write (fd, data, sizeof data) == sizeof data, "write into hole");
+  seek (fd, 700000 - 100);
+  CHECK (read (fd, buf, 200) == 200, "read back");
+  for (i = 0; i < 200; i++)
+    {
+      char expected = i >= 100 && i < 100 + sizeof data ? data[i - 100] : 0;
+      if (buf[i] != expected)
+        fail ("byte %zu is %d, not %d", 700000 - 100 + i, buf[i], expected);
+    }
+
+  msg ("close \"sparse\"");
+  close (fd);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lg-create-sparse) begin
+(lg-create-sparse) create "sparse"
+(lg-create-sparse) create wrote fewer than 8 sectors
+(lg-create-sparse) open "sparse"
+(lg-create-sparse) check file size
+(lg-create-sparse) read middle of hole
+(lg-create-sparse) write into hole
+(lg-create-sparse) read back
+(lg-create-sparse) close "sparse"
+(lg-create-sparse) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Writes a few bytes at offsets spread over an 8 MB file, reaching
+   sectors mapped directly by the inode as well as through index
+   blocks, and checks that they read back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (8 * 1024 * 1024)
+
+static const int offsets[] = {0, 70000, 200000, 5000000, FILE_SIZE - 10};
+
+void
+test_main (void)
+{
+  static const char data[] = "123456789";
+  char buf[sizeof data];
+  size_t i;
+  int fd;
+
+  CHECK (create ("big", 0), "create \"big\"");
+  CHECK ((fd = open ("big")) > 1, "open \"big\"");
+  for (i = 0; i < sizeof offsets / sizeof *offsets; i++)
+    {
+      seek (fd, offsets[i]);
+      if (write (fd, data, sizeof data) != sizeof data)
+        fail ("write at offset %d failed", offsets[i]);
+    }
+  msg ("wrote at %zu offsets", sizeof offsets / sizeof *offsets);
+  CHECK (filesize (fd) == FILE_SIZE, "check file size");
+
+  for (i = 0; i < sizeof offsets / sizeof *offsets; i++)
+    {
+      seek (fd, offsets[i]);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read at offset %d failed", offsets[i]);
+      if (memcmp (buf, data, sizeof data))
+        fail ("wrong data at offset %d", offsets[i]);
+    }
+  msg ("verified %zu offsets", sizeof offsets / sizeof *offsets);
+
+  msg ("close \"big\"");
+  close (fd);
+}
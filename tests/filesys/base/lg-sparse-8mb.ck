@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lg-sparse-8mb) begin
+(lg-sparse-8mb) create "big"
+(lg-sparse-8mb) open "big"
+(lg-sparse-8mb) wrote at 5 offsets
+(lg-sparse-8mb) check file size
+(lg-sparse-8mb) verified 5 offsets
+(lg-sparse-8mb) close "big"
+(lg-sparse-8mb) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Grows two files in parallel, one sector-sized write at a time,
+   then reads the first back sequentially and reports how many
+   disk reads that took.
+
+   Run it with the `frag' action afterward to see how many runs
+   each file ended up in, and time the sequential read on a
+   simulator that models seeks, e.g.
+
+     pintos ... -- -q -f run grow-seq-read frag
+
+   Compare with the -delalloc kernel option as well. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_SIZE (128 * 1024)
+#define CHUNK 512
+#define READ_BLOCK 4096
+
+static char buf[READ_BLOCK];
+
+void
+test_main (void)
+{
+  long long reads;
+  int fd_a, fd_b;
+  size_t ofs;
+
+  CHECK (create ("a", 0), "create \"a\"");
+  CHECK (create ("b", 0), "create \"b\"");
+  CHECK ((fd_a = open ("a")) > 1, "open \"a\"");
+  CHECK ((fd_b = open ("b")) > 1, "open \"b\"");
+
+  msg ("write \"a\" and \"b\" alternately");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += CHUNK)
+    {
+      if (write (fd_a, buf, CHUNK) != CHUNK)
+        fail ("write \"a\" at offset %zu failed", ofs);
+      if (write (fd_b, buf, CHUNK) != CHUNK)
+        fail ("write \"b\" at offset %zu failed", ofs);
+    }
+  close (fd_a);
+  close (fd_b);
+
+  CHECK ((fd_a = open ("a")) > 1, "open \"a\" for sequential read");
+  reads = get_fs_disk_read_cnt ();
+  for (ofs = 0; ofs < FILE_SIZE; ofs += READ_BLOCK)
+    if (read (fd_a, buf, READ_BLOCK) != READ_BLOCK)
+      fail ("read \"a\" at offset %zu failed", ofs);
+  reads = get_fs_disk_read_cnt () - reads;
+  close (fd_a);
+
+  msg ("read %d bytes sequentially in %lld disk reads",
+       FILE_SIZE, reads);
+}
@@ -0,0 +1,195 @@
+/* Test program for the block functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset() and memcmp() against simple
+   byte loops for every combination of small alignments and sizes,
+   then measures their bandwidth, and that of copy_page() and
+   clear_page(), against the byte loops on 4 kB blocks.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/test.h"
+#include "devices/timer.h"
+
+/* Largest block checked for correctness. */
+#define MAX_SIZE 80
+
+/* Bytes moved per bandwidth measurement. */
+#define BENCH_BYTES (64 * 1024 * 1024)
+
+static unsigned char a[MAX_SIZE * 2 + 16];
+static unsigned char b[MAX_SIZE * 2 + 16];
+static unsigned char expected[MAX_SIZE * 2 + 16];
+
+static void verify (void);
+static void bench (const char *name, void (*func) (void *, void *));
+
+static void byte_copy (void *, void *);
+static void byte_set (void *, void *);
+static void string_copy (void *, void *);
+static void string_set (void *, void *);
+static void page_copy (void *, void *);
+static void page_clear (void *, void *);
+
+/* Test block functions. */
+void
+test (void)
+{
+  verify ();
+  printf ("string: correctness PASS\n");
+
+  bench ("byte loop copy", byte_copy);
+  bench ("memcpy", string_copy);
+  bench ("copy_page", page_copy);
+  bench ("byte loop set", byte_set);
+  bench ("memset", string_set);
+  bench ("clear_page", page_clear);
+  printf ("string: PASS\n");
+}
+
+/* Fills A with random bytes and copies them to B. */
+static void
+randomize (void)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof a; i++)
+    a[i] = random_ulong ();
+  memcpy (b, a, sizeof b);
+}
+
+/* Checks each block function at every source and destination
+   offset from 0 to 7 and every size up to MAX_SIZE. */
+static void
+verify (void)
+{
+  int dst, src, size, i;
+
+  random_init (0);
+  for (dst = 0; dst < 8; dst++)
+    for (src = 0; src < 8; src++)
+      for (size = 0; size <= MAX_SIZE; size++)
+        {
+          int cmp, ref;
+
+          /* memcpy() between the two arrays. */
+          randomize ();
+          memcpy (expected, b, sizeof b);
+          for (i = 0; i < size; i++)
+            expected[dst + i] = a[src + i];
+          ASSERT (memcpy (b + dst, a + src, size) == b + dst);
+          ASSERT (!memcmp (b, expected, sizeof b));
+
+          /* memmove() within one array, both ways. */
+          randomize ();
+          memcpy (expected, a, sizeof a);
+          for (i = size - 1; i >= 0; i--)
+            expected[dst + 8 + i] = a[src + i];
+          ASSERT (memmove (a + dst + 8, a + src, size) == a + dst + 8);
+          ASSERT (!memcmp (a, expected, sizeof a));
+          randomize ();
+          memcpy (expected, a, sizeof a);
+          for (i = 0; i < size; i++)
+            expected[dst + i] = a[src + 8 + i];
+          ASSERT (memmove (a + dst, a + src + 8, size) == a + dst);
+          ASSERT (!memcmp (a, expected, sizeof a));
+
+          /* memset(). */
+          randomize ();
+          memcpy (expected, a, sizeof a);
+          for (i = 0; i < size; i++)
+            expected[dst + i] = src * 37;
+          ASSERT (memset (a + dst, src * 37, size) == a + dst);
+          ASSERT (!memcmp (a, expected, sizeof a));
+
+          /* memcmp() of equal blocks, then with one byte changed. */
+          randomize ();
+          memcpy (b + dst, a + src, size);
+          ASSERT (memcmp (b + dst, a + src, size) == 0);
+          if (size > 0)
+            {
+              i = random_ulong () % size;
+              b[dst + i] ^= 1 << (random_ulong () % 8);
+              ref = b[dst + i] > a[src + i] ? 1 : -1;
+              cmp = memcmp (b + dst, a + src, size);
+              ASSERT ((cmp > 0) - (cmp < 0) == ref);
+            }
+        }
+}
+
+/* Moves BENCH_BYTES with FUNC, a page at a time, and prints the
+   bandwidth. */
+static void
+bench (const char *name, void (*func) (void *, void *))
+{
+  void *dst = palloc_get_page (PAL_ASSERT);
+  void *src = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  int64_t start, usecs;
+  int i;
+
+  start = timer_usecs ();
+  for (i = 0; i < BENCH_BYTES / PGSIZE; i++)
+    func (dst, src);
+  usecs = timer_usecs () - start;
+  if (usecs == 0)
+    usecs = 1;
+  printf ("%-16s %6lld MB/s\n", name,
+          (long long) BENCH_BYTES / usecs);
+
+  palloc_free_page (dst);
+  palloc_free_page (src);
+}
+
+/* Copies page SRC to DST a byte at a time. */
+static void
+byte_copy (void *dst_, void *src_)
+{
+  unsigned char *dst = dst_;
+  const unsigned char *src = src_;
+  size_t i;
+
+  for (i = 0; i < PGSIZE; i++)
+    dst[i] = src[i];
+}
+
+/* Zeros page DST a byte at a time. */
+static void
+byte_set (void *dst_, void *src UNUSED)
+{
+  unsigned char *dst = dst_;
+  size_t i;
+
+  for (i = 0; i < PGSIZE; i++)
+    dst[i] = 0;
+}
+
+static void
+string_copy (void *dst, void *src)
+{
+  memcpy (dst, src, PGSIZE);
+}
+
+static void
+string_set (void *dst, void *src UNUSED)
+{
+  memset (dst, 0, PGSIZE);
+}
+
+static void
+page_copy (void *dst, void *src)
+{
+  copy_page (dst, src);
+}
+
+static void
+page_clear (void *dst, void *src UNUSED)
+{
+  clear_page (dst);
+}
@@ -0,0 +1,56 @@
+/* Times reading the clock.  Calls sysinfo_usecs(), which reads the
+   kernel data pages, and tty_poll(), about the cheapest system
+   call there is, 100,000 times each, and prints what each call
+   cost, as timed by sysinfo_usecs() itself.
+
+   A clock read costs no more than a few loads and a time stamp
+   counter read; the system call shows what a clock behind a trap
+   would cost on top. */
+
+#include <sysinfo.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-clock";
+
+#define CALL_CNT 100000
+
+/* Prints how long CALL_CNT calls took from START, in nanoseconds
+   per call. */
+static void
+report (const char *what, int64_t start)
+{
+  int64_t usecs = sysinfo_usecs () - start;
+
+  msg ("%d calls of %s in %lld us, %lld ns each", CALL_CNT, what,
+       (long long) usecs, (long long) usecs * 1000 / CALL_CNT);
+}
+
+int
+main (void)
+{
+  int64_t start, prev, now, user, kernel;
+  int i;
+
+  msg ("begin");
+  start = prev = sysinfo_usecs ();
+  for (i = 0; i < CALL_CNT; i++)
+    {
+      now = sysinfo_usecs ();
+      if (now < prev)
+        fail ("clock went back");
+      prev = now;
+    }
+  report ("sysinfo_usecs()", start);
+
+  start = sysinfo_usecs ();
+  for (i = 0; i < CALL_CNT; i++)
+    tty_poll ();
+  report ("tty_poll()", start);
+
+  sysinfo_cpu_ticks (&user, &kernel);
+  msg ("%lld ticks in user mode, %lld in the kernel",
+       (long long) user, (long long) kernel);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,41 @@
+/* Replaces itself with exec() 1,000 times in a row, each time with
+   the count of runs left as its argument, so that the same small
+   executable is loaded over and over.  Run it as "bench-exec".
+
+   There is no fork() and the program does nothing else, so the
+   time goes into loading the executable. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-exec";
+
+#define EXEC_CNT 1000
+
+int
+main (int argc, char *argv[])
+{
+  char cmd_line[32];
+  int left;
+
+  if (argc < 2)
+    {
+      msg ("begin");
+      left = EXEC_CNT;
+    }
+  else
+    left = atoi (argv[1]);
+
+  if (left > 0)
+    {
+      snprintf (cmd_line, sizeof cmd_line, "bench-exec %d", left - 1);
+      exec (cmd_line);
+      fail ("exec with %d left failed", left);
+    }
+
+  msg ("loaded bench-exec %d times", EXEC_CNT);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,44 @@
+/* Forks 500 children that exit at once and waits for each, then
+   500 more that each have a file open.
+
+   Each child does next to no work, so the cost of setting up and
+   tearing down a process, its file descriptor table included,
+   dominates. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FORK_CNT 500
+
+/* Forks FORK_CNT children that exit at once and waits for each. */
+static void
+fork_and_wait (const char *what)
+{
+  int i;
+
+  for (i = 0; i < FORK_CNT; i++)
+    {
+      pid_t pid = fork ("child");
+      if (pid == 0)
+        exit (0);
+      if (pid < 0)
+        fail ("fork %d failed", i);
+      if (wait (pid) != 0)
+        fail ("wait for child %d failed", i);
+    }
+  msg ("forked and reaped %d children %s", FORK_CNT, what);
+}
+
+void
+test_main (void)
+{
+  int fd;
+
+  fork_and_wait ("with no files open");
+
+  CHECK (create ("small", 0), "create \"small\"");
+  CHECK ((fd = open ("small")) > 1, "open \"small\"");
+  fork_and_wait ("with one file open");
+  close (fd);
+}
@@ -0,0 +1,63 @@
+/* Streams 16 MB from a forked child to its parent through a pipe
+   and checks that every byte arrives.  Run it as
+   "bench-pipe SIZE", where SIZE is the number of bytes each read()
+   and write() moves, 4096 if not given.
+
+   Divide 16 MB by the run time to get the throughput.  Small sizes
+   measure the cost per system call; sizes near the pipe's one-page
+   buffer measure copying, with the reader and writer only going to
+   sleep when the buffer runs empty or full. */
+
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-pipe";
+
+#define TOTAL_SIZE (16 * 1024 * 1024)
+#define MAX_SIZE 65536
+
+static char buf[MAX_SIZE];
+
+int
+main (int argc, char *argv[])
+{
+  int size = argc > 1 ? atoi (argv[1]) : 4096;
+  int fds[2], total, n, i;
+  pid_t pid;
+
+  msg ("begin");
+  if (size <= 0 || size > MAX_SIZE)
+    fail ("size must be from 1 to %d", MAX_SIZE);
+  CHECK (pipe (fds) == 0, "pipe");
+
+  pid = fork ("bench-pipe");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      for (total = 0; total < TOTAL_SIZE; total += n)
+        {
+          n = TOTAL_SIZE - total < size ? TOTAL_SIZE - total : size;
+          for (i = 0; i < n; i++)
+            buf[i] = (total + i) & 0xff;
+          if (write (fds[1], buf, n) != n)
+            exit (1);
+        }
+      exit (0);
+    }
+  if (pid < 0)
+    fail ("fork failed");
+  close (fds[1]);
+
+  for (total = 0; (n = read (fds[0], buf, size)) > 0; total += n)
+    for (i = 0; i < n; i++)
+      if (buf[i] != (char) ((total + i) & 0xff))
+        fail ("byte %d differs", total + i);
+  if (total != TOTAL_SIZE)
+    fail ("read %d bytes, expected %d", total, TOTAL_SIZE);
+  if (wait (pid) != 0)
+    fail ("writer failed");
+  msg ("moved %d bytes in %d-byte pieces", total, size);
+  msg ("end");
+  return 0;
+}
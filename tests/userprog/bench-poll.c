@@ -0,0 +1,106 @@
+/* Multiplexes 64 pipes with poll().  A forked child writes
+   messages to the pipes in a scattered order while the parent
+   waits on all 64 read ends at once with poll(), reads from each
+   one that is ready, and checks every message, until each pipe
+   reaches end of file.  Run it as "bench-poll COUNT", where COUNT
+   is the number of messages, 65536 if not given.
+
+   Divide COUNT by the run time to get the message rate.  The
+   number of poll() calls it reports shows how many messages each
+   wakeup collects: the more that pile up while the parent sleeps,
+   the fewer calls it takes. */
+
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-poll";
+
+#define PIPE_CNT 64
+#define MSG_SIZE 16
+
+/* The pipe message number I goes to. */
+#define PIPE_OF(I) ((I) * 37 % PIPE_CNT)
+
+static struct pollfd pfds[PIPE_CNT];
+static int seqs[PIPE_CNT];
+static char buf[4096];
+
+int
+main (int argc, char *argv[])
+{
+  int count = argc > 1 ? atoi (argv[1]) : 65536;
+  int fds[PIPE_CNT][2];
+  int open_cnt, poll_cnt, received, i, j, n;
+  pid_t pid;
+
+  msg ("begin");
+  if (count <= 0)
+    fail ("count must be positive");
+  for (i = 0; i < PIPE_CNT; i++)
+    if (pipe (fds[i]) != 0)
+      fail ("pipe %d failed", i);
+
+  pid = fork ("bench-poll");
+  if (pid == 0)
+    {
+      for (i = 0; i < PIPE_CNT; i++)
+        close (fds[i][0]);
+      for (i = 0; i < count; i++)
+        {
+          int *words = (int *) buf;
+
+          /* Each message holds its number on its pipe. */
+          for (j = 0; j < MSG_SIZE / (int) sizeof *words; j++)
+            words[j] = i / PIPE_CNT;
+          if (write (fds[PIPE_OF (i)][1], buf, MSG_SIZE) != MSG_SIZE)
+            exit (1);
+        }
+      exit (0);
+    }
+  if (pid < 0)
+    fail ("fork failed");
+
+  for (i = 0; i < PIPE_CNT; i++)
+    {
+      close (fds[i][1]);
+      pfds[i].fd = fds[i][0];
+      pfds[i].events = POLLIN;
+    }
+
+  poll_cnt = received = 0;
+  for (open_cnt = PIPE_CNT; open_cnt > 0; )
+    {
+      if (poll (pfds, PIPE_CNT, -1) <= 0)
+        fail ("poll failed");
+      poll_cnt++;
+      for (i = 0; i < PIPE_CNT; i++)
+        {
+          if (pfds[i].revents == 0)
+            continue;
+          n = read (pfds[i].fd, buf, sizeof buf);
+          if (n == 0)
+            {
+              /* End of file: stop watching this pipe. */
+              close (pfds[i].fd);
+              pfds[i].fd = -1;
+              open_cnt--;
+              continue;
+            }
+          if (n < 0 || n % MSG_SIZE != 0)
+            fail ("read %d bytes from pipe %d", n, i);
+          for (j = 0; j < n; j += MSG_SIZE)
+            if (*(int *) (buf + j) != seqs[i]++)
+              fail ("pipe %d: message out of order", i);
+          received += n / MSG_SIZE;
+        }
+    }
+  if (received != count)
+    fail ("received %d messages, expected %d", received, count);
+  if (wait (pid) != 0)
+    fail ("writer failed");
+  msg ("received %d messages over %d pipes in %d polls",
+       received, PIPE_CNT, poll_cnt);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,128 @@
+/* Writes a 64 kB file, then reads 10,000 64-byte records at random
+   places in it.  Run it as "bench-ring MODE", where MODE selects
+   how:
+
+     syscall  one pread() per record;
+     ring     pread operations queued in an I/O ring, 32 at a time,
+              each batch submitted and reaped with one io_enter().
+
+   With the ring, the process crosses into the kernel once per
+   batch instead of once per record. */
+
+#include <random.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-ring";
+
+#define FILE_SIZE (64 * 1024)
+#define RECORD 64
+#define RECORD_CNT (FILE_SIZE / RECORD)
+#define READ_CNT 10000
+#define BATCH 32
+
+static struct io_ring ring __attribute__ ((aligned (4096)));
+static char records[BATCH][RECORD];
+static char block[4096];
+
+/* Checks that BUF holds record IDX. */
+static void
+check_record (const char *buf, int idx)
+{
+  int i;
+
+  for (i = 0; i < RECORD; i++)
+    if (buf[i] != (char) (idx + i))
+      fail ("record %d is corrupt at byte %d", idx, i);
+}
+
+/* Reads READ_CNT random records from FD with pread(). */
+static void
+read_syscall (int fd)
+{
+  int i;
+
+  for (i = 0; i < READ_CNT; i++)
+    {
+      int idx = random_ulong () % RECORD_CNT;
+
+      if (pread (fd, records[0], RECORD, idx * RECORD) != RECORD)
+        fail ("pread of record %d failed", idx);
+      check_record (records[0], idx);
+    }
+}
+
+/* Reads READ_CNT random records from FD through RING. */
+static void
+read_ring (int fd)
+{
+  int idx[BATCH];
+  int done, i;
+
+  CHECK (io_setup (&ring) == 0, "io_setup");
+  for (done = 0; done < READ_CNT; done += BATCH)
+    {
+      int cnt = READ_CNT - done < BATCH ? READ_CNT - done : BATCH;
+
+      for (i = 0; i < cnt; i++)
+        {
+          struct io_sqe *sqe = io_ring_get_sqe (&ring);
+
+          idx[i] = random_ulong () % RECORD_CNT;
+          memset (sqe, 0, sizeof *sqe);
+          sqe->opcode = IO_OP_PREAD;
+          sqe->fd = fd;
+          sqe->addr = (uint64_t) records[i];
+          sqe->len = RECORD;
+          sqe->off = idx[i] * RECORD;
+          sqe->user_data = i;
+          io_ring_push (&ring);
+        }
+      if (io_enter (cnt, cnt) != cnt)
+        fail ("io_enter took fewer than %d reads", cnt);
+      for (i = 0; i < cnt; i++)
+        {
+          struct io_cqe *cqe = io_ring_peek_cqe (&ring);
+
+          if (cqe == NULL || cqe->res != RECORD)
+            fail ("read %d through the ring failed", done + i);
+          check_record (records[cqe->user_data], idx[cqe->user_data]);
+          io_ring_cqe_seen (&ring);
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "ring";
+  int fd, i;
+
+  msg ("begin");
+  random_init (0);
+  CHECK (create ("records", 0), "create \"records\"");
+  CHECK ((fd = open ("records")) > 1, "open \"records\"");
+  for (i = 0; i < FILE_SIZE; i += sizeof block)
+    {
+      int j;
+
+      /* Byte J of record N holds N + J. */
+      for (j = 0; j < (int) sizeof block; j++)
+        block[j] = (i + j) / RECORD + j % RECORD;
+      if (write (fd, block, sizeof block) != (int) sizeof block)
+        fail ("write at offset %d failed", i);
+    }
+
+  if (!strcmp (mode, "syscall"))
+    read_syscall (fd);
+  else if (!strcmp (mode, "ring"))
+    read_ring (fd);
+  else
+    fail ("unknown mode \"%s\"", mode);
+  close (fd);
+
+  msg ("read %d %d-byte records with %s", READ_CNT, RECORD, mode);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,59 @@
+/* Starts 1,000 processes, one after another, each running this
+   program in "child" mode, which exits at once, and waits for each.
+   Run it as "bench-spawn MODE", where MODE selects how:
+
+     fork   fork() a copy of this process, which then exec()s;
+     spawn  spawn() the child directly.
+
+   With spawn() the kernel never copies the parent's address space
+   and file descriptors only for exec() to throw them away. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-spawn";
+
+#define SPAWN_CNT 1000
+
+static char big[64 * 1024];
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "spawn";
+  int i;
+
+  if (!strcmp (mode, "child"))
+    return 0;
+
+  msg ("begin");
+  /* Give the parent some memory worth copying. */
+  memset (big, 'x', sizeof big);
+  for (i = 0; i < SPAWN_CNT; i++)
+    {
+      pid_t pid;
+
+      if (!strcmp (mode, "fork"))
+        {
+          pid = fork ("bench-spawn");
+          if (pid == 0)
+            {
+              exec ("bench-spawn child");
+              fail ("exec failed");
+            }
+        }
+      else if (!strcmp (mode, "spawn"))
+        pid = spawn ("bench-spawn child", NULL, 0);
+      else
+        fail ("unknown mode \"%s\"", mode);
+
+      if (pid < 0)
+        fail ("starting child %d failed", i);
+      if (wait (pid) != 0)
+        fail ("child %d failed", i);
+    }
+  msg ("started %d children with %s", SPAWN_CNT, mode);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,57 @@
+/* Makes many cheap system calls that pass pointers: 2,000 opens and
+   closes of one file by name, then 20,000 16-byte writes and 20,000
+   16-byte reads, and 1,000 readv() calls of 8 segments.
+
+   The work per call is small, so the cost of getting file names
+   and buffers in and out of user memory dominates. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define OPEN_CNT 2000
+#define IO_CNT 20000
+#define IO_SIZE 16
+#define VEC_CNT 1000
+#define SEGS 8
+
+static char buf[IO_SIZE * SEGS];
+
+void
+test_main (void)
+{
+  struct iovec iov[SEGS];
+  int fd, i;
+
+  CHECK (create ("small", 0), "create \"small\"");
+  for (i = 0; i < OPEN_CNT; i++)
+    {
+      if ((fd = open ("small")) < 2)
+        fail ("open %d failed", i);
+      close (fd);
+    }
+  msg ("opened and closed \"small\" %d times", OPEN_CNT);
+
+  CHECK ((fd = open ("small")) > 1, "open \"small\"");
+  memset (buf, 'x', sizeof buf);
+  for (i = 0; i < IO_CNT; i++)
+    if (write (fd, buf, IO_SIZE) != IO_SIZE)
+      fail ("write %d failed", i);
+  seek (fd, 0);
+  for (i = 0; i < IO_CNT; i++)
+    if (read (fd, buf, IO_SIZE) != IO_SIZE)
+      fail ("read %d failed", i);
+  msg ("wrote and read %d %d-byte blocks", IO_CNT, IO_SIZE);
+
+  for (i = 0; i < SEGS; i++)
+    iov[i] = (struct iovec) {buf + i * IO_SIZE, IO_SIZE};
+  for (i = 0; i < VEC_CNT; i++)
+    {
+      seek (fd, i * IO_SIZE);
+      if (readv (fd, iov, SEGS) != (int) sizeof buf)
+        fail ("readv %d failed", i);
+    }
+  msg ("did %d readv() calls of %d segments", VEC_CNT, SEGS);
+  close (fd);
+}
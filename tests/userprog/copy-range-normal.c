@@ -0,0 +1,39 @@
+/* Copies bytes 100...299 of "sample.txt" to offset 50 of a new file
+   with copy_file_range(), giving both offsets explicitly, and checks
+   that the offsets moved, the file positions did not, and the data
+   arrived.  A copy between overlapping ranges of one file must
+   fail. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[250];
+
+void
+test_main (void) 
+{
+  off_t in_ofs = 100, out_ofs = 50;
+  int in, out;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", 0), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+  CHECK (copy_file_range (in, &in_ofs, out, &out_ofs, 200) == 200,
+         "copy 200 bytes");
+  if (in_ofs != 300 || out_ofs != 250)
+    fail ("offsets are %d and %d, expected 300 and 250", in_ofs, out_ofs);
+  if (tell (in) != 0 || tell (out) != 0)
+    fail ("copy_file_range() moved a file position");
+
+  CHECK (read (out, buf, sizeof buf) == sizeof buf, "read \"copy.txt\"");
+  if (memcmp (buf + 50, sample + 100, 200))
+    fail ("copied data differs");
+
+  in_ofs = 0;
+  out_ofs = 10;
+  CHECK (copy_file_range (out, &in_ofs, out, &out_ofs, 100) == -1,
+         "copy between overlapping ranges fails");
+}
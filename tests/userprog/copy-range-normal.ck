@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-normal) begin
+(copy-range-normal) open "sample.txt"
+(copy-range-normal) create "copy.txt"
+(copy-range-normal) open "copy.txt"
+(copy-range-normal) copy 200 bytes
+(copy-range-normal) read "copy.txt"
+(copy-range-normal) copy between overlapping ranges fails
+(copy-range-normal) end
+copy-range-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Copies the file named by the first command-line argument to a
+   new file named by the second, as cp would, with copy_file_range()
+   in pieces of at most 100 bytes, and checks the copy against
+   "sample.txt", which is what the test copies. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+
+int
+main (int argc, char *argv[]) 
+{
+  int in, out, n, total = 0;
+
+  test_name = "cp";
+  msg ("begin");
+  if (argc != 3)
+    fail ("usage: cp SOURCE DEST");
+
+  CHECK ((in = open (argv[1])) > 1, "open \"%s\"", argv[1]);
+  CHECK (create (argv[2], 0), "create \"%s\"", argv[2]);
+  CHECK ((out = open (argv[2])) > 1, "open \"%s\"", argv[2]);
+  while ((n = copy_file_range (in, NULL, out, NULL, 100)) > 0)
+    total += n;
+  if (n < 0)
+    fail ("copy_file_range() failed after %d bytes", total);
+  msg ("copied %d bytes", total);
+  if (tell (in) != (unsigned) total || tell (out) != (unsigned) total)
+    fail ("file positions %u and %u, expected %d",
+          tell (in), tell (out), total);
+  close (in);
+  close (out);
+
+  check_file (argv[2], sample, sizeof sample - 1);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(cp) begin
+(cp) open "sample.txt"
+(cp) create "copy.txt"
+(cp) open "copy.txt"
+(cp) copied 373 bytes
+(cp) open "copy.txt" for verification
+(cp) verified contents of "copy.txt"
+(cp) close "copy.txt"
+(cp) end
+cp: exit(0)
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Runs child-simple, which leaves its layout in the kernel's
+   executable cache, then overwrites its ELF header and runs it
+   again, which must fail, and finally removes it and tries once
+   more.  Neither later attempt may use the cached layout. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int handle;
+  pid_t pid;
+
+  CHECK ((pid = spawn ("child-simple", NULL, 0)) > 0, "spawn child-simple");
+  msg ("wait(spawn()) = %d", wait (pid));
+
+  CHECK ((handle = open ("child-simple")) > 1, "open \"child-simple\"");
+  CHECK (write (handle, "junk", 4) == 4, "overwrite ELF header");
+  close (handle);
+  CHECK (spawn ("child-simple", NULL, 0) == -1,
+         "spawn of corrupted child-simple fails");
+
+  CHECK (remove ("child-simple"), "remove \"child-simple\"");
+  CHECK (spawn ("child-simple", NULL, 0) == -1,
+         "spawn of removed child-simple fails");
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-stale) begin
+(exec-stale) spawn child-simple
+(child-simple) run
+child-simple: exit(81)
+(exec-stale) wait(spawn()) = 81
+(exec-stale) open "child-simple"
+(exec-stale) overwrite ELF header
+load: child-simple: error loading executable
+child-simple: exit(-1)
+(exec-stale) spawn of corrupted child-simple fails
+(exec-stale) remove "child-simple"
+load: child-simple: open failed
+child-simple: exit(-1)
+(exec-stale) spawn of removed child-simple fails
+(exec-stale) end
+exec-stale: exit(0)
+EOF
+pass;
@@ -0,0 +1,90 @@
+/* Opens "sample.txt", reads its two halves, writes a line to the
+   console, syncs and closes the file, all through an I/O ring.
+   Both halves are submitted with a single io_enter(). */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct io_ring ring __attribute__ ((aligned (4096)));
+static char buf[sizeof sample];
+
+/* Queues an operation in RING. */
+static void
+queue (int opcode, int fd, const void *addr, size_t len, int off,
+       int user_data)
+{
+  struct io_sqe *sqe = io_ring_get_sqe (&ring);
+
+  if (sqe == NULL)
+    fail ("submission queue full");
+  memset (sqe, 0, sizeof *sqe);
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t) addr;
+  sqe->len = len;
+  sqe->off = off;
+  sqe->user_data = user_data;
+  io_ring_push (&ring);
+}
+
+/* Takes the next completion from RING, which must have one, and
+   returns its result.  Stores its user data in *USER_DATA. */
+static int
+reap (int *user_data)
+{
+  struct io_cqe *cqe = io_ring_peek_cqe (&ring);
+  int res;
+
+  if (cqe == NULL)
+    fail ("completion missing");
+  *user_data = cqe->user_data;
+  res = cqe->res;
+  io_ring_cqe_seen (&ring);
+  return res;
+}
+
+void
+test_main (void) 
+{
+  static const char line[] = "(io-ring-normal) written through the ring\n";
+  size_t size = sizeof sample - 1, half = size / 2;
+  int fd, res, user_data, i;
+
+  CHECK (io_setup (&ring) == 0, "io_setup");
+  CHECK (io_setup (&ring) == -1, "second io_setup fails");
+
+  queue (IO_OP_OPEN, 0, "sample.txt", 0, 0, 1);
+  CHECK (io_enter (1, 1) == 1, "submit open");
+  fd = reap (&user_data);
+  if (user_data != 1 || fd < 2)
+    fail ("open completed with %d for %d", fd, user_data);
+
+  queue (IO_OP_PREAD, fd, buf + half, size - half, half, 2);
+  queue (IO_OP_PREAD, fd, buf, half, 0, 3);
+  CHECK (io_enter (2, 2) == 2, "submit two preads");
+  for (i = 0; i < 2; i++)
+    {
+      res = reap (&user_data);
+      if (res != (int) (user_data == 2 ? size - half : half))
+        fail ("pread %d completed with %d", user_data, res);
+    }
+  if (memcmp (buf, sample, size))
+    fail ("pread through the ring read wrong data");
+
+  queue (IO_OP_WRITE, STDOUT_FILENO, line, strlen (line), 0, 4);
+  CHECK (io_enter (1, 1) == 1, "submit console write");
+  if (reap (&user_data) != (int) strlen (line))
+    fail ("console write came up short");
+
+  queue (IO_OP_FSYNC, fd, NULL, 0, 0, 5);
+  queue (IO_OP_CLOSE, fd, NULL, 0, 0, 6);
+  CHECK (io_enter (2, 2) == 2, "submit fsync and close");
+  for (i = 5; i <= 6; i++)
+    if ((res = reap (&user_data)) != 0 || user_data != i)
+      fail ("operation %d completed with %d", user_data, res);
+  CHECK (read (fd, buf, 1) == -1, "file is closed");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(io-ring-normal) begin
+(io-ring-normal) io_setup
+(io-ring-normal) second io_setup fails
+(io-ring-normal) submit open
+(io-ring-normal) submit two preads
+(io-ring-normal) written through the ring
+(io-ring-normal) submit console write
+(io-ring-normal) submit fsync and close
+(io-ring-normal) file is closed
+(io-ring-normal) end
+io-ring-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,55 @@
+/* Creates a pipe and forks a child that writes several pages of
+   data into it, more than the pipe holds at once, and then exits.
+   The parent moves the read end onto its standard input with
+   dup2(), reads everything back from fd 0 until end of file, and
+   checks the data. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DATA_SIZE (3 * 4096 + 123)
+
+static char buf[DATA_SIZE];
+
+void
+test_main (void)
+{
+  int fds[2];
+  size_t ofs;
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "pipe returned two new fds");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      for (ofs = 0; ofs < DATA_SIZE; ofs++)
+        buf[ofs] = ofs % 251;
+      if (write (fds[1], buf, DATA_SIZE) != DATA_SIZE)
+        exit (1);
+      exit (0);
+    }
+  CHECK (pid > 0, "fork");
+  close (fds[1]);
+
+  CHECK (dup2 (fds[0], 0) == 0, "dup2 read end onto stdin");
+  close (fds[0]);
+  for (ofs = 0; ofs < DATA_SIZE; ofs += n)
+    {
+      n = read (0, buf + ofs, DATA_SIZE - ofs);
+      if (n <= 0)
+        fail ("read returned %d after %zu bytes", n, ofs);
+    }
+  CHECK (read (0, buf, 1) == 0, "read at end of file");
+  for (ofs = 0; ofs < DATA_SIZE; ofs++)
+    if (buf[ofs] != (char) (ofs % 251))
+      fail ("byte %zu differs", ofs);
+  msg ("read %d bytes", DATA_SIZE);
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (write (0, buf, 1) == 0, "write to read end");
+}
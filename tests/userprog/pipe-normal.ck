@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(pipe-normal) begin
+(pipe-normal) pipe
+(pipe-normal) pipe returned two new fds
+(pipe-normal) fork
+(pipe-normal) dup2 read end onto stdin
+(pipe-normal) read at end of file
+(pipe-normal) read 12411 bytes
+(pipe-normal) wait for child
+(pipe-normal) write to read end
+(pipe-normal) end
+EOF
+pass;
@@ -0,0 +1,56 @@
+/* Checks what poll() reports for the ends of a pipe as data comes
+   and goes and ends are closed, that it times out when nothing
+   happens, that it flags descriptors that are not open, and that a
+   poll() with no timeout wakes up when a child writes to the
+   pipe. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct pollfd pfds[3];
+  int fds[2];
+  char c;
+  pid_t pid;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  pfds[0].fd = fds[0];
+  pfds[0].events = POLLIN;
+  pfds[1].fd = fds[1];
+  pfds[1].events = POLLOUT;
+  pfds[2].fd = -1;
+  pfds[2].events = POLLIN;
+
+  CHECK (poll (pfds, 1, 5) == 0 && pfds[0].revents == 0,
+         "empty read end times out");
+  CHECK (poll (pfds, 3, 0) == 1 && pfds[0].revents == 0
+         && pfds[1].revents == POLLOUT && pfds[2].revents == 0,
+         "write end is writable");
+  CHECK (write (fds[1], "x", 1) == 1, "write a byte");
+  CHECK (poll (pfds, 2, -1) == 2 && pfds[0].revents == POLLIN
+         && pfds[1].revents == POLLOUT, "read end is readable");
+  CHECK (read (fds[0], &c, 1) == 1 && c == 'x', "read the byte");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      write (fds[1], "y", 1);
+      exit (0);
+    }
+  CHECK (pid > 0, "fork");
+  close (fds[1]);
+  CHECK (poll (pfds, 1, -1) == 1 && (pfds[0].revents & POLLIN),
+         "poll wakes up for the child's byte");
+  CHECK (read (fds[0], &c, 1) == 1 && c == 'y', "read the child's byte");
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (poll (pfds, 1, -1) == 1 && pfds[0].revents == POLLHUP,
+         "read end hangs up once the write ends close");
+
+  pfds[1].fd = fds[1];
+  CHECK (poll (pfds + 1, 1, 0) == 1 && pfds[1].revents == POLLNVAL,
+         "closed fd is invalid");
+}
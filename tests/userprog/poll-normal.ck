@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(poll-normal) begin
+(poll-normal) pipe
+(poll-normal) empty read end times out
+(poll-normal) write end is writable
+(poll-normal) write a byte
+(poll-normal) read end is readable
+(poll-normal) read the byte
+(poll-normal) fork
+(poll-normal) poll wakes up for the child's byte
+(poll-normal) read the child's byte
+(poll-normal) wait for child
+(poll-normal) read end hangs up once the write ends close
+(poll-normal) closed fd is invalid
+(poll-normal) end
+EOF
+pass;
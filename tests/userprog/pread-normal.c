@@ -0,0 +1,39 @@
+/* Writes the two halves of "sample.txt"'s contents into a new file
+   with pwrite(), second half first, and reads them back with
+   pread() in the same order.  Neither may move the file
+   position. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[sizeof sample];
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1, half = size / 2;
+  int handle;
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  CHECK (pwrite (handle, sample + half, size - half, half)
+         == (int) (size - half), "pwrite second half");
+  CHECK (pwrite (handle, sample, half, 0) == (int) half, "pwrite first half");
+  if (tell (handle) != 0)
+    fail ("pwrite() moved the file position to %u", tell (handle));
+  CHECK (filesize (handle) == (int) size, "check file size");
+
+  CHECK (pread (handle, buf + half, size - half, half) == (int) (size - half),
+         "pread second half");
+  CHECK (pread (handle, buf, half, 0) == (int) half, "pread first half");
+  if (tell (handle) != 0)
+    fail ("pread() moved the file position to %u", tell (handle));
+  if (memcmp (buf, sample, size))
+    fail ("pread() read wrong data");
+  CHECK (pread (handle, buf, 10, size) == 0, "pread at end of file");
+  msg ("close \"test.txt\"");
+  close (handle);
+}
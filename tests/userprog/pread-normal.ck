@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-normal) begin
+(pread-normal) create "test.txt"
+(pread-normal) open "test.txt"
+(pread-normal) pwrite second half
+(pread-normal) pwrite first half
+(pread-normal) check file size
+(pread-normal) pread second half
+(pread-normal) pread first half
+(pread-normal) pread at end of file
+(pread-normal) close "test.txt"
+(pread-normal) end
+pread-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,19 @@
+/* Passes readv() a segment with a kernel address.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[16];
+
+void
+test_main (void) 
+{
+  struct iovec iov[] = {{buf, sizeof buf}, {(char *) 0xc0100000, 123}};
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  readv (handle, iov, 2);
+  fail ("should not have survived readv()");
+}
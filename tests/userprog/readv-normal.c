@@ -0,0 +1,31 @@
+/* Reads "sample.txt" with one readv() into three buffers of
+   different sizes, and checks that they hold the file in order and
+   that the file position moved past it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char a[10], b[100], c[sizeof sample];
+
+void
+test_main (void) 
+{
+  struct iovec iov[] = {{a, sizeof a}, {b, sizeof b}, {c, sizeof c}};
+  size_t size = sizeof sample - 1;
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("readv() returned %d instead of %zu", byte_cnt, size);
+  if (memcmp (a, sample, sizeof a)
+      || memcmp (b, sample + sizeof a, sizeof b)
+      || memcmp (c, sample + sizeof a + sizeof b, size - sizeof a - sizeof b))
+    fail ("readv() read wrong data");
+  if (tell (handle) != size)
+    fail ("tell() returned %u instead of %zu", tell (handle), size);
+  msg ("verified contents of \"sample.txt\"");
+}
@@ -0,0 +1,25 @@
+/* Writes a line to a file, then sends the file to the console with
+   sendfile(), starting at the current position of the file. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  static const char line[] = "(sendfile-stdout) sent from a file\n";
+  int handle;
+
+  CHECK (create ("line.txt", 0), "create \"line.txt\"");
+  CHECK ((handle = open ("line.txt")) > 1, "open \"line.txt\"");
+  CHECK (write (handle, line, strlen (line)) == (int) strlen (line),
+         "write \"line.txt\"");
+  seek (handle, 0);
+  if (sendfile (STDOUT_FILENO, handle, NULL, 100) != (int) strlen (line))
+    fail ("sendfile() did not send the whole file");
+  if (tell (handle) != strlen (line))
+    fail ("sendfile() left the file position at %u", tell (handle));
+}
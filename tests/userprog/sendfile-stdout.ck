@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sendfile-stdout) begin
+(sendfile-stdout) create "line.txt"
+(sendfile-stdout) open "line.txt"
+(sendfile-stdout) write "line.txt"
+(sendfile-stdout) sent from a file
+(sendfile-stdout) end
+sendfile-stdout: exit(0)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Starts programs with spawn(): one that exits at once, one that
+   gets an open file moved to another descriptor and closes it, and
+   one that does not exist.  The parent's own descriptor must be
+   unaffected by what the child does to its copy. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_FD 9
+
+void
+test_main (void)
+{
+  struct spawn_action actions[2];
+  char child_cmd[128];
+  int handle;
+  pid_t pid;
+
+  CHECK ((pid = spawn ("child-simple", NULL, 0)) > 0, "spawn child-simple");
+  msg ("wait(spawn()) = %d", wait (pid));
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  actions[0] = (struct spawn_action) {SPAWN_DUP2, handle, CHILD_FD};
+  actions[1] = (struct spawn_action) {SPAWN_CLOSE, handle, 0};
+  snprintf (child_cmd, sizeof child_cmd, "child-close %d", CHILD_FD);
+  CHECK ((pid = spawn (child_cmd, actions, 2)) > 0, "spawn child-close");
+  msg ("wait(spawn()) = %d", wait (pid));
+  check_file_handle (handle, "sample.txt", sample, sizeof sample - 1);
+
+  actions[0] = (struct spawn_action) {SPAWN_CLOSE, CHILD_FD, 0};
+  CHECK (spawn ("child-simple", actions, 1) == -1,
+         "spawn with a bad file action fails");
+  CHECK (spawn ("no-such-file", NULL, 0) == -1,
+         "spawn of a missing program fails");
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(spawn-normal) begin
+(spawn-normal) spawn child-simple
+(child-simple) run
+child-simple: exit(81)
+(spawn-normal) wait(spawn()) = 81
+(spawn-normal) open "sample.txt"
+(spawn-normal) spawn child-close
+(child-close) begin
+(child-close) verified contents of "sample.txt"
+(child-close) end
+child-close: exit(0)
+(spawn-normal) wait(spawn()) = 0
+(spawn-normal) verified contents of "sample.txt"
+child-simple: exit(-1)
+(spawn-normal) spawn with a bad file action fails
+load: no-such-file: open failed
+no-such-file: exit(-1)
+(spawn-normal) spawn of a missing program fails
+(spawn-normal) end
+spawn-normal: exit(0)
+EOF
+pass;
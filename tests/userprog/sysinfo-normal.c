@@ -0,0 +1,53 @@
+/* Reads the clock and CPU time counters from the kernel data pages
+   while spinning for a few timer ticks, and checks that they move
+   forward together.  Then checks that a forked child gets CPU time
+   counters of its own and that it is killed for writing to the
+   pages. */
+
+#include <sysinfo.h>
+#include <syscall.h>
+#include <vdata.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Timer ticks to spin for. */
+#define SPIN_TICKS 3
+
+void
+test_main (void)
+{
+  int64_t start_ticks, start_usecs, prev, now, user, kernel, user0, kernel0;
+  pid_t pid;
+
+  sysinfo_cpu_ticks (&user0, &kernel0);
+  start_ticks = sysinfo_ticks ();
+  start_usecs = prev = sysinfo_usecs ();
+  while (sysinfo_ticks () < start_ticks + SPIN_TICKS)
+    {
+      now = sysinfo_usecs ();
+      if (now < prev)
+        fail ("clock went back from %lld to %lld us",
+              (long long) prev, (long long) now);
+      prev = now;
+    }
+  msg ("clock never went back");
+  CHECK (prev - start_usecs >= (SPIN_TICKS - 1) * 10000,
+         "clock moved at least %d ticks' worth", SPIN_TICKS - 1);
+  sysinfo_cpu_ticks (&user, &kernel);
+  CHECK (user > user0 && kernel >= kernel0, "process was charged CPU time");
+  CHECK (sysinfo_load_avg () >= 0, "load average is not negative");
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      int64_t child_user, child_kernel;
+
+      sysinfo_cpu_ticks (&child_user, &child_kernel);
+      if (child_user >= user)
+        exit (1);
+      *(volatile int64_t *) VDATA_ADDR = 0;
+      exit (2);
+    }
+  CHECK (pid > 0, "fork");
+  CHECK (wait (pid) == -1, "child was killed writing to the data page");
+}
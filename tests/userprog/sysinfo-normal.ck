@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(sysinfo-normal) begin
+(sysinfo-normal) clock never went back
+(sysinfo-normal) clock moved at least 2 ticks' worth
+(sysinfo-normal) process was charged CPU time
+(sysinfo-normal) load average is not negative
+(sysinfo-normal) fork
+(sysinfo-normal) child was killed writing to the data page
+(sysinfo-normal) end
+EOF
+pass;
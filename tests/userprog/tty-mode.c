@@ -0,0 +1,21 @@
+/* Switches the console to non-blocking raw input and checks that,
+   with no input typed, reading from the console returns at once
+   with nothing, and that tty_poll() reports nothing to read.  Then
+   restores the default mode. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[16];
+
+  CHECK (tty_mode (TTY_RAW | TTY_NONBLOCK) == 0, "tty_mode starts at 0");
+  CHECK (tty_poll () == 0, "tty_poll finds no input");
+  CHECK (read (0, buf, sizeof buf) == 0,
+         "non-blocking read returns 0");
+  CHECK (tty_mode (0) == (TTY_RAW | TTY_NONBLOCK),
+         "tty_mode returns the previous mode");
+}
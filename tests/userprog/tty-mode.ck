@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(tty-mode) begin
+(tty-mode) tty_mode starts at 0
+(tty-mode) tty_poll finds no input
+(tty-mode) non-blocking read returns 0
+(tty-mode) tty_mode returns the previous mode
+(tty-mode) end
+tty-mode: exit(0)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Forks many children that all exit before their parent waits for
+   any of them, then reaps them newest first and checks each exit
+   status.  A few are never waited for, so the parent exits with
+   their exit records still outstanding. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 64
+#define UNREAPED_CNT 4
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      children[i] = fork ("child");
+      if (children[i] == 0)
+        exit (i);
+      if (children[i] < 0)
+        fail ("fork child %d", i);
+    }
+  msg ("forked %d children", CHILD_CNT);
+
+  for (i = CHILD_CNT - 1; i >= UNREAPED_CNT; i--)
+    {
+      int status = wait (children[i]);
+      if (status != i)
+        fail ("wait for child %d returned %d", i, status);
+      if (wait (children[i]) != -1)
+        fail ("second wait for child %d did not fail", i);
+    }
+  msg ("reaped %d children", CHILD_CNT - UNREAPED_CNT);
+}
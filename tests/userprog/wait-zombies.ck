@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(wait-zombies) begin
+(wait-zombies) forked 64 children
+(wait-zombies) reaped 60 children
+(wait-zombies) end
+EOF
+pass;
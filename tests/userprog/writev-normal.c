@@ -0,0 +1,26 @@
+/* Writes "sample.txt"'s contents into a new file with one writev()
+   from three pieces, then reads the file back to check it. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  struct iovec iov[] = {{sample, 1}, {sample + 1, 200},
+                        {sample + 201, size - 201}};
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", 0), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("writev() returned %d instead of %zu", byte_cnt, size);
+  msg ("close \"test.txt\"");
+  close (handle);
+
+  check_file ("test.txt", sample, size);
+}
@@ -0,0 +1,109 @@
+/* Forks 4 processes that each take a lock shared through a shared
+   memory segment 100,000 times, incrementing a shared counter while
+   they hold it.  Run it as "bench-futex MODE", where MODE selects
+   the lock:
+
+     mutex  the futex-based mutex from lib/user/sync.c, which sleeps
+            in the kernel when the lock is taken;
+     spin   a test-and-set spin lock, which spins until the holder
+            runs again and lets go;
+     pipe   a token passed through a pipe, so that every acquire and
+            release is a system call.
+
+   The mutex makes no system call unless a process is preempted
+   while holding it, and a process that then finds it taken gives
+   up the CPU rather than spinning out its time slice. */
+
+#include <string.h>
+#include <sync.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-futex";
+
+#define PROC_CNT 4
+#define ITER_CNT 100000
+
+struct shared
+  {
+    struct mutex mutex;
+    int spin;
+    int counter;
+  };
+
+#define SHARED ((struct shared *) 0x10000000)
+
+static int fds[2];
+
+static void
+acquire (const char *mode)
+{
+  char token;
+
+  if (!strcmp (mode, "mutex"))
+    mutex_lock (&SHARED->mutex);
+  else if (!strcmp (mode, "spin"))
+    while (__atomic_exchange_n (&SHARED->spin, 1, __ATOMIC_SEQ_CST))
+      continue;
+  else if (read (fds[0], &token, 1) != 1)
+    fail ("read of token failed");
+}
+
+static void
+release (const char *mode)
+{
+  if (!strcmp (mode, "mutex"))
+    mutex_unlock (&SHARED->mutex);
+  else if (!strcmp (mode, "spin"))
+    __atomic_store_n (&SHARED->spin, 0, __ATOMIC_SEQ_CST);
+  else if (write (fds[1], "t", 1) != 1)
+    fail ("write of token failed");
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "mutex";
+  pid_t children[PROC_CNT];
+  int id, i, j;
+
+  msg ("begin");
+  if (strcmp (mode, "mutex") && strcmp (mode, "spin")
+      && strcmp (mode, "pipe"))
+    fail ("unknown mode \"%s\"", mode);
+  id = shm_open ("bench-futex", sizeof (struct shared));
+  if (id < 0 || shm_map (id, SHARED, true) == MAP_FAILED)
+    fail ("mapping shared memory failed");
+  mutex_init (&SHARED->mutex);
+  if (!strcmp (mode, "pipe"))
+    {
+      CHECK (pipe (fds) == 0, "pipe");
+      CHECK (write (fds[1], "t", 1) == 1, "write first token");
+    }
+
+  for (i = 0; i < PROC_CNT; i++)
+    {
+      children[i] = fork ("bench-futex");
+      if (children[i] == 0)
+        {
+          for (j = 0; j < ITER_CNT; j++)
+            {
+              acquire (mode);
+              SHARED->counter++;
+              release (mode);
+            }
+          exit (0);
+        }
+      if (children[i] < 0)
+        fail ("fork failed");
+    }
+  for (i = 0; i < PROC_CNT; i++)
+    if (wait (children[i]) != 0)
+      fail ("child %d failed", i);
+  if (SHARED->counter != PROC_CNT * ITER_CNT)
+    fail ("counter is %d, expected %d", SHARED->counter,
+          PROC_CNT * ITER_CNT);
+  msg ("%d increments under %s", SHARED->counter, mode);
+  msg ("end");
+  return 0;
+}
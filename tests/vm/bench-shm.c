@@ -0,0 +1,156 @@
+/* Moves 100 MB from a forked child to its parent through a 256 kB
+   ring buffer and checks that every byte arrives.  Run it as
+   "bench-shm MODE", where MODE selects where the ring lives:
+
+     shm   a shared memory segment both processes map;
+     file  a file both processes pread() and pwrite().
+
+   The producer and consumer poll the ring's indexes, so each runs
+   until the ring is full or empty and the scheduler then switches
+   to the other.  With shared memory the data is copied once each
+   way and never reaches the disk. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "bench-shm";
+
+#define TOTAL_SIZE (100 * 1024 * 1024)
+#define RING_SIZE (256 * 1024)
+#define CHUNK_SIZE 4096
+
+/* Indexes of the ring, in bytes, that only ever grow. */
+struct ring_hdr
+  {
+    unsigned head;              /* Next byte the consumer reads. */
+    unsigned tail;              /* Next byte the producer writes. */
+  };
+
+#define SEG ((char *) 0x10000000)
+
+static bool use_shm;
+static int fd;
+static char chunk[CHUNK_SIZE];
+
+/* Returns the ring's indexes. */
+static struct ring_hdr
+get_hdr (void)
+{
+  struct ring_hdr hdr;
+
+  if (use_shm)
+    {
+      hdr = *(volatile struct ring_hdr *) SEG;
+      asm volatile ("" : : : "memory");
+    }
+  else if (pread (fd, &hdr, sizeof hdr, 0) != sizeof hdr)
+    fail ("pread of ring indexes failed");
+  return hdr;
+}
+
+/* Sets the ring index at byte OFS of the header to VALUE. */
+static void
+set_index (size_t ofs, unsigned value)
+{
+  if (use_shm)
+    {
+      asm volatile ("" : : : "memory");
+      *(volatile unsigned *) (SEG + ofs) = value;
+    }
+  else if (pwrite (fd, &value, sizeof value, ofs) != sizeof value)
+    fail ("pwrite of ring index failed");
+}
+
+/* Copies CHUNK into or out of the ring at byte POS. */
+static void
+move_chunk (unsigned pos, bool to_ring)
+{
+  size_t ofs = sizeof (struct ring_hdr) + pos % RING_SIZE;
+
+  if (use_shm)
+    {
+      if (to_ring)
+        memcpy (SEG + ofs, chunk, CHUNK_SIZE);
+      else
+        memcpy (chunk, SEG + ofs, CHUNK_SIZE);
+    }
+  else if ((to_ring ? pwrite (fd, chunk, CHUNK_SIZE, ofs)
+            : pread (fd, chunk, CHUNK_SIZE, ofs)) != CHUNK_SIZE)
+    fail ("ring I/O failed");
+}
+
+static void
+produce (void)
+{
+  unsigned tail;
+
+  for (tail = 0; tail < TOTAL_SIZE; tail += CHUNK_SIZE)
+    {
+      while (tail - get_hdr ().head == RING_SIZE)
+        continue;
+      memset (chunk, tail / CHUNK_SIZE, CHUNK_SIZE);
+      move_chunk (tail, true);
+      set_index (offsetof (struct ring_hdr, tail), tail + CHUNK_SIZE);
+    }
+}
+
+static void
+consume (void)
+{
+  unsigned head;
+
+  for (head = 0; head < TOTAL_SIZE; head += CHUNK_SIZE)
+    {
+      char expected = head / CHUNK_SIZE;
+
+      while (get_hdr ().tail == head)
+        continue;
+      move_chunk (head, false);
+      if (chunk[0] != expected || chunk[CHUNK_SIZE - 1] != expected)
+        fail ("chunk at byte %u is corrupt", head);
+      set_index (offsetof (struct ring_hdr, head), head + CHUNK_SIZE);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *mode = argc > 1 ? argv[1] : "shm";
+  size_t size = sizeof (struct ring_hdr) + RING_SIZE;
+  pid_t pid;
+
+  msg ("begin");
+  if (!strcmp (mode, "shm"))
+    {
+      int id = shm_open ("bench-shm", size);
+      use_shm = true;
+      if (id < 0 || shm_map (id, SEG, true) == MAP_FAILED)
+        fail ("mapping shared memory failed");
+    }
+  else if (!strcmp (mode, "file"))
+    {
+      static char zeros[sizeof (struct ring_hdr)];
+      CHECK (create ("ring", size), "create \"ring\"");
+      CHECK ((fd = open ("ring")) > 1, "open \"ring\"");
+      CHECK (write (fd, zeros, sizeof zeros) == sizeof zeros,
+             "zero ring indexes");
+    }
+  else
+    fail ("unknown mode \"%s\"", mode);
+
+  pid = fork ("bench-shm");
+  if (pid == 0)
+    {
+      produce ();
+      exit (0);
+    }
+  if (pid < 0)
+    fail ("fork failed");
+  consume ();
+  if (wait (pid) != 0)
+    fail ("producer failed");
+  msg ("moved %d bytes through %s", TOTAL_SIZE, mode);
+  msg ("end");
+  return 0;
+}
@@ -0,0 +1,79 @@
+/* Forks several children that share a counter in a shared memory
+   segment and increment it under a futex-based mutex, then tell
+   the parent through a condition variable that they are done.
+   Checks that no increment was lost, and checks the results of
+   futex() calls that must not sleep. */
+
+#include <sync.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+#define INC_CNT 20000
+
+struct shared
+  {
+    struct mutex mutex;
+    struct cond done_cond;
+    int counter;
+    int done_cnt;
+  };
+
+#define SHARED ((struct shared *) 0x10000000)
+
+void
+test_main (void)
+{
+  struct shared *s = SHARED;
+  pid_t children[CHILD_CNT];
+  int id, i;
+
+  CHECK ((id = shm_open ("futex-cond", sizeof *s)) >= 0, "shm_open");
+  CHECK (shm_map (id, s, true) == s, "shm_map");
+  mutex_init (&s->mutex);
+  cond_init (&s->done_cond);
+
+  CHECK (futex (&s->counter, FUTEX_WAIT, 1, NULL) == -1,
+         "FUTEX_WAIT on a changed value returns at once");
+  CHECK (futex (&s->counter, FUTEX_WAKE, 1, NULL) == 0,
+         "FUTEX_WAKE with no waiters wakes none");
+  CHECK (futex ((int *) ((char *) &s->counter + 1), FUTEX_WAKE, 1, NULL)
+         == -1, "misaligned futex fails");
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      children[i] = fork ("child");
+      if (children[i] == 0)
+        {
+          int j;
+
+          for (j = 0; j < INC_CNT; j++)
+            {
+              mutex_lock (&s->mutex);
+              s->counter++;
+              mutex_unlock (&s->mutex);
+            }
+          mutex_lock (&s->mutex);
+          s->done_cnt++;
+          cond_signal (&s->done_cond);
+          mutex_unlock (&s->mutex);
+          exit (0);
+        }
+      if (children[i] < 0)
+        fail ("fork child %d", i);
+    }
+
+  mutex_lock (&s->mutex);
+  while (s->done_cnt < CHILD_CNT)
+    cond_wait (&s->done_cond, &s->mutex);
+  mutex_unlock (&s->mutex);
+  msg ("all children done");
+
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (children[i]) != 0)
+      fail ("child %d failed", i);
+  if (s->counter != CHILD_CNT * INC_CNT)
+    fail ("counter is %d, expected %d", s->counter, CHILD_CNT * INC_CNT);
+  msg ("counter is %d", s->counter);
+}
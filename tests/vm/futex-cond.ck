@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-cond) begin
+(futex-cond) shm_open
+(futex-cond) shm_map
+(futex-cond) FUTEX_WAIT on a changed value returns at once
+(futex-cond) FUTEX_WAKE with no waiters wakes none
+(futex-cond) misaligned futex fails
+(futex-cond) all children done
+(futex-cond) counter is 80000
+(futex-cond) end
+EOF
+pass;
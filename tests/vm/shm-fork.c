@@ -0,0 +1,55 @@
+/* Maps a shared memory segment, forks, and checks that what the
+   child writes to the segment shows up in the parent, and what the
+   parent wrote before forking shows up in the child.  Then opens the
+   segment again by name, maps it a second time elsewhere, and
+   checks that both mappings see the same memory.  Finally checks
+   that an I/O ring cannot live in the segment, which munmap() could
+   free under it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SEG_SIZE (3 * 4096)
+#define FIRST ((char *) 0x10000000)
+#define SECOND ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  pid_t child;
+  int id;
+
+  CHECK ((id = shm_open ("shm-fork", SEG_SIZE)) >= 0, "shm_open");
+  CHECK (shm_map (id, FIRST, true) == FIRST, "shm_map");
+  CHECK (FIRST[0] == 0 && FIRST[SEG_SIZE - 1] == 0, "segment starts zeroed");
+  strlcpy (FIRST, "from parent", 16);
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      if (strcmp (FIRST, "from parent"))
+        exit (1);
+      strlcpy (FIRST + SEG_SIZE - 16, "from child", 16);
+      exit (0);
+    }
+  CHECK (child > 0, "fork");
+  CHECK (wait (child) == 0, "wait for child");
+  CHECK (!strcmp (FIRST + SEG_SIZE - 16, "from child"),
+         "child's write is visible");
+
+  CHECK (shm_open ("shm-fork", SEG_SIZE + 1) == -1,
+         "shm_open larger than the segment fails");
+  CHECK (shm_open ("shm-fork", 1) == id, "shm_open again");
+  CHECK (shm_map (id, SECOND, false) == SECOND, "shm_map elsewhere");
+  FIRST[4096] = 'x';
+  CHECK (SECOND[4096] == 'x', "both mappings share memory");
+  CHECK (shm_map (id, SECOND + 4096, true) == MAP_FAILED,
+         "overlapping shm_map fails");
+  munmap (FIRST);
+  CHECK (!strcmp (SECOND, "from parent"), "second mapping survives munmap");
+  CHECK (shm_map (id, FIRST, true) == FIRST, "shm_map writable again");
+  CHECK (io_setup ((struct io_ring *) FIRST) == -1,
+         "io_setup on shared memory fails");
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-fork) begin
+(shm-fork) shm_open
+(shm-fork) shm_map
+(shm-fork) segment starts zeroed
+(shm-fork) fork
+(shm-fork) wait for child
+(shm-fork) child's write is visible
+(shm-fork) shm_open larger than the segment fails
+(shm-fork) shm_open again
+(shm-fork) shm_map elsewhere
+(shm-fork) both mappings share memory
+(shm-fork) overlapping shm_map fails
+(shm-fork) second mapping survives munmap
+(shm-fork) shm_map writable again
+(shm-fork) io_setup on shared memory fails
+(shm-fork) end
+EOF
+pass;
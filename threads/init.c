@@ -23,6 +23,9 @@
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/exec-cache.h"
+#include "userprog/futex.h"
+#include "userprog/vdata.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
@@ -36,6 +39,8 @@
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
+#include "filesys/inode.h"
+#include "filesys/journal.h"
 #endif
 
 /* Page-map-level-4 with kernel mappings only. */
@@ -105,6 +110,10 @@ int main(void)
 #ifdef USERPROG
 	exception_init();
 	syscall_init();
+	process_init_records();
+	exec_cache_init();
+	futex_init();
+	vdata_init();
 #endif
 	// 스레드 스케줄러 시작 및 인터럽트 활성화
 	thread_start(); // 가장 실행 우선 순위가 낮은 idle이라는 스레드를 생성하고 실행한다.
@@ -222,6 +231,12 @@ static char **parse_options(char **argv)
 #ifdef FILESYS
 		else if (!strcmp(name, "-f"))
 			format_filesys = true;
+		else if (!strcmp(name, "-delalloc"))
+			inode_delalloc = true;
+		else if (!strcmp(name, "-pio"))
+			disk_pio = true;
+		else if (!strcmp(name, "-fifo"))
+			disk_fifo = true;
 #endif
 		else if (!strcmp(name, "-rs"))
 			random_init(atoi(value));
@@ -282,6 +297,8 @@ static void run_actions(char **argv)
 		{"rm", 2, fsutil_rm},
 		{"put", 2, fsutil_put},
 		{"get", 2, fsutil_get},
+		{"frag", 1, fsutil_frag},
+		{"du", 1, fsutil_du},
 #endif
 		{NULL, 0, NULL},
 	};
@@ -326,6 +343,8 @@ static void usage(void)
 		   "  ls                 List files in the root directory.\n"
 		   "  cat FILE           Print FILE to the console.\n"
 		   "  rm FILE            Delete FILE.\n"
+		   "  frag               Report fragmentation of files in the root directory.\n"
+		   "  du                 Report allocated and logical size of those files.\n"
 		   "Use these actions indirectly via `pintos' -g and -p options:\n"
 		   "  put FILE           Put FILE into file system from scratch disk.\n"
 		   "  get FILE           Get FILE from file system into scratch disk.\n"
@@ -334,6 +353,9 @@ static void usage(void)
 		   "  -h                 Print this help message and power off.\n"
 		   "  -q                 Power off VM after actions or on panic.\n"
 		   "  -f                 Format file system disk during startup.\n"
+		   "  -delalloc          Allocate file data on flush, not on write.\n"
+		   "  -pio               Move disk data by programmed I/O, not DMA.\n"
+		   "  -fifo              Serve disk requests in arrival order.\n"
 		   "  -rs=SEED           Set random number seed to SEED.\n"
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
@@ -366,6 +388,7 @@ static void print_stats(void)
 	thread_print_stats();
 #ifdef FILESYS
 	disk_print_stats();
+	journal_print_stats();
 #endif
 	console_print_stats();
 	kbd_print_stats();
@@ -275,7 +275,8 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 
 	if (pages) {
 		if (flags & PAL_ZERO)
-			memset (pages, 0, PGSIZE * page_cnt);
+			for (size_t i = 0; i < page_cnt; i++)
+				clear_page (pages + PGSIZE * i);
 	} else {
 		if (flags & PAL_ASSERT)
 			PANIC ("palloc_get: out of pages");
@@ -356,3 +357,25 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Fills PAGE, a page-aligned kernel page, with zeros. */
+void
+clear_page (void *page) {
+	size_t words = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (page) == 0);
+	asm volatile ("rep stosq"
+			: "+D" (page), "+c" (words) : "a" (0) : "memory");
+}
+
+/* Copies page SRC to page DST.  Both must be page-aligned kernel
+   pages. */
+void
+copy_page (void *dst, const void *src) {
+	size_t words = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (dst) == 0);
+	ASSERT (pg_ofs (src) == 0);
+	asm volatile ("rep movsq"
+			: "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+}
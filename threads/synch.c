@@ -370,4 +370,102 @@ bool cond_priority(const struct list_elem *a, const struct list_elem  *b, void *
     struct thread *t_a = list_entry(list_begin(&sema_a->semaphore.waiters), struct thread, elem);
     struct thread *t_b = list_entry(list_begin(&sema_b->semaphore.waiters), struct thread, elem);
     return t_a->priority > t_b->priority;
+}
+
+/* Initializes W for the current thread, not yet woken.  Put it on
+   the poll queues of everything the thread waits for with
+   poll_queue_add(), check each thing, and then, if none is ready,
+   sleep with poll_waiter_sleep().  A wakeup after the check is not
+   lost, since it sets WOKEN and poll_waiter_sleep() then returns at
+   once. */
+void
+poll_waiter_init (struct poll_waiter *w) {
+	w->thread = thread_current ();
+	w->woken = w->sleeping = w->timed = false;
+}
+
+/* Sleeps until a queue W is on is woken, or until the timer reaches
+   DEADLINE ticks, unless DEADLINE is negative.  Returns true if a
+   queue was woken, false on timeout.  Clears W's wakeup, so that
+   the caller can check its queues again and sleep anew. */
+bool
+poll_waiter_sleep (struct poll_waiter *w, int64_t deadline) {
+	enum intr_level old_level = intr_disable ();
+	bool woken;
+
+	ASSERT (w->thread == thread_current ());
+	if (!w->woken) {
+		w->sleeping = true;
+		w->timed = deadline >= 0;
+		if (w->timed)
+			thread_sleep (deadline);
+		else
+			thread_block ();
+		w->sleeping = w->timed = false;
+	}
+	woken = w->woken;
+	w->woken = false;
+	intr_set_level (old_level);
+	return woken;
+}
+
+/* Initializes Q with no waiters. */
+void
+poll_queue_init (struct poll_queue *q) {
+	list_init (&q->entries);
+}
+
+/* Puts waiter W on Q through E, which must stay put until it is
+   taken off with poll_queue_remove(). */
+void
+poll_queue_add (struct poll_queue *q, struct poll_entry *e,
+		struct poll_waiter *w) {
+	enum intr_level old_level = intr_disable ();
+
+	e->queue = q;
+	e->waiter = w;
+	list_push_back (&q->entries, &e->elem);
+	intr_set_level (old_level);
+}
+
+/* Takes E off its poll queue, if it is on one. */
+void
+poll_queue_remove (struct poll_entry *e) {
+	enum intr_level old_level = intr_disable ();
+
+	if (e->queue != NULL) {
+		list_remove (&e->elem);
+		e->queue = NULL;
+	}
+	intr_set_level (old_level);
+}
+
+/* Wakes every waiter on Q.  The waiters stay on Q.  May be called
+   from an interrupt handler. */
+void
+poll_queue_wake (struct poll_queue *q) {
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	if (list_empty (&q->entries))
+		return;
+	old_level = intr_disable ();
+	for (e = list_begin (&q->entries); e != list_end (&q->entries);
+			e = list_next (e)) {
+		struct poll_waiter *w = list_entry (e, struct poll_entry, elem)->waiter;
+
+		if (w->woken)
+			continue;
+		w->woken = true;
+		/* A thread the timer already woke is READY and needs
+		   nothing more. */
+		if (w->sleeping && w->thread->status == THREAD_BLOCKED) {
+			if (w->timed)
+				thread_cancel_sleep (w->thread);
+			else
+				thread_unblock (w->thread);
+		}
+	}
+	intr_set_level (old_level);
+	thread_try_yield ();
 }
\ No newline at end of file
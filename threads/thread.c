@@ -238,20 +238,19 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
 
 	#ifdef USERPROG
 	/* Project 2: File Descriptor Table init */
-	t->fdt = (struct file **)palloc_get_multiple(PAL_ZERO, FDT_PAGES);
-	if (NULL == t->fdt)
+	if (!fd_table_init(&t->fdt))
 	{
+		palloc_free_page(t);
 		return TID_ERROR;
 	}
-	t->fdt[0] = 0;
-	t->fdt[1] = 1;
-	for (int i = 2; i < FDT_SIZE; i++) 
-	{
-		t->fdt[i] = NULL;
-	}
 
 	/* Project 2: 현재 프로세스의 자식으로 추가 */
-	list_push_back(&thread_current()->child_list, &t->child_elem);
+	if (!process_add_child(t))
+	{
+		fd_table_destroy(&t->fdt);
+		palloc_free_page(t);
+		return TID_ERROR;
+	}
 	#endif
 
 	/* Add to run queue. */
@@ -362,7 +361,11 @@ void thread_yield(void)
 void thread_try_yield(void) {
 	if (!list_empty(&ready_list) && thread_current() != idle_thread) {
 		if (list_entry(list_front(&ready_list), struct thread, elem)->priority > thread_current()->priority) {
-			thread_yield();
+			/* 인터럽트 핸들러에서는 바로 양보할 수 없으므로 핸들러가 끝날 때 양보한다. */
+			if (intr_context())
+				intr_yield_on_return();
+			else
+				thread_yield();
 		}
 	}
 }
@@ -565,10 +568,7 @@ static void init_thread(struct thread *t, const char *name, int priority)
 	t->magic = THREAD_MAGIC;
 	list_init(&t->donations);
 	/* Project 2: System Call */
-	list_init(&t->child_list);
-	sema_init(&t->load_sema, 0);
-	sema_init(&t->wait_sema, 0);
-	sema_init(&t->exit_sema, 0);
+	list_init(&t->children);
 	t->exit_status = 0;
 
 	if (strcmp(name, "idle"))
@@ -822,4 +822,17 @@ void thread_wakeup(int64_t os_ticks)
 		t->status = THREAD_READY;
 	}
 	intr_set_level(old_level);
+}
+
+/* thread_cancel_sleep - thread_sleep()으로 잠든 스레드 t를 깨어날 시각 전에 깨운다.
+ * t를 sleep_list에서 빼고 READY 상태로 전환한다.
+ * 인터럽트가 꺼진 상태에서 호출해야 하며, 인터럽트 핸들러에서도 호출할 수 있다.
+ */
+void thread_cancel_sleep(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_BLOCKED);
+
+	list_remove(&t->elem);
+	thread_unblock(t);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "intrinsic.h"
@@ -145,6 +146,9 @@ static void page_fault(struct intr_frame *f) {
 #endif
 	/* Count page faults. */
 	page_fault_cnt++;
+	/* 커널이 유저 메모리를 복사하다 난 폴트이면 복사가 실패하도록 한다. */
+	if (!user && uaccess_fixup (f))
+		return;
 	/* 유효하지 않은 접근은 프로세스를 종료하여 모든 자원을 해제한다. */
 	exit(-1);
 }
@@ -0,0 +1,172 @@
+#include "userprog/exec-cache.h"
+#include <debug.h>
+#include <list.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Cache of executable layouts.
+
+   Loading a program reads and checks its ELF header and every
+   program header before it maps a single segment.  Programs are
+   often run many times in a row, so load() keeps the result, an
+   exec_image, for the last few executables here and skips straight
+   to mapping segments when it sees one of them again.
+
+   An entry keeps its executable's inode open, so that the inode,
+   and with it its generation, stays in memory between runs.  The
+   entry is only good while the generation is the one it was built
+   from: any write to the file or its removal makes it stale.  Stale
+   entries are dropped when they are next looked up, and on every
+   remove() so that a removed executable's space is not held. */
+
+/* Executables whose layout is kept. */
+#define EXEC_CACHE_SIZE 8
+
+/* A cached executable layout. */
+struct exec_entry {
+	struct list_elem elem;      /* Element in cache, most recent first. */
+	struct inode *inode;        /* Executable, kept open. */
+	unsigned gen;               /* INODE's generation IMAGE is from. */
+	struct exec_image *image;   /* Its layout. */
+};
+
+static struct list cache;
+static size_t cache_cnt;
+
+/* Protects the cache and the reference counts of images. */
+static struct lock cache_lock;
+
+/* Initializes the executable cache. */
+void
+exec_cache_init (void) {
+	list_init (&cache);
+	lock_init (&cache_lock);
+}
+
+/* Unlinks E from the cache and moves it to list DEAD, to be freed
+   by free_entries() once the lock is released. */
+static void
+unlink_entry (struct exec_entry *e, struct list *dead) {
+	list_remove (&e->elem);
+	list_push_back (dead, &e->elem);
+	cache_cnt--;
+}
+
+/* Frees the entries in list DEAD, closing their inodes, which may
+   write to disk.  Must be called without cache_lock held. */
+static void
+free_entries (struct list *dead) {
+	while (!list_empty (dead)) {
+		struct exec_entry *e = list_entry (list_pop_front (dead),
+				struct exec_entry, elem);
+
+		inode_close (e->inode);
+		exec_image_release (e->image);
+		free (e);
+	}
+}
+
+/* Returns the cached layout of the executable in INODE, or a null
+   pointer if none is cached or the cached one is stale.  The caller
+   must release the layout with exec_image_release(). */
+struct exec_image *
+exec_cache_lookup (struct inode *inode) {
+	struct exec_image *image = NULL;
+	struct list dead;
+	struct list_elem *el;
+
+	list_init (&dead);
+	lock_acquire (&cache_lock);
+	for (el = list_begin (&cache); el != list_end (&cache);
+			el = list_next (el)) {
+		struct exec_entry *e = list_entry (el, struct exec_entry, elem);
+
+		if (e->inode != inode)
+			continue;
+		if (e->gen == inode_generation (inode)) {
+			image = e->image;
+			image->refs++;
+			list_remove (&e->elem);
+			list_push_front (&cache, &e->elem);
+		} else
+			unlink_entry (e, &dead);
+		break;
+	}
+	lock_release (&cache_lock);
+	free_entries (&dead);
+	return image;
+}
+
+/* Caches IMAGE as the layout of the executable in INODE, as of
+   INODE's current generation, in place of any older layout of it,
+   evicting the least recently used entry if the cache is full.
+   Takes a reference to IMAGE of its own; does nothing if memory
+   runs out. */
+void
+exec_cache_insert (struct inode *inode, struct exec_image *image) {
+	struct exec_entry *e = malloc (sizeof *e);
+	struct list dead;
+	struct list_elem *el;
+
+	if (e == NULL)
+		return;
+	e->inode = inode_reopen (inode);
+	e->gen = inode_generation (inode);
+	e->image = image;
+
+	list_init (&dead);
+	lock_acquire (&cache_lock);
+	for (el = list_begin (&cache); el != list_end (&cache);
+			el = list_next (el)) {
+		struct exec_entry *old = list_entry (el, struct exec_entry, elem);
+
+		/* Another process loaded the same executable meanwhile. */
+		if (old->inode == inode) {
+			unlink_entry (old, &dead);
+			break;
+		}
+	}
+	image->refs++;
+	list_push_front (&cache, &e->elem);
+	if (++cache_cnt > EXEC_CACHE_SIZE)
+		unlink_entry (list_entry (list_back (&cache), struct exec_entry,
+					elem), &dead);
+	lock_release (&cache_lock);
+	free_entries (&dead);
+}
+
+/* Drops every stale entry, so that removed executables do not stay
+   open on behalf of the cache. */
+void
+exec_cache_prune (void) {
+	struct list dead;
+	struct list_elem *el, *next;
+
+	list_init (&dead);
+	lock_acquire (&cache_lock);
+	for (el = list_begin (&cache); el != list_end (&cache); el = next) {
+		struct exec_entry *e = list_entry (el, struct exec_entry, elem);
+
+		next = list_next (el);
+		if (e->gen != inode_generation (e->inode))
+			unlink_entry (e, &dead);
+	}
+	lock_release (&cache_lock);
+	free_entries (&dead);
+}
+
+/* Drops a reference to IMAGE, freeing it if it was the last. */
+void
+exec_image_release (struct exec_image *image) {
+	bool last;
+
+	if (image == NULL)
+		return;
+	lock_acquire (&cache_lock);
+	ASSERT (image->refs > 0);
+	last = --image->refs == 0;
+	lock_release (&cache_lock);
+	if (last)
+		free (image);
+}
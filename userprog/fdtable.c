@@ -0,0 +1,183 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <limits.h>
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+
+/* Descriptors a new table has room for. */
+#define FD_INITIAL 16
+
+/* Bits in an element of the bitmap. */
+#define ELEM_BITS (sizeof (unsigned long) * CHAR_BIT)
+
+/* Elements of the bitmap of a table with room for SIZE
+   descriptors. */
+static inline size_t
+elem_cnt (int size) {
+	return DIV_ROUND_UP (size, ELEM_BITS);
+}
+
+static inline bool
+fd_used (const struct fd_table *fdt, int fd) {
+	return (fdt->used[fd / ELEM_BITS] >> (fd % ELEM_BITS)) & 1;
+}
+
+static inline void
+mark (struct fd_table *fdt, int fd, bool used) {
+	unsigned long mask = 1UL << (fd % ELEM_BITS);
+
+	if (used)
+		fdt->used[fd / ELEM_BITS] |= mask;
+	else
+		fdt->used[fd / ELEM_BITS] &= ~mask;
+}
+
+/* Resizes FDT to have room for SIZE descriptors, SIZE being no
+   smaller than its current size.  Returns false if memory runs
+   out, leaving FDT as it was. */
+static bool
+resize (struct fd_table *fdt, int size) {
+	struct file **files = calloc (size, sizeof *files);
+	unsigned long *used = calloc (elem_cnt (size), sizeof *used);
+
+	if (files == NULL || used == NULL) {
+		free (files);
+		free (used);
+		return false;
+	}
+	if (fdt->size > 0) {
+		memcpy (files, fdt->files, fdt->size * sizeof *files);
+		memcpy (used, fdt->used, elem_cnt (fdt->size) * sizeof *used);
+	}
+	free (fdt->files);
+	free (fdt->used);
+	fdt->files = files;
+	fdt->used = used;
+	fdt->size = size;
+	return true;
+}
+
+/* Grows FDT, by doubling, until it has room for descriptor FD.
+   Returns false if FD is not below FD_MAX or memory runs out. */
+static bool
+grow (struct fd_table *fdt, int fd) {
+	int size = fdt->size;
+
+	if (fd < size)
+		return true;
+	if (fd >= FD_MAX)
+		return false;
+	while (size <= fd)
+		size *= 2;
+	return resize (fdt, size < FD_MAX ? size : FD_MAX);
+}
+
+/* Initializes FDT with just the console descriptors in use.
+   Returns false if memory runs out. */
+bool
+fd_table_init (struct fd_table *fdt) {
+	fdt->files = NULL;
+	fdt->used = NULL;
+	fdt->size = 0;
+	if (!resize (fdt, FD_INITIAL))
+		return false;
+	mark (fdt, 0, true);
+	mark (fdt, 1, true);
+	return true;
+}
+
+/* Frees FDT's memory.  Does not close the files still in it. */
+void
+fd_table_destroy (struct fd_table *fdt) {
+	free (fdt->files);
+	free (fdt->used);
+	fdt->files = NULL;
+	fdt->used = NULL;
+	fdt->size = 0;
+}
+
+/* Puts FILE into FDT on the lowest free descriptor and returns the
+   descriptor, or -1 if FDT is full or memory runs out. */
+int
+fd_table_add (struct fd_table *fdt, struct file *file) {
+	size_t i, cnt = elem_cnt (fdt->size);
+	int fd = fdt->size;
+
+	ASSERT (file != NULL);
+
+	for (i = 0; i < cnt; i++)
+		if (~fdt->used[i] != 0) {
+			fd = i * ELEM_BITS + __builtin_ctzl (~fdt->used[i]);
+			break;
+		}
+	if (fd >= fdt->size && !grow (fdt, fd))
+		return -1;
+	fdt->files[fd] = file;
+	mark (fdt, fd, true);
+	return fd;
+}
+
+/* Puts FILE into FDT on descriptor FD, which must have no file.
+   Returns false if FD is out of range or memory runs out. */
+bool
+fd_table_install (struct fd_table *fdt, int fd, struct file *file) {
+	ASSERT (file != NULL);
+
+	if (fd < 0 || !grow (fdt, fd))
+		return false;
+	ASSERT (fdt->files[fd] == NULL);
+	fdt->files[fd] = file;
+	mark (fdt, fd, true);
+	return true;
+}
+
+/* Returns the file open on descriptor FD in FDT, or a null pointer
+   if FD is not open or is the console. */
+struct file *
+fd_table_get (const struct fd_table *fdt, int fd) {
+	if (fd < 0 || fd >= fdt->size)
+		return NULL;
+	return fdt->files[fd];
+}
+
+/* Takes the file off descriptor FD in FDT and returns it, or a null
+   pointer if there was none.  Frees FD, unless it is 0 or 1, which
+   become the console again. */
+struct file *
+fd_table_remove (struct fd_table *fdt, int fd) {
+	struct file *file = fd_table_get (fdt, fd);
+
+	if (file != NULL) {
+		fdt->files[fd] = NULL;
+		if (fd >= 2)
+			mark (fdt, fd, false);
+	}
+	return file;
+}
+
+/* Returns the lowest descriptor in FDT that is at least FD and has
+   a file open on it, or -1 if there is none.  Walks the bitmap a
+   word at a time, so visiting every open file of a sparse table is
+   cheap. */
+int
+fd_table_next (const struct fd_table *fdt, int fd) {
+	size_t i, cnt = elem_cnt (fdt->size);
+	unsigned long bits;
+
+	/* The console descriptors are in use without a file. */
+	for (; fd < 2; fd++)
+		if (fd >= 0 && fdt->files[fd] != NULL)
+			return fd;
+	if (fd >= fdt->size)
+		return -1;
+	i = fd / ELEM_BITS;
+	bits = fdt->used[i] & (~0UL << (fd % ELEM_BITS));
+	for (;;) {
+		if (bits != 0)
+			return i * ELEM_BITS + __builtin_ctzl (bits);
+		if (++i >= cnt)
+			return -1;
+		bits = fdt->used[i];
+	}
+}
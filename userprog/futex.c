@@ -0,0 +1,185 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/uaccess.h"
+
+/* Futexes.
+
+   A futex is an int in user memory that processes sleep on until
+   another process wakes them.  User-space locks keep their state in
+   such an int and change it with atomic instructions, so that they
+   only make a system call to sleep when the lock is taken or to
+   wake a sleeper when one is known to exist.
+
+   Sleepers are queued by the kernel address of the int, that is,
+   by the frame that holds it and the offset in that frame.  Two
+   processes that map the same frame, as they do with shared
+   memory, therefore sleep on the same futex even if they map it at
+   different user addresses, while the same user address in two
+   processes with private memory names two futexes.
+
+   The queues are spread over a fixed number of buckets, each with
+   its own lock.  futex_wait() compares the int with the value the
+   caller expects while holding the bucket's lock, and futex_wake()
+   takes the same lock, so a wakeup sent after the int changed
+   cannot slip in between the comparison and the sleep. */
+
+/* Number of wait queue buckets.  Must be a power of 2. */
+#define FUTEX_BUCKETS 64
+
+/* A process sleeping on a futex. */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in a bucket's WAITERS. */
+	int *key;                   /* Kernel address of the futex. */
+	struct semaphore sema;      /* Up when woken. */
+};
+
+struct futex_bucket {
+	struct lock lock;
+	struct list waiters;        /* All waiters whose key hashes here. */
+};
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	size_t i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		lock_init (&buckets[i].lock);
+		list_init (&buckets[i].waiters);
+	}
+}
+
+/* Returns the kernel address of the futex at user address UADDR,
+   faulting its page in if need be, or a null pointer if UADDR is
+   misaligned or cannot be read. */
+static int *
+get_key (int *uaddr) {
+	int val;
+
+	if (uaddr == NULL || (uintptr_t) uaddr % sizeof *uaddr != 0
+			|| !is_user_vaddr (uaddr)
+			|| !copy_from_user (&val, uaddr, sizeof val))
+		return NULL;
+	return pml4_get_page (thread_current ()->pml4, uaddr);
+}
+
+/* Returns the bucket that KEY's waiters queue in. */
+static struct futex_bucket *
+bucket_of (int *key) {
+	return &buckets[hash_int ((uintptr_t) key >> 2) & (FUTEX_BUCKETS - 1)];
+}
+
+/* Wakes the first CNT waiters on KEY in bucket B.  If TO is not
+   null, moves the rest to wait on key TO in bucket TO_B; TO must
+   differ from KEY.  Must be called with the locks of both buckets
+   held.  Returns the number woken. */
+static int
+wake_waiters (struct futex_bucket *b, int *key, int cnt,
+		struct futex_bucket *to_b, int *to) {
+	struct list_elem *e = list_begin (&b->waiters);
+	int woken = 0;
+
+	while (e != list_end (&b->waiters)) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		if (w->key != key) {
+			e = list_next (e);
+			continue;
+		}
+		if (woken < cnt) {
+			e = list_remove (e);
+			sema_up (&w->sema);
+			woken++;
+		} else if (to != NULL) {
+			e = list_remove (e);
+			w->key = to;
+			list_push_back (&to_b->waiters, &w->elem);
+		} else
+			break;
+	}
+	return woken;
+}
+
+/* Sleeps on the futex at UADDR until woken, if it holds VAL.
+   Returns 0 after being woken, or -1 at once if the futex holds
+   another value or UADDR is not a valid futex. */
+int
+futex_wait (int *uaddr, int val) {
+	int *key = get_key (uaddr);
+	struct futex_bucket *b;
+	struct futex_waiter w;
+
+	if (key == NULL)
+		return -1;
+	b = bucket_of (key);
+	lock_acquire (&b->lock);
+	if (*(volatile int *) key != val) {
+		lock_release (&b->lock);
+		return -1;
+	}
+	w.key = key;
+	sema_init (&w.sema, 0);
+	list_push_back (&b->waiters, &w.elem);
+	lock_release (&b->lock);
+
+	sema_down (&w.sema);
+	return 0;
+}
+
+/* Wakes up to CNT processes sleeping on the futex at UADDR, oldest
+   first.  Returns the number woken, or -1 if UADDR is not a valid
+   futex. */
+int
+futex_wake (int *uaddr, int cnt) {
+	int *key = get_key (uaddr);
+	struct futex_bucket *b;
+	int woken;
+
+	if (key == NULL)
+		return -1;
+	b = bucket_of (key);
+	lock_acquire (&b->lock);
+	woken = wake_waiters (b, key, cnt, NULL, NULL);
+	lock_release (&b->lock);
+	return woken;
+}
+
+/* Wakes up to CNT processes sleeping on the futex at UADDR and
+   moves the others to sleep on the futex at UADDR2 instead, where
+   a later futex_wake() on UADDR2 wakes them.  A condition variable
+   broadcast uses this to wake one waiter and leave the rest queued
+   on the mutex, rather than waking them all to fight over it.
+   Returns the number woken, or -1 if either address is not a valid
+   futex. */
+int
+futex_requeue (int *uaddr, int cnt, int *uaddr2) {
+	int *key = get_key (uaddr);
+	int *key2 = get_key (uaddr2);
+	struct futex_bucket *b, *b2;
+	int woken;
+
+	if (key == NULL || key2 == NULL)
+		return -1;
+	b = bucket_of (key);
+	b2 = bucket_of (key2);
+
+	/* Lock the buckets in address order, so that two requeues
+	   between the same buckets cannot deadlock. */
+	lock_acquire (b < b2 ? &b->lock : &b2->lock);
+	if (b != b2)
+		lock_acquire (b < b2 ? &b2->lock : &b->lock);
+	woken = wake_waiters (b, key, cnt, b2, key != key2 ? key2 : NULL);
+	if (b != b2)
+		lock_release (&b2->lock);
+	lock_release (&b->lock);
+	return woken;
+}
@@ -0,0 +1,504 @@
+#include "userprog/io-ring.h"
+#include <debug.h>
+#include <limits.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* I/O rings.
+
+   A process sets up a ring with io_setup() and queues operations in
+   it; io_enter() takes them from the submission queue and hands them
+   to a pool of kernel worker threads, which carry them out while the
+   process goes on running and post their completions back to the
+   ring.  One system call thus submits and reaps a whole batch.
+
+   Everything that depends on the process's own state happens in
+   io_enter(), in the process's thread: file descriptors are turned
+   into files, and the pages of every buffer are checked and brought
+   into memory, so that a worker only has to look them up in the
+   process's page table.  OPEN and CLOSE change the file descriptor
+   table and run there too.  Until the operations a process has in
+   flight complete, its files and pages must stay put, so close(),
+   munmap() and process exit first wait for them. */
+
+/* Kernel worker threads, started with the first ring. */
+#define IO_WORKER_CNT 4
+
+/* A process's ring. */
+struct io_ctx {
+	struct thread *owner;               /* Process that set it up. */
+	uint64_t *pml4;                     /* Its page table. */
+	struct io_ring *ring;               /* Kernel address of the ring. */
+	uint32_t sq_head;                   /* Next submission to take. */
+	uint32_t cq_tail;                   /* Next completion to post. */
+	struct lock lock;                   /* Protects the fields below and
+	                                       posting completions. */
+	unsigned in_flight;                 /* Operations with the workers. */
+	struct condition done;              /* Signaled on each completion. */
+};
+
+/* An operation handed to the workers. */
+struct io_work {
+	struct list_elem elem;              /* Element in work_list. */
+	struct io_ctx *ctx;                 /* Ring it came from. */
+	struct io_sqe sqe;                  /* Copy of the submission. */
+	struct file *file;                  /* File SQE.FD refers to, or a
+	                                       null pointer for the console. */
+};
+
+static struct list work_list;           /* Operations not yet started. */
+static struct lock work_lock;           /* Protects work_list. */
+static struct semaphore work_ready;     /* Counts operations in work_list. */
+static bool workers_started;            /* Protected by work_lock. */
+
+static void worker (void *aux);
+
+/* Initializes the I/O ring module. */
+void
+io_ring_init (void) {
+	list_init (&work_list);
+	lock_init (&work_lock);
+	sema_init (&work_ready, 0);
+}
+
+/* Starts the worker threads unless they are running already.
+ * Returns false if none could be started. */
+static bool
+start_workers (void) {
+	bool success = true;
+	int i;
+
+	lock_acquire (&work_lock);
+	if (!workers_started) {
+		for (i = 0; i < IO_WORKER_CNT; i++) {
+			char name[16];
+
+			snprintf (name, sizeof name, "io-worker %d", i);
+			if (thread_create (name, PRI_DEFAULT, worker, NULL) == TID_ERROR)
+				break;
+		}
+		workers_started = i > 0;
+		success = workers_started;
+	}
+	lock_release (&work_lock);
+	return success;
+}
+
+/* Returns the kernel address of user address UADDR in the running
+ * process, bringing its page into memory if needed, or a null
+ * pointer if UADDR is not mapped, or if WRITE is true and the page
+ * is read-only. */
+static void *
+user_to_kernel (const void *uaddr, bool write) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	uint64_t *pte;
+
+	if (!is_user_vaddr (uaddr))
+		return NULL;
+	pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
+	if (pte == NULL || !(*pte & PTE_P)) {
+#ifdef VM
+		if (!vm_claim_page (pg_round_down (uaddr)))
+			return NULL;
+		pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
+		if (pte == NULL || !(*pte & PTE_P))
+			return NULL;
+#else
+		return NULL;
+#endif
+	}
+	if (write && !is_writable (pte))
+		return NULL;
+	return pml4_get_page (pml4, uaddr);
+}
+
+/* Checks that the SIZE bytes at user address UADDR are mapped, and
+ * writable if WRITE is true, and brings them into memory. */
+static bool
+prefault (uint64_t uaddr, size_t size, bool write) {
+	const uint8_t *p = (const uint8_t *) uaddr;
+	const uint8_t *end = p + size;
+
+	if (size == 0)
+		return true;
+	if (end < p)
+		return false;
+	for (p = pg_round_down (p); p < end; p += PGSIZE)
+		if (user_to_kernel (p, write) == NULL)
+			return false;
+	return true;
+}
+
+/* Sets up RING, a page-aligned writable page of the running process,
+ * as its I/O ring and empties both queues.  Returns 0 if
+ * successful, -1 if RING is unsuitable, the process already has a
+ * ring, or memory runs out.
+ *
+ * The kernel keeps writing to the ring through its kernel address
+ * until the process exits or execs, so the page must stay put that
+ * long.  Only anonymous memory does: a shared memory or file mapping
+ * could be unmapped, and its frame freed, under the ring. */
+int
+io_ring_setup (struct io_ring *ring) {
+	struct thread *t = thread_current ();
+	struct io_ctx *ctx;
+	struct io_ring *kring;
+#ifdef VM
+	struct page *page;
+#endif
+
+	ASSERT (sizeof *ring <= PGSIZE);
+
+	if (t->io_ring != NULL || ring == NULL || pg_ofs (ring) != 0)
+		return -1;
+	kring = user_to_kernel (ring, true);
+	if (kring == NULL)
+		return -1;
+#ifdef VM
+	page = spt_find_page (&t->spt, ring);
+	if (page == NULL || page_get_type (page) != VM_ANON)
+		return -1;
+#endif
+	if (!start_workers ())
+		return -1;
+	ctx = calloc (1, sizeof *ctx);
+	if (ctx == NULL)
+		return -1;
+
+	ctx->owner = t;
+	ctx->pml4 = t->pml4;
+	ctx->ring = kring;
+	lock_init (&ctx->lock);
+	cond_init (&ctx->done);
+	kring->sq_head = kring->sq_tail = 0;
+	kring->cq_head = kring->cq_tail = 0;
+	t->io_ring = ctx;
+	return 0;
+}
+
+/* Returns the number of completions in CTX's queue the process has
+ * not consumed yet.  A bogus cq_head counts as a full queue. */
+static unsigned
+cq_used (struct io_ctx *ctx) {
+	uint32_t used = ctx->cq_tail - ctx->ring->cq_head;
+
+	return used < IO_RING_ENTRIES ? used : IO_RING_ENTRIES;
+}
+
+/* Posts a completion with result RES for USER_DATA to CTX's ring.
+ * If QUEUED, it is for an operation the workers carried out.
+ * CTX's lock must be held. */
+static void
+post (struct io_ctx *ctx, uint64_t user_data, int32_t res, bool queued) {
+	struct io_cqe *cqe = &ctx->ring->cqes[ctx->cq_tail % IO_RING_ENTRIES];
+
+	ASSERT (lock_held_by_current_thread (&ctx->lock));
+
+	cqe->user_data = user_data;
+	cqe->res = res;
+	barrier ();
+	ctx->ring->cq_tail = ++ctx->cq_tail;
+	if (queued)
+		ctx->in_flight--;
+	cond_broadcast (&ctx->done, &ctx->lock);
+}
+
+/* Waits until CTX has no operations in flight.  CTX's lock must be
+ * held. */
+static void
+wait_idle (struct io_ctx *ctx) {
+	while (ctx->in_flight > 0)
+		cond_wait (&ctx->done, &ctx->lock);
+}
+
+/* Copies the file name at user address UADDR into a new page.
+ * Returns the page, which the caller must free, or a null pointer
+ * if the name is not mapped or longer than a page. */
+static char *
+copy_in_name (uint64_t uaddr) {
+	const char *src = (const char *) uaddr;
+	char *name = palloc_get_page (0);
+	const char *k = NULL;
+	size_t i;
+
+	if (name == NULL)
+		return NULL;
+	for (i = 0; i < PGSIZE; i++, src++) {
+		if (k == NULL || pg_ofs (src) == 0) {
+			k = user_to_kernel (src, false);
+			if (k == NULL)
+				break;
+		}
+		name[i] = *k++;
+		if (name[i] == '\0')
+			return name;
+	}
+	palloc_free_page (name);
+	return NULL;
+}
+
+/* Opens the file named at user address UADDR for the running
+ * process.  Returns the new file descriptor, or -1. */
+static int
+do_open (uint64_t uaddr) {
+	char *name = copy_in_name (uaddr);
+	struct file *file;
+	int fd = -1;
+
+	if (name == NULL)
+		return -1;
+	lock_acquire (&filesys_lock);
+	file = filesys_open (name);
+	if (file != NULL) {
+		fd = add_file_to_fdt (file);
+		if (fd == -1)
+			file_close (file);
+	}
+	lock_release (&filesys_lock);
+	palloc_free_page (name);
+	return fd;
+}
+
+/* Checks SQE, an operation for the workers, and resolves its file.
+ * Pipes are refused, since a worker blocked on one could hold up
+ * every other process's operations.  Returns a new work item, or a
+ * null pointer if SQE is invalid or memory runs out. */
+static struct io_work *
+prepare (struct io_ctx *ctx, const struct io_sqe *sqe) {
+	struct file *file = get_file_from_fd (sqe->fd);
+	bool console = file == NULL
+		&& sqe->opcode == IO_OP_WRITE && sqe->fd == 1;
+	bool to_user = sqe->opcode == IO_OP_READ || sqe->opcode == IO_OP_PREAD;
+	bool positional = sqe->opcode == IO_OP_PREAD
+		|| sqe->opcode == IO_OP_PWRITE;
+	struct io_work *w;
+
+	if (!console && (file == NULL || file_is_pipe (file)))
+		return NULL;
+	if (sqe->opcode != IO_OP_FSYNC) {
+		if (sqe->len > INT_MAX || (positional && sqe->off < 0)
+				|| !prefault (sqe->addr, sqe->len, to_user))
+			return NULL;
+	}
+
+	w = malloc (sizeof *w);
+	if (w != NULL) {
+		w->ctx = ctx;
+		w->sqe = *sqe;
+		w->file = file;
+	}
+	return w;
+}
+
+/* Takes SQE, copied out of CTX's submission queue, and either
+ * carries it out at once or queues it for the workers. */
+static void
+submit (struct io_ctx *ctx, const struct io_sqe *sqe) {
+	struct io_work *w = NULL;
+	int res = -1;
+
+	switch (sqe->opcode) {
+		case IO_OP_NOP:
+			res = 0;
+			break;
+		case IO_OP_OPEN:
+			res = do_open (sqe->addr);
+			break;
+		case IO_OP_CLOSE:
+			/* close() waits for the operations in flight. */
+			if (get_file_from_fd (sqe->fd) != NULL) {
+				close (sqe->fd);
+				res = 0;
+			}
+			break;
+		case IO_OP_READ:
+		case IO_OP_WRITE:
+		case IO_OP_PREAD:
+		case IO_OP_PWRITE:
+		case IO_OP_FSYNC:
+			w = prepare (ctx, sqe);
+			break;
+	}
+
+	lock_acquire (&ctx->lock);
+	if (w != NULL) {
+		ctx->in_flight++;
+		lock_acquire (&work_lock);
+		list_push_back (&work_list, &w->elem);
+		lock_release (&work_lock);
+		sema_up (&work_ready);
+	} else
+		post (ctx, sqe->user_data, res, false);
+	lock_release (&ctx->lock);
+}
+
+/* Takes up to TO_SUBMIT entries from the running process's
+ * submission queue, then waits until at least MIN_COMPLETE
+ * completions are waiting in its completion queue or nothing is in
+ * flight any more.  Stops taking submissions early when the
+ * completion queue could not hold one more.  Returns the number of
+ * entries taken, or -1 if the process has no ring. */
+int
+io_ring_enter (unsigned to_submit, unsigned min_complete) {
+	struct io_ctx *ctx = thread_current ()->io_ring;
+	struct io_ring *ring;
+	uint32_t sq_tail;
+	unsigned submitted = 0;
+
+	if (ctx == NULL)
+		return -1;
+	ring = ctx->ring;
+	if (min_complete > IO_RING_ENTRIES)
+		min_complete = IO_RING_ENTRIES;
+
+	sq_tail = ring->sq_tail;
+	barrier ();
+	while (submitted < to_submit && ctx->sq_head != sq_tail
+			&& sq_tail - ctx->sq_head <= IO_RING_ENTRIES) {
+		struct io_sqe sqe;
+		bool room;
+
+		lock_acquire (&ctx->lock);
+		while (!(room = ctx->in_flight + cq_used (ctx) < IO_RING_ENTRIES)
+				&& ctx->in_flight > 0)
+			cond_wait (&ctx->done, &ctx->lock);
+		lock_release (&ctx->lock);
+		if (!room)
+			break;
+
+		sqe = ring->sqes[ctx->sq_head % IO_RING_ENTRIES];
+		ring->sq_head = ++ctx->sq_head;
+		submit (ctx, &sqe);
+		submitted++;
+	}
+
+	lock_acquire (&ctx->lock);
+	while (cq_used (ctx) < min_complete && ctx->in_flight > 0)
+		cond_wait (&ctx->done, &ctx->lock);
+	lock_release (&ctx->lock);
+	return submitted;
+}
+
+/* Moves data between W's file and its buffer, one user page at a
+ * time through the owner's page table.  Returns the number of bytes
+ * moved. */
+static int
+transfer (struct io_work *w, bool to_user, bool positional) {
+	const struct io_sqe *sqe = &w->sqe;
+	uint8_t *uaddr = (uint8_t *) sqe->addr;
+	int done = 0;
+
+	if (w->file != NULL)
+		lock_acquire (&filesys_lock);
+	while ((uint32_t) done < sqe->len) {
+		off_t chunk = PGSIZE - pg_ofs (uaddr + done);
+		void *kaddr = pml4_get_page (w->ctx->pml4, uaddr + done);
+		off_t n;
+
+		if (chunk > (off_t) sqe->len - done)
+			chunk = sqe->len - done;
+		if (kaddr == NULL)
+			break;
+
+		if (w->file == NULL) {
+			putbuf (kaddr, chunk);
+			n = chunk;
+		} else if (to_user) {
+			n = positional
+				? file_read_at (w->file, kaddr, chunk, sqe->off + done)
+				: file_read (w->file, kaddr, chunk);
+			if (n > 0)
+				pml4_set_dirty (w->ctx->pml4, uaddr + done, true);
+		} else
+			n = positional
+				? file_write_at (w->file, kaddr, chunk, sqe->off + done)
+				: file_write (w->file, kaddr, chunk);
+
+		done += n;
+		if (n < chunk)
+			break;
+	}
+	if (w->file != NULL)
+		lock_release (&filesys_lock);
+	return done;
+}
+
+/* Carries out W and returns its result. */
+static int
+execute (struct io_work *w) {
+	bool synced;
+
+	switch (w->sqe.opcode) {
+		case IO_OP_READ:
+			return transfer (w, true, false);
+		case IO_OP_WRITE:
+			return transfer (w, false, false);
+		case IO_OP_PREAD:
+			return transfer (w, true, true);
+		case IO_OP_PWRITE:
+			return transfer (w, false, true);
+		case IO_OP_FSYNC:
+			lock_acquire (&filesys_lock);
+			synced = file_sync (w->file);
+			lock_release (&filesys_lock);
+			return synced ? 0 : -1;
+		default:
+			NOT_REACHED ();
+	}
+}
+
+/* Worker thread: carries out queued operations one after another. */
+static void
+worker (void *aux UNUSED) {
+	for (;;) {
+		struct io_work *w;
+		struct io_ctx *ctx;
+		int res;
+
+		sema_down (&work_ready);
+		lock_acquire (&work_lock);
+		w = list_entry (list_pop_front (&work_list), struct io_work, elem);
+		lock_release (&work_lock);
+
+		res = execute (w);
+		ctx = w->ctx;
+		lock_acquire (&ctx->lock);
+		post (ctx, w->sqe.user_data, res, true);
+		lock_release (&ctx->lock);
+		free (w);
+	}
+}
+
+/* Waits until T's ring, if it has one, has no operations in flight.
+ * T must be the running thread. */
+void
+io_ring_drain (struct thread *t) {
+	struct io_ctx *ctx = t->io_ring;
+
+	if (ctx != NULL) {
+		lock_acquire (&ctx->lock);
+		wait_idle (ctx);
+		lock_release (&ctx->lock);
+	}
+}
+
+/* Waits for the operations in flight on T's ring, if any, and tears
+ * the ring down.  T must be the running thread. */
+void
+io_ring_destroy (struct thread *t) {
+	io_ring_drain (t);
+	free (t->io_ring);
+	t->io_ring = NULL;
+}
@@ -1,19 +1,25 @@
 #include "userprog/process.h"
 #include <debug.h>
+#include <hash.h>
 #include <inttypes.h>
 #include <round.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
 #include "userprog/syscall.h"
+#include "userprog/exec-cache.h"
+#include "userprog/io-ring.h"
+#include "userprog/vdata.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -28,8 +34,106 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void **);
+static void spawn_child (void *aux);
+static bool duplicate_fds (struct thread *parent);
 void set_userstack(char **argv, int argc, struct intr_frame *if_);
-struct thread *get_child_process(tid_t pid);
+static struct exit_record *get_child_process(tid_t pid);
+
+/* What a parent needs to know about a child, kept apart from the
+ * child's thread so that a child that exits before it is waited for
+ * can free its page, file descriptor table and address space right
+ * away instead of lingering until the parent reaps it.
+ *
+ * A record is shared by the child, which fills it in and drops its
+ * reference when it exits, and the parent, which drops its reference
+ * when it waits for the child or exits itself.  Whoever drops the
+ * last reference frees the record.  Records of live children are
+ * also kept in EXIT_RECORDS so that wait() finds them by tid without
+ * walking the list of children. */
+struct exit_record {
+	tid_t tid;                  /* The child's thread ID. */
+	struct thread *parent;      /* The thread that created the child. */
+	int status;                 /* Exit status, once DONE is up. */
+	struct semaphore loaded;    /* Up once the child has loaded. */
+	struct semaphore done;      /* Up once the child has exited. */
+	int refs;                   /* References, at most 2. */
+	struct hash_elem hash_elem; /* Element in EXIT_RECORDS. */
+	struct list_elem elem;      /* Element in parent's children. */
+};
+
+/* Exit records not yet reaped by their parents, by tid. */
+static struct hash exit_records;
+
+/* Protects EXIT_RECORDS, the lists of children and the reference
+ * counts of the records. */
+static struct lock exit_records_lock;
+
+static uint64_t
+exit_record_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct exit_record *rec = hash_entry (e, struct exit_record, hash_elem);
+	return hash_int (rec->tid);
+}
+
+static bool
+exit_record_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct exit_record, hash_elem)->tid
+		< hash_entry (b, struct exit_record, hash_elem)->tid;
+}
+
+/* Drops a reference to REC and frees it if it was the last one.
+ * The caller must hold exit_records_lock. */
+static void
+exit_record_release (struct exit_record *rec) {
+	ASSERT (lock_held_by_current_thread (&exit_records_lock));
+	ASSERT (rec->refs > 0);
+
+	if (--rec->refs == 0)
+		free (rec);
+}
+
+/* Initializes the table of exit records.  Must be called before the
+ * first thread_create(). */
+void
+process_init_records (void) {
+	hash_init (&exit_records, exit_record_hash, exit_record_less, NULL);
+	lock_init (&exit_records_lock);
+}
+
+/* process_add_child - 새로 만든 스레드 T를 현재 스레드의 자식으로 등록한다.
+ * T의 종료 레코드를 할당하지 못하면 false를 반환한다.
+ */
+bool
+process_add_child (struct thread *t) {
+	struct thread *parent = thread_current ();
+	struct exit_record *rec = malloc (sizeof *rec);
+
+	if (rec == NULL)
+		return false;
+	rec->tid = t->tid;
+	rec->parent = parent;
+	rec->status = -1;
+	sema_init (&rec->loaded, 0);
+	sema_init (&rec->done, 0);
+	rec->refs = 2;
+	t->exit_record = rec;
+
+	lock_acquire (&exit_records_lock);
+	hash_insert (&exit_records, &rec->hash_elem);
+	list_push_back (&parent->children, &rec->elem);
+	lock_release (&exit_records_lock);
+	return true;
+}
+
+/* Tells the parent that the current process has loaded, or failed
+ * to. */
+static void
+signal_loaded (void) {
+	struct exit_record *rec = thread_current ()->exit_record;
+
+	if (rec != NULL)
+		sema_up (&rec->loaded);
+}
 
 /* General process initializer for initd and other process. */
 static void process_init (void) {
@@ -62,11 +166,11 @@ tid_t process_create_initd (const char *file_name) {
 	if (tid == TID_ERROR) {
 		palloc_free_page(fn_copy);	
 	}
-	struct thread *child = get_child_process(tid);
+	struct exit_record *child = get_child_process(tid);
 	if (child == NULL) {
 		return TID_ERROR;
 	}
-	sema_down(&child->load_sema);
+	sema_down(&child->loaded);
 	return tid;
 }
 
@@ -95,12 +199,12 @@ tid_t process_fork(const char *name, struct intr_frame *if_) {
 	void *aux[2] = {thread_current(), if_};
 
 	tid_t tid = thread_create(name, PRI_DEFAULT, __do_fork, aux);
-	struct thread *child = get_child_process(tid);
+	struct exit_record *child = get_child_process(tid);
 	if (child == NULL) {
 		return TID_ERROR;
 	}
 
-	sema_down(&child->load_sema);
+	sema_down(&child->loaded);
 	return tid;
 }
 
@@ -115,8 +219,9 @@ static bool duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	void *newpage;
 	bool writable;
 
-	/* 1. parent_page가 커널 페이지인 경우 즉시 반환한다. */
-	if (is_kernel_vaddr (va))
+	/* 1. parent_page가 커널 페이지인 경우 즉시 반환한다.
+	 * 커널 데이터 페이지는 복제하지 않고 __do_fork()에서 따로 매핑한다. */
+	if (is_kernel_vaddr (va) || vdata_overlaps (va, PGSIZE))
 		return true;
 
 	/* 2. 부모의 페이지 맵 레벨 4에서 va를 해결한다. */
@@ -131,7 +236,7 @@ static bool duplicate_pte (uint64_t *pte, void *va, void *aux) {
 		return false;
 	}
 	/* 4. 부모 페이지를 새 페이지에 복제하고 부모 페이지가 쓰기 가능한지 여부를 확인한다.(결과에 따라 writable을 설정한다.) */
-	memcpy (newpage, parent_page, PGSIZE);
+	copy_page (newpage, parent_page);
 	writable = is_writable (pte);
 
 	/* 5. 새 페이지를 VA 주소에 WRITABLE 권한으로 자식의 페이지 테이블에 추가한다. */
@@ -174,30 +279,144 @@ __do_fork (void **aux) {
 		goto error;
 	}
 #endif
+	/* 커널 데이터 페이지는 자식 자신의 페이지로 새로 매핑한다. */
+	if (!vdata_map ())
+		goto error;
 
 	/* 부모의 파일 디스크립터 테이블을 복사한다. 
 	 * 이 함수가 부모의 자원을 성공적으로 복제할 때까지 부모는 fork()에서 반환되지 않아야 한다.
 	 */
-	current->fdt[0] = parent->fdt[0];
-	current->fdt[1] = parent->fdt[1];
-	for (int idx = 2; idx < FDT_SIZE; idx++) {
-		struct file *f = parent->fdt[idx];
-		if (f != NULL) {
-			current->fdt[idx] = file_duplicate(f);
-		}
-	}
+	if (!duplicate_fds(parent))
+		goto error;
 	/* 자식 프로세스의 반환 값은 0 */
 	if_.R.rax = 0;
-	sema_up(&current->load_sema);
+	signal_loaded();
 	process_init();
 	/* Finally, switch to the newly created process. */
 	if (succ)
 		do_iret (&if_);
 error:
-	sema_up(&current->load_sema);
+	signal_loaded();
 	exit(TID_ERROR);
 }
 
+/* duplicate_fds - 부모의 열린 파일 디스크립터를 모두 현재 프로세스에 같은 번호로 복제한다.
+ * 파일을 복제하지 못하면 false를 반환한다.
+ */
+static bool duplicate_fds (struct thread *parent) {
+	struct fd_table *fdt = &thread_current()->fdt;
+
+	for (int fd = fd_table_next(&parent->fdt, 0); fd >= 0;
+			fd = fd_table_next(&parent->fdt, fd + 1)) {
+		struct file *f = file_duplicate(fd_table_get(&parent->fdt, fd));
+		if (f == NULL)
+			return false;
+		if (!fd_table_install(fdt, fd, f)) {
+			file_close(f);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* What process_spawn() hands to the child it creates. */
+struct spawn_args {
+	char *cmd_line;                     /* Command line, in a page. */
+	struct thread *parent;              /* Process calling spawn(). */
+	const struct spawn_action *actions; /* File actions to apply. */
+	int action_cnt;                     /* Number of ACTIONS. */
+	bool success;                       /* Whether the child loaded. */
+};
+
+/* process_spawn - CMD_LINE 프로그램을 새 프로세스로 실행하고 그 tid를 반환한다.
+ * fork()와 달리 부모의 주소 공간을 복제하지 않고 빈 주소 공간에 바로 로드한다.
+ * 자식은 부모의 파일 디스크립터를 물려받은 뒤 ACTIONS를 차례로 적용한다.
+ * CMD_LINE은 palloc 페이지로, 이 함수가 소유권을 가져간다.
+ * 자식이 로드될 때까지 기다리며, 실패하면 TID_ERROR를 반환한다.
+ */
+tid_t process_spawn (char *cmd_line, const struct spawn_action *actions,
+		int action_cnt) {
+	struct spawn_args args = {cmd_line, thread_current(), actions, action_cnt, false};
+	char name[sizeof thread_current()->name];
+	struct exit_record *child;
+	tid_t tid;
+
+	/* 스레드 이름은 명령줄의 첫 단어이다. */
+	strlcpy(name, cmd_line, sizeof name);
+	name[strcspn(name, " ")] = '\0';
+
+	tid = thread_create(name, PRI_DEFAULT, spawn_child, &args);
+	if (tid == TID_ERROR) {
+		palloc_free_page(cmd_line);
+		return TID_ERROR;
+	}
+	child = get_child_process(tid);
+	sema_down(&child->loaded);
+	if (!args.success) {
+		/* 자식은 이미 종료하는 중이니 바로 회수한다. */
+		process_wait(tid);
+		return TID_ERROR;
+	}
+	return tid;
+}
+
+/* spawn_child - process_spawn()이 만든 자식 프로세스를 시작하는 스레드 함수
+ * 부모는 자식이 로드에 성공했는지 알 때까지 process_spawn()에서 기다리므로
+ * 그동안 부모의 파일 디스크립터 테이블과 AUX는 바뀌지 않는다.
+ */
+static void spawn_child (void *aux) {
+	struct spawn_args *args = aux;
+	struct fd_table *fdt = &thread_current()->fdt;
+
+#ifdef VM
+	supplemental_page_table_init (&thread_current ()->spt);
+#endif
+	process_init();
+
+	if (!duplicate_fds(args->parent))
+		goto error;
+	for (int i = 0; i < args->action_cnt; i++) {
+		const struct spawn_action *a = &args->actions[i];
+		struct file *f;
+
+		switch (a->op) {
+		case SPAWN_CLOSE:
+			f = fd_table_remove(fdt, a->fd);
+			if (f == NULL)
+				goto error;
+			file_close(f);
+			break;
+		case SPAWN_DUP2:
+			f = fd_table_get(fdt, a->fd);
+			if (f == NULL || a->newfd < 0)
+				goto error;
+			if (a->newfd == a->fd)
+				break;
+			f = file_dup(f);
+			file_close(fd_table_remove(fdt, a->newfd));
+			if (!fd_table_install(fdt, a->newfd, f)) {
+				file_close(f);
+				goto error;
+			}
+			break;
+		default:
+			goto error;
+		}
+	}
+
+	/* process_exec()는 로드에 성공하면 부모를 깨우고 돌아오지 않는다. */
+	args->success = true;
+	process_exec(args->cmd_line);
+	args->success = false;
+	signal_loaded();
+	exit(-1);
+
+error:
+	palloc_free_page(args->cmd_line);
+	signal_loaded();
+	exit(-1);
+}
+
 /* process_exec - 현재 실행 컨텍스트를 f_name으로 전환한다.
  * 실패 시 -1을 반환한다.
  */
@@ -215,6 +434,9 @@ int process_exec (void *f_name) {
 
 	/* 먼저 현재 컨텍스트를 죽인다. */
 	process_cleanup ();
+	/* 이전 실행 파일은 더 이상 쓰지 않으므로 닫아 쓰기를 다시 허용한다. */
+	file_close (thread_current ()->self_file);
+	thread_current ()->self_file = NULL;
 
 	/* Project 2: Command to Word */
 	char *argv[64];
@@ -226,6 +448,12 @@ int process_exec (void *f_name) {
 	/* 그리고 바이너리를 불러온다. */
 	success = load(file_name, &_if);
 
+	/* 로드에 실패하면 종료한다.  스택이 없으므로 인자도 넣지 않는다. */
+	if (!success) {
+		palloc_free_page(f_name);
+		return -1;
+	}
+
 	/* Project 2: Argument Passing */
 	set_userstack(argv, argc, &_if);
 	_if.R.rdi = argc;
@@ -233,12 +461,8 @@ int process_exec (void *f_name) {
 	// hex_dump(_if.rsp, _if.rsp, USER_STACK - (uint64_t)_if.rsp, true);
 
 	palloc_free_page(f_name);
-	/* 로드에 실패하면 종료한다. */
-	if (!success) {
-		return -1;
-	}
 
-	sema_up(&thread_current()->load_sema);
+	signal_loaded();
 	/* 전환된 사용자 프로세스를 시작한다. */
 	do_iret (&_if);
 	NOT_REACHED ();
@@ -253,40 +477,57 @@ int process_exec (void *f_name) {
  * 즉시 -1을 반환하고 기다리지 않는다.
  */
 int process_wait (tid_t child_tid) {
-	struct thread *cur = thread_current();
-	struct thread *child = get_child_process(child_tid);
+	struct exit_record *child = get_child_process(child_tid);
+	int status;
+
 	if (child == NULL)
 		return -1;
-	sema_down(&child->wait_sema);
-	list_remove(&child->child_elem);
-	sema_up(&child->exit_sema);
-	return child->exit_status;
+	sema_down(&child->done);
+	status = child->status;
+
+	lock_acquire(&exit_records_lock);
+	hash_delete(&exit_records, &child->hash_elem);
+	list_remove(&child->elem);
+	exit_record_release(child);
+	lock_release(&exit_records_lock);
+	return status;
 }
 
 /* process_exit - 현재 프로세스를 종료한다.
  * 이 함수는 thread_exit()에 의해 호출되고, 프로세스의 자원을 정리한다.
- * process_cleanup()의 호출 순서가 중요하다.
+ * 부모를 기다리지 않고 주소 공간까지 모두 해제한 뒤 종료 레코드로
+ * 종료 상태를 넘기므로, 회수되지 않은 자식도 레코드 하나만 남는다.
  */
 void process_exit (void) {
 	struct thread *t = thread_current();
+	struct exit_record *rec = t->exit_record;
 
-	for (int fd = 2; fd < FDT_SIZE; fd++) {
-		if (t->fdt[fd] != NULL) {
-			close(fd);
-		}
-	}
-
-	palloc_free_multiple(t->fdt, FDT_PAGES);
+	for (int fd = fd_table_next(&t->fdt, 0); fd >= 0;
+			fd = fd_table_next(&t->fdt, fd + 1))
+		close(fd);
+	fd_table_destroy(&t->fdt);
 	file_close(t->self_file);
-#ifdef VM
 	process_cleanup();
+	vdata_exit();
+#ifdef VM
 	hash_destroy(&t->spt.pages, NULL);
 #endif
-	sema_up(&t->wait_sema);
-	sema_down(&t->exit_sema);
-#ifndef VM
-	process_cleanup();
-#endif
+
+	lock_acquire(&exit_records_lock);
+	/* 회수하지 않은 자식들의 레코드는 더 이상 필요 없다. */
+	while (!list_empty(&t->children)) {
+		struct exit_record *child = list_entry(list_pop_front(&t->children),
+				struct exit_record, elem);
+		hash_delete(&exit_records, &child->hash_elem);
+		exit_record_release(child);
+	}
+	if (rec != NULL) {
+		rec->status = t->exit_status;
+		sema_up(&rec->done);
+		exit_record_release(rec);
+		t->exit_record = NULL;
+	}
+	lock_release(&exit_records_lock);
 }
 
 /* Free the current process's resources. */
@@ -294,6 +535,8 @@ static void
 process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
+	/* The ring's workers may still be using the address space. */
+	io_ring_destroy (curr);
 #ifdef VM
 	supplemental_page_table_kill (&curr->spt);
 #endif
@@ -308,6 +551,7 @@ process_cleanup (void) {
 		 * 프로세스 페이지 디렉토리를 파괴하기 전에 기본 페이지 디렉토리를 활성화해야 한다.
 		 * 그렇지 않으면 활성 페이지 디렉토리는 해제(및 지워짐)된 페이지 디렉토리가 될 것이다.
 		 */
+		vdata_unmap ();
 		curr->pml4 = NULL;
 		pml4_activate (NULL);
 		pml4_destroy (pml4);
@@ -384,31 +628,15 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		uint32_t read_bytes, uint32_t zero_bytes,
 		bool writable);
 
-/* FILE_NAME에서 현재 스레드로 ELF 실행 파일을 로드한다.
- * 실행 파일의 진입점을 *RIP에, 초기 스택 포인터를 *RSP에 저장한다.
- * 성공하면 true, 실패하면 false를 반환한다.
+/* read_image - FILE의 ELF 헤더와 프로그램 헤더를 읽고 검증해 적재할 세그먼트 배치를 반환한다.
+ * 실행 파일이 올바르지 않거나 메모리가 부족하면 NULL을 반환한다.
  */
-static bool load (const char *file_name, struct intr_frame *if_) {
-	struct thread *t = thread_current ();
+static struct exec_image *read_image (const char *file_name, struct file *file) {
+	struct exec_image *image;
 	struct ELF ehdr;
-	struct file *file = NULL;
 	off_t file_ofs;
-	bool success = false;
 	int i;
 
-	/* Allocate and activate page directory. */
-	t->pml4 = pml4_create ();
-	if (t->pml4 == NULL)
-		goto done;
-	process_activate (thread_current ());
-
-	/* Open executable file. */
-	file = filesys_open (file_name);
-	if (file == NULL) {
-		printf ("load: %s: open failed\n", file_name);
-		return false;
-	}
-
 	/* Read and verify executable header. */
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
 			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
@@ -418,20 +646,27 @@ static bool load (const char *file_name, struct intr_frame *if_) {
 			|| ehdr.e_phentsize != sizeof (struct Phdr)
 			|| ehdr.e_phnum > 1024) {
 		printf ("load: %s: error loading executable\n", file_name);
-		goto done;
+		return NULL;
 	}
 
+	image = malloc (sizeof *image + ehdr.e_phnum * sizeof *image->segments);
+	if (image == NULL)
+		return NULL;
+	image->entry = ehdr.e_entry;
+	image->refs = 1;
+	image->segment_cnt = 0;
+
 	/* Read program headers. */
 	file_ofs = ehdr.e_phoff;
 	for (i = 0; i < ehdr.e_phnum; i++) {
 		struct Phdr phdr;
 
 		if (file_ofs < 0 || file_ofs > file_length (file))
-			goto done;
+			goto error;
 		file_seek (file, file_ofs);
 
 		if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
+			goto error;
 		file_ofs += sizeof phdr;
 		switch (phdr.p_type) {
 			case PT_NULL:
@@ -444,35 +679,82 @@ static bool load (const char *file_name, struct intr_frame *if_) {
 			case PT_DYNAMIC:
 			case PT_INTERP:
 			case PT_SHLIB:
-				goto done;
+				goto error;
 			case PT_LOAD:
 				if (validate_segment (&phdr, file)) {
-					bool writable = (phdr.p_flags & PF_W) != 0;
-					uint64_t file_page = phdr.p_offset & ~PGMASK;
-					uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
+					struct exec_segment *seg = &image->segments[image->segment_cnt++];
 					uint64_t page_offset = phdr.p_vaddr & PGMASK;
-					uint32_t read_bytes, zero_bytes;
+
+					seg->writable = (phdr.p_flags & PF_W) != 0;
+					seg->file_page = phdr.p_offset & ~PGMASK;
+					seg->mem_page = phdr.p_vaddr & ~PGMASK;
 					if (phdr.p_filesz > 0) {
 						/* Normal segment.
 						 * Read initial part from disk and zero the rest. */
-						read_bytes = page_offset + phdr.p_filesz;
-						zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-								- read_bytes);
+						seg->read_bytes = page_offset + phdr.p_filesz;
+						seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
+								- seg->read_bytes);
 					} else {
 						/* Entirely zero.
 						 * Don't read anything from disk. */
-						read_bytes = 0;
-						zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+						seg->read_bytes = 0;
+						seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
 					}
-					if (!load_segment (file, file_page, (void *) mem_page,
-								read_bytes, zero_bytes, writable))
-						goto done;
 				}
 				else
-					goto done;
+					goto error;
 				break;
 		}
 	}
+	return image;
+
+error:
+	free (image);
+	return NULL;
+}
+
+/* FILE_NAME에서 현재 스레드로 ELF 실행 파일을 로드한다.
+ * 실행 파일의 진입점을 *RIP에, 초기 스택 포인터를 *RSP에 저장한다.
+ * 성공하면 true, 실패하면 false를 반환한다.
+ *
+ * 같은 실행 파일을 다시 로드할 때는 exec 캐시에 남겨 둔 세그먼트 배치를 써서
+ * 헤더를 읽고 검증하는 과정을 건너뛴다.
+ */
+static bool load (const char *file_name, struct intr_frame *if_) {
+	struct thread *t = thread_current ();
+	struct exec_image *image = NULL;
+	struct file *file = NULL;
+	bool success = false;
+	int i;
+
+	/* Allocate and activate page directory. */
+	t->pml4 = pml4_create ();
+	if (t->pml4 == NULL)
+		goto done;
+	process_activate (thread_current ());
+
+	/* Open executable file. */
+	file = filesys_open (file_name);
+	if (file == NULL) {
+		printf ("load: %s: open failed\n", file_name);
+		return false;
+	}
+
+	image = exec_cache_lookup (file_get_inode (file));
+	if (image == NULL) {
+		image = read_image (file_name, file);
+		if (image == NULL)
+			goto done;
+		exec_cache_insert (file_get_inode (file), image);
+	}
+
+	for (i = 0; i < image->segment_cnt; i++) {
+		const struct exec_segment *seg = &image->segments[i];
+
+		if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+					seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
+	}
 
 	t->self_file = file;
 	file_deny_write(file);
@@ -480,16 +762,18 @@ static bool load (const char *file_name, struct intr_frame *if_) {
 	if (!setup_stack (if_))
 		goto done;
 
-	/* Start address. */
-	if_->rip = ehdr.e_entry;
+	/* Map the kernel data pages. */
+	if (!vdata_map ())
+		goto done;
 
-	/* TODO: Your code goes here.
-	 * TODO: Implement argument passing (see project2/argument_passing.html). */
+	/* Start address. */
+	if_->rip = image->entry;
 
 	success = true;
 
 done:
 	/* We arrive here whether the load is successful or not. */
+	exec_image_release (image);
 	return success;
 }
 
@@ -760,17 +1044,23 @@ void set_userstack(char **argv, int argc, struct intr_frame *if_) {
 	memset(if_->rsp, 0, sizeof(void *));
 }
 
-struct thread *get_child_process(tid_t pid) {
-	struct thread *t = thread_current();
-	struct list_elem *e;
-
-	for (e = list_begin(&t->child_list); e != list_end(&t->child_list); e = list_next(e)) {
-		struct thread *child = list_entry(e, struct thread, child_elem);
-		if (pid == child->tid) {
-			return child;
-		}
+/* get_child_process - 현재 프로세스의 자식 PID의 종료 레코드를 반환한다.
+ * 그런 자식이 없거나 이미 회수했다면 NULL을 반환한다.
+ */
+static struct exit_record *get_child_process(tid_t pid) {
+	struct exit_record key, *rec = NULL;
+	struct hash_elem *e;
+
+	key.tid = pid;
+	lock_acquire(&exit_records_lock);
+	e = hash_find(&exit_records, &key.hash_elem);
+	if (e != NULL) {
+		rec = hash_entry(e, struct exit_record, hash_elem);
+		if (rec->parent != thread_current())
+			rec = NULL;
 	}
-	return NULL;
+	lock_release(&exit_records_lock);
+	return rec;
 }
 
 void print_intr_frame(struct intr_frame *f) {
@@ -1,6 +1,11 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <limits.h>
 #include <syscall-nr.h>
+#include <spawn.h>
+#include <futex.h>
+#include <tty.h>
+#include <poll.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
@@ -9,12 +14,21 @@
 #include "intrinsic.h"
 #include "include/threads/init.h"
 #include "filesys/filesys.h"
+#include "filesys/file.h"
 #include "userprog/process.h"
+#include "userprog/exec-cache.h"
+#include "userprog/io-ring.h"
+#include "userprog/futex.h"
+#include "userprog/vdata.h"
+#include "userprog/uaccess.h"
 #include "include/lib/stdio.h"
 #include "include/lib/string.h"
 #include "include/lib/user/syscall.h"
 #include "devices/input.h"
+#include "devices/disk.h"
+#include "devices/timer.h"
 #include "include/threads/palloc.h"
+#include "threads/malloc.h"
 
 
 void syscall_entry (void);
@@ -23,6 +37,7 @@ void halt(void);
 void exit(int status);
 pid_t fork(const char *thread_name);
 int exec(const char *cmd_line);
+pid_t spawn(const char *cmd_line, const struct spawn_action *actions, int action_cnt);
 int wait(pid_t pid);
 bool create(const char *file, unsigned initial_size);
 bool remove(const char *file);
@@ -33,9 +48,19 @@ int write(int fd, const void *buffer, unsigned size);
 void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
-void check_address(uintptr_t addr);
+int dup2(int oldfd, int newfd);
+int pipe(int fds[2]);
+int shm_open(const char *name, size_t size);
+void *shm_map(int id, void *addr, bool writable);
+int futex(int *addr, int op, int val, int *addr2);
+int tty_mode(int mode);
+int tty_poll(void);
+int poll(struct pollfd *fds, int nfds, int timeout);
 int add_file_to_fdt(struct file *file);
 struct file *get_file_from_fd(int fd);
+static char *copy_in_string(const char *ustr);
+static int read_to_user(struct file *file, const struct iovec *iov, int iovcnt, off_t pos);
+static int write_from_user(struct file *file, const struct iovec *iov, int iovcnt, off_t pos);
 
 static struct intr_frame *frame;
 /* System call.
@@ -85,6 +110,9 @@ void syscall_handler (struct intr_frame *f) {
 	case SYS_EXEC:
 		f->R.rax = exec(f->R.rdi);
 		break;
+	case SYS_SPAWN:
+		f->R.rax = spawn(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
 	case SYS_WAIT:
 		f->R.rax = wait(f->R.rdi);
 		break;
@@ -121,6 +149,57 @@ void syscall_handler (struct intr_frame *f) {
 	case SYS_MUNMAP:
 		munmap(f->R.rdi);
 		break;
+	case SYS_DISK_STATS:
+		f->R.rax = disk_stats(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_READV:
+		f->R.rax = readv(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_WRITEV:
+		f->R.rax = writev(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_PREAD:
+		f->R.rax = pread(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_PWRITE:
+		f->R.rax = pwrite(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_SENDFILE:
+		f->R.rax = sendfile(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_COPY_FILE_RANGE:
+		f->R.rax = copy_file_range(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8);
+		break;
+	case SYS_IO_SETUP:
+		f->R.rax = io_setup(f->R.rdi);
+		break;
+	case SYS_IO_ENTER:
+		f->R.rax = io_enter(f->R.rdi, f->R.rsi);
+		break;
+	case SYS_DUP2:
+		f->R.rax = dup2(f->R.rdi, f->R.rsi);
+		break;
+	case SYS_PIPE:
+		f->R.rax = pipe(f->R.rdi);
+		break;
+	case SYS_SHM_OPEN:
+		f->R.rax = shm_open(f->R.rdi, f->R.rsi);
+		break;
+	case SYS_SHM_MAP:
+		f->R.rax = shm_map(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
+	case SYS_FUTEX:
+		f->R.rax = futex(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+		break;
+	case SYS_TTY_MODE:
+		f->R.rax = tty_mode(f->R.rdi);
+		break;
+	case SYS_TTY_POLL:
+		f->R.rax = tty_poll();
+		break;
+	case SYS_POLL:
+		f->R.rax = poll(f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
 	default:
 		thread_exit();
 		break;
@@ -169,12 +248,10 @@ pid_t fork(const char *thread_name) {
  * 실행 호출이 진행되는 동안 fd는 열린 상태로 유지된다.
  */
 int exec(const char *cmd_line) {
-	check_address(cmd_line);
-	char *cpname = palloc_get_page(PAL_ZERO);
+	char *cpname = copy_in_string(cmd_line);
 	if (cpname == NULL) {
 		exit(-1);
 	}
-	strlcpy(cpname, cmd_line, strlen(cmd_line) + 1);
 
 	if (process_exec(cpname) < 0){
 		exit(-1);
@@ -183,6 +260,29 @@ int exec(const char *cmd_line) {
 	NOT_REACHED();
 }
 
+/* spawn - cmd_line 프로그램을 새 자식 프로세스로 실행하고 그 pid를 반환한다.
+ * fork()와 exec()을 합친 것과 같지만 호출 프로세스의 주소 공간을 복제하지 않는다.
+ * 자식은 호출 프로세스의 fd를 물려받고, 프로그램이 시작되기 전에
+ * actions의 action_cnt개 작업을 차례로 적용한다.
+ * 프로그램을 로드할 수 없거나 작업이 실패하면 -1을 반환한다.
+ */
+pid_t spawn(const char *cmd_line, const struct spawn_action *actions, int action_cnt) {
+	struct spawn_action kactions[SPAWN_ACTIONS_MAX];
+	char *cpname;
+
+	if (action_cnt < 0 || action_cnt > SPAWN_ACTIONS_MAX) {
+		return -1;
+	}
+	if (!copy_from_user(kactions, actions, action_cnt * sizeof *kactions)) {
+		exit(-1);
+	}
+	cpname = copy_in_string(cmd_line);
+	if (cpname == NULL) {
+		return -1;
+	}
+	return process_spawn(cpname, kactions, action_cnt);
+}
+
 /* wait - 자식 프로세스 pid가 종료될 때까지 기다렸다가 자식의 종료 상태를 반환한다.
  * 자식 프로세스가 exit()를 호출하지 않았지만 커널에 의해 종료된 경우(예: 예외로 인해 종료된 경우) -1을 반환해야 한다. 
  * 부모 프로세스가 이미 종료된 자식 프로세스를 기다리는 것은 가능하지만, 
@@ -206,8 +306,15 @@ int wait(pid_t pid) {
  * 새 파일을 여는 것은 open 시스템 호출이 필요한 별도의 작업이다.
  */
 bool create(const char *file, unsigned initial_size) {
-	check_address(file);
-	return filesys_create(file, initial_size);
+	char *name = copy_in_string(file);
+	bool success = false;
+	if (name != NULL) {
+		lock_acquire(&filesys_lock);
+		success = filesys_create(name, initial_size);
+		lock_release(&filesys_lock);
+		palloc_free_page(name);
+	}
+	return success;
 }
 
 /* remove - 파일을 삭제하고 성공 여부를 반환한다.
@@ -218,10 +325,17 @@ bool create(const char *file, unsigned initial_size) {
  * 모든 fd가 닫히거나 컴퓨터가 종료될 때까지 파일은 계속 존재한다.
  */
 bool remove(const char *file) {
-	check_address(file);
-	lock_acquire(&filesys_lock);
-	bool success = filesys_remove(file);
-	lock_release(&filesys_lock);
+	char *name = copy_in_string(file);
+	bool success = false;
+	if (name != NULL) {
+		lock_acquire(&filesys_lock);
+		success = filesys_remove(name);
+		if (success) {
+			exec_cache_prune();
+		}
+		lock_release(&filesys_lock);
+		palloc_free_page(name);
+	}
 	return success;
 }
 
@@ -245,9 +359,13 @@ bool remove(const char *file) {
  * 추가 작업을 수행하려면 0부터 시작하는 정수를 반환하는 Linux 체계를 따라야 한다.
  */
 int open(const char *file) {
-	check_address(file);
+	char *name = copy_in_string(file);
+	if (name == NULL) {
+		return -1;
+	}
 	lock_acquire(&filesys_lock);
-	struct file *file_open = filesys_open(file);
+	struct file *file_open = filesys_open(name);
+	palloc_free_page(name);
 	if (file_open == NULL) {
 		lock_release(&filesys_lock);
 		return -1;
@@ -276,31 +394,19 @@ int filesize(int fd) {
 /* read - fd로 열린 파일에서 buffer로 size 바이트를 읽는다.
  * 실제로 읽은 바이트 수(파일 끝에서 0) 또는 
  * 파일을 읽을 수 없는 경우(파일 끝이 아닌 다른 조건으로 인해) -1을 반환한다.
- * fd 0은 input_getc()를 사용하여 키보드에서 읽는다. 
+ * fd 0은 콘솔 입력에서 읽는다. 기본(canonical) 모드에서는 한 줄이 다 들어올 때까지 기다렸다가
+ * 줄 끝(개행 문자)까지만 읽고, tty_mode()로 바꿀 수 있다.
  */
 int read(int fd, void *buffer, unsigned size) {
-	check_address(buffer);
+	struct iovec iov = { buffer, size };
 	struct file *_file = get_file_from_fd(fd);
-	if (_file == NULL) {
+	if (_file == NULL && fd != STDIN_FILENO) {
 		return -1;
 	}
-	struct page *page = spt_find_page(&thread_current()->spt, buffer);
-	if (page && !page->writable) {
-		exit(-1);
-	}
-	int byte = 0;
-	char *_buffer;
-	if (fd == STDIN_FILENO) {
-		_buffer = buffer;
-		while (byte < size) {
-			_buffer[byte++] = input_getc();
-		}
-		return byte;
+	if (size > INT_MAX) {
+		return -1;
 	}
-	lock_acquire(&filesys_lock);
-	int byte_ = file_read(_file, buffer, size);
-	lock_release(&filesys_lock);
-	return byte_;
+	return read_to_user(_file, &iov, 1, -1);
 }
 
 /* write - fd로 열린 파일에 buffer에서 size 바이트를 쓴다.
@@ -315,24 +421,15 @@ int read(int fd, void *buffer, unsigned size) {
  * 그렇지 않으면 다른 프로세스에서 출력한 텍스트 줄이 콘솔에 인터리빙되어 읽는 사람과 채점 스크립트 모두를 혼란스럽게 만들 수 있다.
  */
 int write(int fd, const void *buffer, unsigned size) {
-	check_address(buffer);
-	if (fd == STDIN_FILENO) {
+	struct iovec iov = { (void *) buffer, size };
+	struct file *_file = get_file_from_fd(fd);
+	if (_file == NULL && fd != STDOUT_FILENO) {
 		return -1;
 	}
-	else if (fd == STDOUT_FILENO) {
-		putbuf(buffer, size);
-		return size;
+	if (size > INT_MAX) {
+		return -1;
 	}
-	else {
-		struct file *_file = get_file_from_fd(fd);
-		if (_file == NULL) {
-			return -1;
-		}
-		lock_acquire(&filesys_lock);
-		int byte = file_write(_file, buffer, size);
-		lock_release(&filesys_lock);
-		return byte;
-	}	
+	return write_from_user(_file, &iov, 1, -1);
 }
 
 /* seek - 열린 파일 fd에서 읽거나 쓸 다음 바이트를 파일 시작부터 바이트 단위로 표시되는 position으로 변경한다.
@@ -357,14 +454,16 @@ unsigned tell(int fd) {
 
 /* close - fd를 닫는다.
  * 프로세스를 exit하거나 terminate하면 열려 있는 모든 fd가 닫혀야 한다.
+ * I/O 링에서 진행 중인 작업이 파일을 쓰고 있을 수 있으므로 먼저 끝나기를 기다린다.
  */
 void close(int fd) {
 	struct file *_file = get_file_from_fd(fd);
 	if (_file == NULL) {
 		return;
 	}
+	io_ring_drain(thread_current());
+	fd_table_remove(&thread_current()->fdt, fd);
 	file_close(_file);
-	thread_current()->fdt[fd] = NULL;
 }
 
 /* mmap - offset 바이트에서 시작하여 fd로 열린 파일의 
@@ -374,6 +473,10 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
 	if (addr == NULL || pg_round_down(addr) != addr || is_kernel_vaddr(addr + length) || is_kernel_vaddr(addr)) {
 		return NULL;
 	}
+	/* 커널 데이터 페이지 위에는 매핑할 수 없다. */
+	if (vdata_overlaps(addr, length)) {
+		return NULL;
+	}
 
 	if (offset != pg_round_down(offset)) {
 		return NULL;
@@ -395,53 +498,641 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
 }
 
 /* munmap - 지정된 주소 범위 addr에 대한 매핑을 언매핑한다.
+ * I/O 링에서 진행 중인 작업이 매핑된 페이지를 쓰고 있을 수 있으므로 먼저 끝나기를 기다린다.
  */
 void munmap(void *addr) {
+	io_ring_drain(thread_current());
 	do_munmap(addr);
 }
 
-/* check_address - 주소가 유효한지 확인한다.
- * 1. 주소가 NULL인 경우
- * 2. 주소가 유저 영역이 아닌 커널 영역인 경우
+/* shm_open - 이름이 name인 공유 메모리 세그먼트를 찾고, 없으면 size 바이트로 만든다.
+ * 세그먼트는 파일과 무관한 익명 메모리로, 디스크에 쓰이지 않는다.
+ * 세그먼트 id를 반환하며, 이름이 잘못되었거나 기존 세그먼트가 size보다 작거나
+ * 메모리가 부족하면 -1을 반환한다.
  */
-void check_address(uintptr_t addr) {
-	if (addr == NULL) {
-		exit(-1);
+int shm_open(const char *name, size_t size) {
+	char *kname = copy_in_string(name);
+	int id;
+
+	if (kname == NULL) {
+		return -1;
+	}
+	id = shm_get(kname, size);
+	palloc_free_page(kname);
+	return id;
+}
+
+/* shm_map - id 세그먼트 전체를 addr에 매핑한다. 매핑을 가진 모든 프로세스가 같은 프레임을 보며,
+ * fork한 자식도 복사본이 아니라 같은 세그먼트를 공유한다. munmap(addr)으로 해제한다.
+ * addr을 반환하며, 세그먼트가 없거나 addr이 알맞지 않거나 이미 쓰이는 영역과 겹치면 NULL을 반환한다.
+ */
+void *shm_map(int id, void *addr, bool writable) {
+	return shm_attach(id, addr, writable) ? addr : NULL;
+}
+
+/* copy_in_string - 유저 문자열 ustr을 새 커널 페이지로 복사해 반환한다.
+ * 반환된 페이지는 호출자가 palloc_free_page()로 해제해야 한다.
+ * 읽을 수 없는 주소이면 프로세스를 종료하고, 한 페이지보다 길거나 메모리가 부족하면 NULL을 반환한다.
+ */
+static char *copy_in_string(const char *ustr) {
+	char *kstr = palloc_get_page(0);
+	long len;
+
+	if (kstr == NULL) {
+		return NULL;
 	}
-	if (!is_user_vaddr(addr)) {
+	len = strncpy_from_user(kstr, ustr, PGSIZE);
+	if (len < 0) {
+		palloc_free_page(kstr);
 		exit(-1);
 	}
+	if (len == PGSIZE) {
+		palloc_free_page(kstr);
+		return NULL;
+	}
+	return kstr;
 }
 
-/* add_file_to_fdt - file을 fdt에 추가하고 fd를 반환한다.
+/* read_to_user - 파일 file에서 읽어 유저의 iovcnt개 버퍼 iov에 차례로 채운다.
+ * file이 NULL이면 콘솔 입력에서 한 번에 넘겨받을 수 있는 만큼(canonical 모드에서는 한 줄) 읽는다. pos가 음수이면 파일의 현재 위치부터 읽고 위치를 옮기며,
+ * 아니면 pos부터 읽는다.
+ * 커널 페이지 하나를 거쳐 PGSIZE 바이트씩 읽고 copy_to_user()로 버퍼에 나누어 복사하므로,
+ * 파일 시스템 락은 페이지마다 한 번만 잡고 유저 페이지 폴트는 락 밖에서 일어난다.
+ * 파이프는 비어 있으면 잠들 수 있으므로 파일 시스템 락 없이 읽는다.
+ * 버퍼에 쓸 수 없으면 프로세스를 종료한다. 읽은 바이트 수를 반환한다.
  */
-int add_file_to_fdt(struct file *file) {
-	struct thread *t = thread_current();
-	int fd = 2;
-	while (t->fdt[fd] != NULL && fd < FDT_SIZE) {
-		fd++;
+static int read_to_user(struct file *file, const struct iovec *iov, int iovcnt, off_t pos) {
+	char *kbuf = palloc_get_page(0);
+	size_t total = 0, seg_ofs = 0;
+	int byte = 0, seg = 0, i;
+
+	if (kbuf == NULL) {
+		return -1;
+	}
+	for (i = 0; i < iovcnt; i++) {
+		total += iov[i].iov_len;
+	}
+	while ((size_t) byte < total) {
+		off_t chunk = total - byte < PGSIZE ? total - byte : PGSIZE;
+		off_t n, done;
+
+		if (file == NULL) {
+			n = input_read((uint8_t *) kbuf, chunk);
+		}
+		else if (file_is_pipe(file)) {
+			n = file_read(file, kbuf, chunk);
+		}
+		else {
+			lock_acquire(&filesys_lock);
+			n = pos < 0 ? file_read(file, kbuf, chunk) : file_read_at(file, kbuf, chunk, pos + byte);
+			lock_release(&filesys_lock);
+		}
+
+		for (done = 0; done < n; ) {
+			size_t take = iov[seg].iov_len - seg_ofs;
+			if (take == 0) {
+				seg++;
+				seg_ofs = 0;
+				continue;
+			}
+			if (take > (size_t) (n - done)) {
+				take = n - done;
+			}
+			if (!copy_to_user((char *) iov[seg].iov_base + seg_ofs, kbuf + done, take)) {
+				palloc_free_page(kbuf);
+				exit(-1);
+			}
+			done += take;
+			seg_ofs += take;
+		}
+		byte += n;
+		if (n < chunk) {
+			break;
+		}
 	}
-	if (fd >= FDT_SIZE) {
+	palloc_free_page(kbuf);
+	return byte;
+}
+
+/* write_from_user - 유저의 iovcnt개 버퍼 iov를 차례로 파일 file에 쓴다.
+ * file이 NULL이면 콘솔에 쓴다. pos의 의미는 read_to_user()와 같다.
+ * copy_from_user()로 버퍼들을 커널 페이지 하나에 모아 PGSIZE 바이트씩 쓰며,
+ * 콘솔에는 페이지마다 putbuf()를 한 번 호출하고, 파이프에는 파일 시스템 락 없이 쓴다.
+ * 버퍼를 읽을 수 없으면 프로세스를 종료한다. 쓴 바이트 수를 반환한다.
+ */
+static int write_from_user(struct file *file, const struct iovec *iov, int iovcnt, off_t pos) {
+	char *kbuf = palloc_get_page(0);
+	size_t total = 0, seg_ofs = 0;
+	int byte = 0, seg = 0, i;
+
+	if (kbuf == NULL) {
 		return -1;
 	}
-	t->fdt[fd] = file;
+	for (i = 0; i < iovcnt; i++) {
+		total += iov[i].iov_len;
+	}
+	while ((size_t) byte < total) {
+		off_t chunk = total - byte < PGSIZE ? total - byte : PGSIZE;
+		off_t n, done;
 
-	return fd;
+		for (done = 0; done < chunk; ) {
+			size_t take = iov[seg].iov_len - seg_ofs;
+			if (take == 0) {
+				seg++;
+				seg_ofs = 0;
+				continue;
+			}
+			if (take > (size_t) (chunk - done)) {
+				take = chunk - done;
+			}
+			if (!copy_from_user(kbuf + done, (char *) iov[seg].iov_base + seg_ofs, take)) {
+				palloc_free_page(kbuf);
+				exit(-1);
+			}
+			done += take;
+			seg_ofs += take;
+		}
+
+		if (file == NULL) {
+			putbuf(kbuf, chunk);
+			n = chunk;
+		}
+		else if (file_is_pipe(file)) {
+			n = file_write(file, kbuf, chunk);
+		}
+		else {
+			lock_acquire(&filesys_lock);
+			n = pos < 0 ? file_write(file, kbuf, chunk) : file_write_at(file, kbuf, chunk, pos + byte);
+			lock_release(&filesys_lock);
+		}
+		byte += n;
+		if (n < chunk) {
+			break;
+		}
+	}
+	palloc_free_page(kbuf);
+	return byte;
 }
 
-/* get_file_from_fd - fd에 해당하는 file을 반mm환한다.
- * fd가 2보다 작거나 FDT_SIZE보다 큰 경우 NULL을 반환하고,
- * fd에 해당하는 file이 없는 경우 NULL을 반환한다.
+/* copy_iovec - 유저의 iovcnt개 iovec 배열 iov를 커널로 복사한다.
+ * 커널 복사본을 반환하며, 호출자가 free해야 한다.
+ * 배열을 읽을 수 없으면 프로세스를 종료하고,
+ * iovcnt가 잘못되었거나 전체 길이가 int를 넘거나 메모리가 부족하면 NULL을 반환한다.
  */
-struct file *get_file_from_fd(int fd) {
-	if (fd < 2 || fd >= FDT_SIZE) {
+static struct iovec *copy_iovec(const struct iovec *iov, int iovcnt) {
+	struct iovec *kiov;
+	size_t total = 0;
+	int i;
+
+	if (iovcnt <= 0 || iovcnt > IOV_MAX) {
 		return NULL;
 	}
-	struct file *_file = thread_current()->fdt[fd];
-	if (_file == NULL)  {
+	kiov = malloc(iovcnt * sizeof *kiov);
+	if (kiov == NULL) {
 		return NULL;
 	}
+	if (!copy_from_user(kiov, iov, iovcnt * sizeof *kiov)) {
+		free(kiov);
+		exit(-1);
+	}
+	for (i = 0; i < iovcnt; i++) {
+		if (kiov[i].iov_len > INT_MAX - total) {
+			free(kiov);
+			return NULL;
+		}
+		total += kiov[i].iov_len;
+	}
+	return kiov;
+}
+
+/* readv - fd로 열린 파일에서 iov의 iovcnt개 버퍼에 차례로 읽는다.
+ * 파일 시스템 락과 inode 계층은 버퍼 개수와 상관없이 페이지마다 한 번만 거친다.
+ * 실제로 읽은 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+	struct iovec *kiov = copy_iovec(iov, iovcnt);
+	struct file *_file = NULL;
+	int byte = -1;
+
+	if (kiov == NULL) {
+		return -1;
+	}
+	if ((_file = get_file_from_fd(fd)) != NULL || fd == STDIN_FILENO) {
+		byte = read_to_user(_file, kiov, iovcnt, -1);
+	}
+	free(kiov);
+	return byte;
+}
+
+/* writev - iov의 iovcnt개 버퍼를 차례로 fd로 열린 파일에 쓴다.
+ * 파일 시스템 락과 inode 계층은 버퍼 개수와 상관없이 페이지마다 한 번만 거친다.
+ * 실제로 쓴 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+	struct iovec *kiov = copy_iovec(iov, iovcnt);
+	struct file *_file = NULL;
+	int byte = -1;
+
+	if (kiov == NULL) {
+		return -1;
+	}
+	if ((_file = get_file_from_fd(fd)) != NULL || fd == STDOUT_FILENO) {
+		byte = write_from_user(_file, kiov, iovcnt, -1);
+	}
+	free(kiov);
+	return byte;
+}
+
+/* pread - fd로 열린 파일의 offset 위치부터 buffer로 size 바이트를 읽는다.
+ * 파일의 현재 위치는 바뀌지 않는다.
+ * 실제로 읽은 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int pread(int fd, void *buffer, unsigned size, off_t offset) {
+	struct iovec iov = { buffer, size };
+	struct file *_file = get_file_from_fd(fd);
+
+	if (_file == NULL || file_is_pipe(_file) || offset < 0 || size > INT_MAX) {
+		return -1;
+	}
+	return read_to_user(_file, &iov, 1, offset);
+}
+
+/* pwrite - buffer의 size 바이트를 fd로 열린 파일의 offset 위치부터 쓴다.
+ * 파일의 현재 위치는 바뀌지 않는다.
+ * 실제로 쓴 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset) {
+	struct iovec iov = { (void *) buffer, size };
+	struct file *_file = get_file_from_fd(fd);
+
+	if (_file == NULL || file_is_pipe(_file) || offset < 0 || size > INT_MAX) {
+		return -1;
+	}
+	return write_from_user(_file, &iov, 1, offset);
+}
+
+/* copy_between - 파일 in의 in_pos부터 size 바이트를 파일 out의 out_pos에 복사한다.
+ * 데이터는 유저 메모리를 거치지 않는다.
+ * 복사한 바이트 수를 반환하며, 같은 파일에서 두 범위가 겹치면 -1을 반환한다.
+ * filesys_lock을 잡은 상태에서 호출해야 한다.
+ */
+static int copy_between(struct file *out, off_t out_pos, struct file *in, off_t in_pos, off_t size) {
+	if (file_get_inode(out) == file_get_inode(in)
+			&& in_pos < out_pos + size && out_pos < in_pos + size) {
+		return -1;
+	}
+	return file_copy_at(out, out_pos, in, in_pos, size);
+}
+
+/* send_to_console - 파일 in의 pos부터 size 바이트를 콘솔에 쓴다.
+ * 커널 페이지 하나를 거쳐 PGSIZE 바이트씩 putbuf()로 출력한다.
+ * 출력한 바이트 수를 반환한다. filesys_lock을 잡은 상태에서 호출해야 한다.
+ */
+static int send_to_console(struct file *in, off_t pos, off_t size) {
+	char *buf = palloc_get_page(0);
+	int byte = 0;
+
+	if (buf == NULL) {
+		return -1;
+	}
+	while (byte < size) {
+		off_t chunk = size - byte < PGSIZE ? size - byte : PGSIZE;
+		chunk = file_read_at(in, buf, chunk, pos + byte);
+		if (chunk == 0) {
+			break;
+		}
+		putbuf(buf, chunk);
+		byte += chunk;
+	}
+	palloc_free_page(buf);
+	return byte;
+}
+
+/* sendfile - in_fd로 열린 파일에서 count 바이트를 out_fd로 열린 파일 또는 콘솔로 보낸다.
+ * offset이 NULL이 아니면 *offset부터 읽고 *offset을 옮기며, in_fd의 위치는 바꾸지 않는다.
+ * NULL이면 in_fd의 현재 위치부터 읽고 그 위치를 옮긴다.
+ * 유저 버퍼 없이 커널 안에서 복사하며, filesys_lock은 한 번만 잡는다.
+ * 보낸 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int sendfile(int out_fd, int in_fd, off_t *offset, unsigned count) {
+	struct file *in = get_file_from_fd(in_fd);
+	struct file *out;
+	off_t pos;
+	int byte;
+
+	if (offset != NULL && !copy_from_user(&pos, offset, sizeof pos)) {
+		exit(-1);
+	}
+	if (in == NULL || file_is_pipe(in) || count > INT_MAX) {
+		return -1;
+	}
+	out = get_file_from_fd(out_fd);
+	if (out == NULL ? out_fd != STDOUT_FILENO : file_is_pipe(out)) {
+		return -1;
+	}
+	if (offset == NULL) {
+		pos = file_tell(in);
+	}
+	if (pos < 0) {
+		return -1;
+	}
+
+	lock_acquire(&filesys_lock);
+	if (out == NULL) {
+		byte = send_to_console(in, pos, count);
+	}
 	else {
-		return _file;
+		off_t out_pos = file_tell(out);
+		byte = copy_between(out, out_pos, in, pos, count);
+		if (byte > 0) {
+			file_seek(out, out_pos + byte);
+		}
+	}
+	lock_release(&filesys_lock);
+
+	if (byte > 0) {
+		pos += byte;
+		if (offset == NULL) {
+			file_seek(in, pos);
+		}
+		else if (!copy_to_user(offset, &pos, sizeof pos)) {
+			exit(-1);
+		}
+	}
+	return byte;
+}
+
+/* copy_file_range - in_fd로 열린 파일에서 length 바이트를 out_fd로 열린 파일에 복사한다.
+ * in_offset(out_offset)이 NULL이 아니면 그 위치부터 읽고(쓰고) 그 값을 옮기며,
+ * 파일의 위치는 바꾸지 않는다. NULL이면 파일의 현재 위치를 쓰고 옮긴다.
+ * 복사한 바이트 수를 반환하며, 실패하면 -1을 반환한다.
+ */
+int copy_file_range(int in_fd, off_t *in_offset, int out_fd, off_t *out_offset, unsigned length) {
+	struct file *in = get_file_from_fd(in_fd);
+	struct file *out = get_file_from_fd(out_fd);
+	off_t in_pos, out_pos;
+	int byte;
+
+	if (in_offset != NULL && !copy_from_user(&in_pos, in_offset, sizeof in_pos)) {
+		exit(-1);
+	}
+	if (out_offset != NULL && !copy_from_user(&out_pos, out_offset, sizeof out_pos)) {
+		exit(-1);
+	}
+	if (in == NULL || out == NULL || file_is_pipe(in) || file_is_pipe(out) || length > INT_MAX) {
+		return -1;
+	}
+	if (in_offset == NULL) {
+		in_pos = file_tell(in);
+	}
+	if (out_offset == NULL) {
+		out_pos = file_tell(out);
+	}
+	if (in_pos < 0 || out_pos < 0) {
+		return -1;
+	}
+
+	lock_acquire(&filesys_lock);
+	byte = copy_between(out, out_pos, in, in_pos, length);
+	lock_release(&filesys_lock);
+
+	if (byte > 0) {
+		in_pos += byte;
+		out_pos += byte;
+		if (in_offset == NULL) {
+			file_seek(in, in_pos);
+		}
+		else if (!copy_to_user(in_offset, &in_pos, sizeof in_pos)) {
+			exit(-1);
+		}
+		if (out_offset == NULL) {
+			file_seek(out, out_pos);
+		}
+		else if (!copy_to_user(out_offset, &out_pos, sizeof out_pos)) {
+			exit(-1);
+		}
+	}
+	return byte;
+}
+
+/* io_setup - 페이지 정렬된 쓰기 가능한 익명 메모리 페이지 ring을 현재 프로세스의 I/O 링으로 등록한다.
+ * 공유 메모리나 파일 매핑은 링이 쓰는 동안 해제될 수 있으므로 쓸 수 없다.
+ * 이후 io_enter()로 링에 넣은 작업을 커널 워커 스레드들이 처리한다.
+ * 성공하면 0, 이미 링이 있거나 ring이 알맞지 않으면 -1을 반환한다.
+ */
+int io_setup(struct io_ring *ring) {
+	return io_ring_setup(ring);
+}
+
+/* io_enter - 제출 큐에서 최대 to_submit개 작업을 꺼내 워커에게 넘긴 뒤,
+ * 완료 큐에 min_complete개 이상이 쌓이거나 진행 중인 작업이 없어질 때까지 기다린다.
+ * 한 번의 시스템 콜로 여러 작업을 제출하고 완료를 거둘 수 있다.
+ * 꺼낸 작업 수를 반환하며, 링이 없으면 -1을 반환한다.
+ */
+int io_enter(unsigned to_submit, unsigned min_complete) {
+	return io_ring_enter(to_submit, min_complete);
+}
+
+/* disk_stats - chan_no 채널의 dev_no 디스크의 통계를 stats에 복사한다.
+ * 그런 디스크가 없으면 false를 반환한다.
+ */
+bool disk_stats(int chan_no, int dev_no, struct disk_stats *stats) {
+	struct disk_stats kstats;
+	struct disk *d;
+
+	if (chan_no < 0 || (dev_no != 0 && dev_no != 1)) {
+		return false;
+	}
+	d = disk_get(chan_no, dev_no);
+	if (d == NULL) {
+		return false;
+	}
+	disk_get_stats(d, &kstats);
+	if (!copy_to_user(stats, &kstats, sizeof kstats)) {
+		exit(-1);
 	}
+	return true;
+}
+
+/* dup2 - newfd가 oldfd와 같은 열린 파일을 가리키게 한다.
+ * newfd에 열려 있던 파일은 먼저 닫는다. 두 fd는 파일 위치를 공유하며,
+ * 파일은 마지막 fd가 닫힐 때 닫힌다. fd 0과 1에도 파일을 놓을 수 있다.
+ * newfd를 반환하며, oldfd가 열려 있지 않거나 newfd가 잘못되었으면 -1을 반환한다.
+ */
+int dup2(int oldfd, int newfd) {
+	struct file *_file = get_file_from_fd(oldfd);
+
+	if (_file == NULL || newfd < 0) {
+		return -1;
+	}
+	if (oldfd == newfd) {
+		return newfd;
+	}
+	close(newfd);
+	if (!fd_table_install(&thread_current()->fdt, newfd, file_dup(_file))) {
+		file_close(_file);
+		return -1;
+	}
+	return newfd;
+}
+
+/* pipe - 파이프를 만들어 읽는 쪽 fd를 fds[0]에, 쓰는 쪽 fd를 fds[1]에 넣는다.
+ * 쓴 데이터는 한 페이지 크기의 링 버퍼를 거쳐 읽는 쪽으로 전달된다.
+ * 성공하면 0, fd나 메모리가 부족하면 -1을 반환한다. fds에 쓸 수 없으면 프로세스를 종료한다.
+ */
+int pipe(int fds[2]) {
+	struct file *read_end, *write_end;
+	int kfds[2];
+
+	if (!file_open_pipe(&read_end, &write_end)) {
+		return -1;
+	}
+	kfds[0] = add_file_to_fdt(read_end);
+	kfds[1] = kfds[0] < 0 ? -1 : add_file_to_fdt(write_end);
+	if (kfds[1] < 0) {
+		if (kfds[0] >= 0) {
+			fd_table_remove(&thread_current()->fdt, kfds[0]);
+		}
+		file_close(read_end);
+		file_close(write_end);
+		return -1;
+	}
+	if (!copy_to_user(fds, kfds, sizeof kfds)) {
+		exit(-1);
+	}
+	return 0;
+}
+
+/* futex - addr의 futex에 대해 op를 수행한다.
+ * FUTEX_WAIT: *addr이 val이면 깨어날 때까지 잠들고 0을, 아니면 바로 -1을 반환한다.
+ * FUTEX_WAKE: addr에서 잠든 프로세스를 최대 val개 깨우고 깨운 수를 반환한다.
+ * FUTEX_REQUEUE: 최대 val개를 깨우고 나머지는 addr2에서 잠들게 옮긴 뒤 깨운 수를 반환한다.
+ * futex는 프레임과 그 안의 오프셋으로 구별하므로, 같은 공유 메모리를 매핑한 프로세스끼리 쓸 수 있다.
+ * addr이 정렬되지 않았거나 읽을 수 없거나 op가 잘못되었으면 -1을 반환한다.
+ */
+int futex(int *addr, int op, int val, int *addr2) {
+	switch (op) {
+	case FUTEX_WAIT:
+		return futex_wait(addr, val);
+	case FUTEX_WAKE:
+		return futex_wake(addr, val);
+	case FUTEX_REQUEUE:
+		return futex_requeue(addr, val, addr2);
+	default:
+		return -1;
+	}
+}
+
+/* tty_mode - 콘솔 입력 모드를 TTY_* 플래그의 조합인 mode로 바꾸고 이전 모드를 반환한다.
+ * TTY_RAW이면 한 줄씩이 아니라 들어오는 대로 읽고,
+ * TTY_NONBLOCK이면 읽을 것이 없을 때 기다리지 않고 0을 반환한다.
+ */
+int tty_mode(int mode) {
+	return input_set_mode(mode);
+}
+
+/* tty_poll - read(0)이 기다리지 않고 돌아올 수 있으면 입력 버퍼에 있는 바이트 수를,
+ * 기다려야 하면 0을 반환한다.
+ */
+int tty_poll(void) {
+	return input_pending();
+}
+
+/* poll_fd - fd에 지금 일어나 있는 POLL* 이벤트를 반환한다.
+ * e가 NULL이 아니면 먼저 e를 통해 w를 fd의 poll 큐에 올려, 이벤트가 바뀔 수 있을 때 깨어나게 한다.
+ * 파일이 없는 fd 0은 콘솔 입력, fd 1은 콘솔 출력이고 그 밖에 열려 있지 않은 fd는 POLLNVAL이다.
+ */
+static int poll_fd(int fd, struct poll_entry *e, struct poll_waiter *w) {
+	struct file *_file = get_file_from_fd(fd);
+
+	if (_file != NULL) {
+		return file_poll(_file, e, w);
+	}
+	if (fd == STDIN_FILENO) {
+		return input_poll(e, w);
+	}
+	if (fd == STDOUT_FILENO) {
+		return POLLOUT;
+	}
+	return POLLNVAL;
+}
+
+/* poll - fds의 nfds개 fd 중 하나라도 events에 적힌 이벤트가 일어날 때까지 기다린다.
+ * 각 revents에 일어난 이벤트를 적고, revents가 0이 아닌 fd의 수를 반환한다.
+ * POLLERR, POLLHUP, POLLNVAL은 events에 없어도 알려 주며, fd가 음수인 항목은 건너뛴다.
+ * timeout은 타이머 틱 단위로, 그동안 아무 일도 없으면 0을 반환한다.
+ * timeout이 0이면 기다리지 않고, 음수이면 무한히 기다린다.
+ *
+ * 처음 살펴볼 때 각 fd의 poll 큐(파이프, 콘솔 입력)에 한 번만 올라가고 잠들며,
+ * 깨어나면 모든 fd를 다시 살펴본다. 큐에 올라간 뒤에 살펴보므로 그 사이의 깨움은 잃어버리지 않는다.
+ * nfds가 잘못되었거나 메모리가 부족하면 -1을 반환한다.
+ */
+int poll(struct pollfd *fds, int nfds, int timeout) {
+	struct pollfd *kfds;
+	struct poll_entry *entries;
+	struct poll_waiter w;
+	int64_t deadline = timeout < 0 ? -1 : timer_ticks() + timeout;
+	bool first = true;
+	int ready, i;
+
+	if (nfds < 0 || nfds > FD_MAX) {
+		return -1;
+	}
+	kfds = malloc(nfds * sizeof *kfds);
+	entries = calloc(nfds, sizeof *entries);
+	if (nfds > 0 && (kfds == NULL || entries == NULL)) {
+		free(kfds);
+		free(entries);
+		return -1;
+	}
+	if (!copy_from_user(kfds, fds, nfds * sizeof *kfds)) {
+		free(kfds);
+		free(entries);
+		exit(-1);
+	}
+
+	poll_waiter_init(&w);
+	for (;;) {
+		ready = 0;
+		for (i = 0; i < nfds; i++) {
+			kfds[i].revents = 0;
+			if (kfds[i].fd < 0) {
+				continue;
+			}
+			kfds[i].revents = poll_fd(kfds[i].fd, first ? &entries[i] : NULL, &w)
+							  & (kfds[i].events | POLLERR | POLLHUP | POLLNVAL);
+			if (kfds[i].revents != 0) {
+				ready++;
+			}
+		}
+		if (ready > 0 || timeout == 0 || !poll_waiter_sleep(&w, deadline)) {
+			break;
+		}
+		first = false;
+	}
+
+	for (i = 0; i < nfds; i++) {
+		poll_queue_remove(&entries[i]);
+	}
+	free(entries);
+	if (!copy_to_user(fds, kfds, nfds * sizeof *kfds)) {
+		free(kfds);
+		exit(-1);
+	}
+	free(kfds);
+	return ready;
+}
+
+/* add_file_to_fdt - file을 fdt에 추가하고 fd를 반환한다.
+ * 비어 있는 가장 작은 fd를 쓰며, fdt가 가득 차면 -1을 반환한다.
+ */
+int add_file_to_fdt(struct file *file) {
+	return fd_table_add(&thread_current()->fdt, file);
+}
+
+/* get_file_from_fd - fd에 해당하는 file을 반환한다.
+ * fd가 콘솔이거나 열려 있지 않은 경우 NULL을 반환한다.
+ */
+struct file *get_file_from_fd(int fd) {
+	return fd_table_get(&thread_current()->fdt, fd);
 }
\ No newline at end of file
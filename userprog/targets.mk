@@ -2,5 +2,12 @@ userprog_SRC  = userprog/process.c	# Process loading.
 userprog_SRC += userprog/exception.c	# User exception handler.
 userprog_SRC += userprog/syscall-entry.S # System call entry.
 userprog_SRC += userprog/syscall.c	# System call handler.
+userprog_SRC += userprog/exec-cache.c	# Executable layout cache.
+userprog_SRC += userprog/fdtable.c	# File descriptor tables.
+userprog_SRC += userprog/io-ring.c	# Asynchronous I/O rings.
+userprog_SRC += userprog/futex.c	# Futex wait queues.
+userprog_SRC += userprog/vdata.c	# Kernel data pages for processes.
+userprog_SRC += userprog/uaccess.c	# Access to user memory.
+userprog_SRC += userprog/copy-user.S	# User copies and their fixups.
 userprog_SRC += userprog/gdt.c		# GDT initialization.
 userprog_SRC += userprog/tss.c		# TSS management.
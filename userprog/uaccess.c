@@ -0,0 +1,106 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Copying to and from user memory.
+
+   These functions take user addresses straight from system call
+   arguments.  They check that the range lies below KERN_BASE and
+   then let the CPU do the rest: an access to a page the process
+   does not have faults, and if the fault cannot be resolved by
+   bringing the page in, for instance because it is a write to a
+   read-only page, page_fault() sends the copy to its fixup in
+   userprog/copy-user.S, which returns an error.  Valid buffers thus
+   cost little beyond the copy itself, however many pages they span.
+
+   The kernel runs with CR0.WP clear, so its writes to pages that
+   are present but mapped read-only do not fault at all.
+   copy_to_user() therefore looks up the page table entries of its
+   destination first and refuses any such page. */
+
+/* An entry in the fixup table of userprog/copy-user.S. */
+struct fixup {
+	uintptr_t insn;                     /* Instruction that may fault. */
+	uintptr_t fixup;                    /* Where to resume if it does. */
+};
+
+extern const struct fixup uaccess_fixups[], uaccess_fixups_end[];
+
+size_t copy_user (void *dst, const void *src, size_t size);
+long strncpy_user (char *dst, const char *src, size_t size);
+
+/* Returns true if the SIZE bytes at UADDR lie in user space. */
+static inline bool
+user_range (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+
+	return start + size >= start && start + size <= KERN_BASE;
+}
+
+/* Returns true if none of the SIZE bytes at user address UADDR lie
+   in a page that the running process has present but read-only. */
+static bool
+no_read_only_pages (const void *uaddr, size_t size) {
+	uint64_t *pml4 = thread_current ()->pml4;
+	uintptr_t va = (uintptr_t) pg_round_down (uaddr);
+	uintptr_t end = (uintptr_t) uaddr + size;
+
+	for (; va < end; va += PGSIZE) {
+		uint64_t *pte = pml4e_walk (pml4, va, 0);
+
+		if (pte != NULL && (*pte & PTE_P) && !is_writable (pte))
+			return false;
+	}
+	return true;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+ * Returns false if any of them is not readable by the process. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	return user_range (usrc, size) && copy_user (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+ * Returns false if any of them is not writable by the process. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	return user_range (udst, size) && no_read_only_pages (udst, size)
+		&& copy_user (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into DST,
+ * which holds SIZE bytes.  Returns the string's length, SIZE if it
+ * does not fit in DST with its null terminator, or -1 if it is not
+ * readable by the process. */
+long
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	size_t limit = size;
+	long len;
+
+	if (!is_user_vaddr (usrc))
+		return -1;
+	if (!user_range (usrc, limit))
+		limit = KERN_BASE - (uintptr_t) usrc;
+	len = strncpy_user (dst, usrc, limit);
+	if (len >= 0 && (size_t) len == limit && limit < size)
+		return -1;
+	return len;
+}
+
+/* If F is a fault in one of the instructions of userprog/copy-user.S
+ * that access user memory, makes F resume at its fixup and returns
+ * true. */
+bool
+uaccess_fixup (struct intr_frame *f) {
+	const struct fixup *e;
+
+	for (e = uaccess_fixups; e < uaccess_fixups_end; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			return true;
+		}
+	return false;
+}
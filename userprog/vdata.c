@@ -0,0 +1,129 @@
+#include "userprog/vdata.h"
+#include <debug.h>
+#include <vdata.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Kernel data pages mapped into every process.
+
+   Each process has two pages mapped read-only at VDATA_ADDR: the
+   system data page, which all processes share, and then a page of
+   its own.  The timer interrupt brings both up to date on every
+   tick, so that a process reads the time, the load average and the
+   CPU time it has used without a system call.  With the time stamp
+   counter at the last tick and the counter's rate, it can also tell
+   the time between ticks.
+
+   The timer interrupt is the only writer.  It bumps a page's
+   sequence number before and after changing the page, so a reader
+   that sees the same even number on both sides of its reads knows
+   that they are consistent.  Pintos runs on one CPU, so keeping the
+   compiler from reordering the accesses is enough.
+
+   The pages are never paged out, so they are not in the
+   supplemental page table: they are mapped when a process is loaded
+   or forked and unmapped before its page table is destroyed, which
+   would otherwise free them.  Since the supplemental page table
+   does not know them, mmap() refuses them explicitly. */
+
+#if VDATA_ADDR <= USER_STACK
+#error The kernel data pages must lie above the user stack.
+#endif
+
+static struct vdata *vdata;             /* The system data page. */
+
+/* Sets up the system data page. */
+void
+vdata_init (void) {
+	vdata = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+	vdata->timer_freq = TIMER_FREQ;
+}
+
+/* Brings the data pages up to date for timer tick TICKS, which
+   found the running thread in user mode if USER.  Called by the
+   timer interrupt handler. */
+void
+vdata_tick (int64_t ticks, bool user) {
+	struct vdata_proc *proc = thread_current ()->vdata;
+
+	ASSERT (intr_context ());
+
+	vdata->seq++;
+	barrier ();
+	vdata->ticks = ticks;
+	vdata->tick_tsc = rdtsc ();
+	vdata->tsc_per_tick = timer_tsc_per_tick ();
+	vdata->load_avg = thread_get_load_avg ();
+	barrier ();
+	vdata->seq++;
+
+	if (proc != NULL) {
+		proc->seq++;
+		barrier ();
+		if (user)
+			proc->user_ticks++;
+		else
+			proc->kernel_ticks++;
+		barrier ();
+		proc->seq++;
+	}
+}
+
+/* Maps the data pages into the running process, first allocating
+   the process's own page if it has none yet.  A process keeps its
+   page, and so its counts, across exec().  Returns false if memory
+   runs out. */
+bool
+vdata_map (void) {
+	struct thread *t = thread_current ();
+
+	if (t->vdata == NULL) {
+		t->vdata = palloc_get_page (PAL_ZERO);
+		if (t->vdata == NULL)
+			return false;
+	}
+	return pml4_set_page (t->pml4, (void *) VDATA_ADDR, vdata, false)
+		&& pml4_set_page (t->pml4, (void *) VDATA_PROC_ADDR, t->vdata, false);
+}
+
+/* Unmaps the data pages from the running process's page table, if
+   it has one, so that destroying the table leaves them alone. */
+void
+vdata_unmap (void) {
+	struct thread *t = thread_current ();
+
+	if (t->pml4 != NULL) {
+		pml4_clear_page (t->pml4, (void *) VDATA_ADDR);
+		pml4_clear_page (t->pml4, (void *) VDATA_PROC_ADDR);
+	}
+}
+
+/* Frees the running process's own data page.  Interrupts are
+   turned off while it is taken away, since the timer interrupt
+   writes to it. */
+void
+vdata_exit (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	struct vdata_proc *proc = t->vdata;
+
+	t->vdata = NULL;
+	intr_set_level (old_level);
+	palloc_free_page (proc);
+}
+
+/* Returns true if any of the SIZE bytes at user address UADDR lie
+   in the data pages. */
+bool
+vdata_overlaps (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+
+	return size > 0 && start < VDATA_PROC_ADDR + PGSIZE
+		&& start + size > VDATA_ADDR;
+}
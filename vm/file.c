@@ -113,6 +113,10 @@ void do_munmap(void *addr) {
 	if (page == NULL) {
 		return;
 	}
+	if (page_get_type(page) == VM_SHM) {
+		shm_detach(addr);
+		return;
+	}
 	struct file_info *_aux = (struct file_info *)page->uninit.aux;
 		
 	int page_size = file_length(_aux->file);
@@ -0,0 +1,265 @@
+/* shm.c: Anonymous memory shared between processes.
+
+   A segment is a run of zeroed pages that any number of processes
+   map.  Each page of a segment has one frame, allocated the first
+   time any process touches the page, and every process that maps
+   the page maps that same frame.  Segments have names, so that
+   processes that are not related can find them, and a process that
+   forks hands its mappings to the child, which then shares them
+   rather than getting a copy.
+
+   A segment counts the pages that map it across all address spaces.
+   When the last one goes, its frames are freed and its name is
+   forgotten.  The frames never belong to any file, so nothing is
+   ever written back. */
+
+#include "vm/shm.h"
+#include <list.h>
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+struct shm_segment {
+	struct list_elem elem;      /* Element in SEGMENTS. */
+	char name[SHM_NAME_MAX + 1];
+	int id;                     /* Identifies the segment to shm_attach(). */
+	int refs;                   /* Pages mapping the segment. */
+	size_t page_cnt;            /* Pages in the segment. */
+	struct frame frames[];      /* One per page; KVA null until used.
+	                               PAGE stays null: the frame belongs
+	                               to the segment, not to any one
+	                               process's page. */
+};
+
+static bool shm_swap_in (struct page *page, void *kva);
+static bool shm_swap_out (struct page *page);
+static void shm_destroy (struct page *page);
+
+static const struct page_operations shm_ops = {
+	.swap_in = shm_swap_in,
+	.swap_out = shm_swap_out,
+	.destroy = shm_destroy,
+	.type = VM_SHM,
+};
+
+static struct list segments;    /* All segments. */
+static struct lock shm_lock;    /* Protects SEGMENTS and their contents. */
+static int next_id;             /* Id for the next new segment. */
+
+/* Initializes the shared memory segments. */
+void
+vm_shm_init (void) {
+	list_init (&segments);
+	lock_init (&shm_lock);
+	next_id = 1;
+}
+
+/* Returns the segment with NAME, if NAME is not null, or with ID
+   otherwise, or a null pointer if there is none.  Must be called
+   with SHM_LOCK held. */
+static struct shm_segment *
+find_segment (const char *name, int id) {
+	struct list_elem *e;
+
+	for (e = list_begin (&segments); e != list_end (&segments);
+			e = list_next (e)) {
+		struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+		if (name != NULL ? !strcmp (seg->name, name) : seg->id == id)
+			return seg;
+	}
+	return NULL;
+}
+
+/* Returns the id of the segment named NAME, creating it with SIZE
+   bytes if there is none yet.  Returns -1 if NAME is empty or too
+   long, if the segment exists but is smaller than SIZE, if SIZE is
+   not from 1 to SHM_SIZE_MAX for a new segment, or if memory runs
+   out.  Once a segment has been mapped, it lasts until the last
+   mapping of it goes away. */
+int
+shm_get (const char *name, size_t size) {
+	struct shm_segment *seg;
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	int id = -1;
+
+	if (name[0] == '\0' || strlen (name) > SHM_NAME_MAX)
+		return -1;
+
+	lock_acquire (&shm_lock);
+	seg = find_segment (name, 0);
+	if (seg != NULL) {
+		if (page_cnt <= seg->page_cnt)
+			id = seg->id;
+	} else if (size > 0 && size <= SHM_SIZE_MAX) {
+		seg = calloc (1, sizeof *seg + page_cnt * sizeof *seg->frames);
+		if (seg != NULL) {
+			strlcpy (seg->name, name, sizeof seg->name);
+			seg->id = id = next_id++;
+			seg->page_cnt = page_cnt;
+			list_push_back (&segments, &seg->elem);
+		}
+	}
+	lock_release (&shm_lock);
+	return id;
+}
+
+/* Drops one reference to SEG, freeing it and its frames when it was
+   the last.  Must be called with SHM_LOCK held. */
+static void
+put_segment (struct shm_segment *seg) {
+	size_t i;
+
+	ASSERT (seg->refs > 0);
+	if (--seg->refs > 0)
+		return;
+	list_remove (&seg->elem);
+	for (i = 0; i < seg->page_cnt; i++)
+		if (seg->frames[i].kva != NULL)
+			palloc_free_page (seg->frames[i].kva);
+	free (seg);
+}
+
+/* Adds a page of SEG at VA, page IDX of the segment, to the current
+   process.  Must be called with SHM_LOCK held. */
+static bool
+add_page (struct shm_segment *seg, size_t idx, void *va, bool writable) {
+	struct page *page = malloc (sizeof *page);
+
+	if (page == NULL)
+		return false;
+	*page = (struct page) {
+		.operations = &shm_ops,
+		.va = va,
+		.frame = NULL,
+		.writable = writable,
+		.shm = (struct shm_page) { .seg = seg, .idx = idx },
+	};
+	if (!spt_insert_page (&thread_current ()->spt, page)) {
+		free (page);
+		return false;
+	}
+	seg->refs++;
+	return true;
+}
+
+/* Maps all of segment ID into the current process at ADDR, which
+   must be page-aligned, writable if WRITABLE.  The pages are mapped
+   when first touched.  Returns false if there is no such segment,
+   or if any of its pages would overlap memory already in use or
+   lie outside user memory. */
+bool
+shm_attach (int id, void *addr, bool writable) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct shm_segment *seg;
+	size_t i;
+	bool ok = false;
+
+	if (addr == NULL || pg_ofs (addr) != 0)
+		return false;
+
+	lock_acquire (&shm_lock);
+	seg = find_segment (NULL, id);
+	if (seg == NULL
+			|| (uint64_t) addr + seg->page_cnt * PGSIZE > USER_STACK
+			|| (uint64_t) addr + seg->page_cnt * PGSIZE < (uint64_t) addr)
+		goto done;
+	for (i = 0; i < seg->page_cnt; i++)
+		if (spt_find_page (spt, addr + i * PGSIZE) != NULL)
+			goto done;
+	for (i = 0; i < seg->page_cnt; i++)
+		if (!add_page (seg, i, addr + i * PGSIZE, writable)) {
+			/* Take back the pages added so far. */
+			while (i-- > 0) {
+				struct page *page = spt_find_page (spt, addr + i * PGSIZE);
+				hash_delete (&spt->pages, &page->h_elem);
+				put_segment (seg);
+				free (page);
+			}
+			goto done;
+		}
+	ok = true;
+
+done:
+	lock_release (&shm_lock);
+	return ok;
+}
+
+/* Unmaps the shared memory mapping that starts at ADDR in the
+   current process: the run of pages from ADDR that belong to the
+   same segment as the page there. */
+void
+shm_detach (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct page *page = spt_find_page (spt, addr);
+	struct shm_segment *seg;
+	size_t idx;
+
+	if (page == NULL || page_get_type (page) != VM_SHM)
+		return;
+	seg = page->shm.seg;
+	idx = page->shm.idx;
+	do {
+		spt_remove_page (spt, page);
+		addr += PGSIZE;
+		page = spt_find_page (spt, addr);
+	} while (page != NULL && page_get_type (page) == VM_SHM
+			&& page->shm.seg == seg && page->shm.idx == ++idx);
+}
+
+/* Adds to the current process a page that shares SRC, a shared
+   memory page of the process it is forked from. */
+bool
+shm_copy_page (struct page *src) {
+	bool ok;
+
+	lock_acquire (&shm_lock);
+	ok = add_page (src->shm.seg, src->shm.idx, src->va, src->writable);
+	lock_release (&shm_lock);
+	return ok;
+}
+
+/* Returns the frame that holds PAGE, a shared memory page, getting
+   a zeroed one if no process has touched the page yet.  Returns a
+   null pointer if memory runs out. */
+struct frame *
+shm_get_frame (struct page *page) {
+	struct frame *frame;
+
+	lock_acquire (&shm_lock);
+	frame = &page->shm.seg->frames[page->shm.idx];
+	if (frame->kva == NULL)
+		frame->kva = palloc_get_page (PAL_USER | PAL_ZERO);
+	lock_release (&shm_lock);
+	return frame->kva != NULL ? frame : NULL;
+}
+
+/* The frame already holds the page's contents. */
+static bool
+shm_swap_in (struct page *page UNUSED, void *kva UNUSED) {
+	return true;
+}
+
+/* Other processes may be using the frame, so it stays put. */
+static bool
+shm_swap_out (struct page *page UNUSED) {
+	return false;
+}
+
+/* Unmaps PAGE from the current process and drops its reference to
+   the segment.  The frame is freed with the segment, not here, so
+   the page table entry must go before the page table is destroyed
+   with the frames it maps. */
+static void
+shm_destroy (struct page *page) {
+	struct thread *t = thread_current ();
+
+	if (t->pml4 != NULL)
+		pml4_clear_page (t->pml4, page->va);
+	lock_acquire (&shm_lock);
+	put_segment (page->shm.seg);
+	lock_release (&shm_lock);
+}
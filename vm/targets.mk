@@ -2,4 +2,5 @@ vm_SRC = vm/vm.c          # Main api proxy
 vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
+vm_SRC += vm/shm.c        # Shared anonymous page
 vm_SRC += vm/inspect.c    # Testing utility
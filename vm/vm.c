@@ -19,7 +19,7 @@ void vm_init (void) {
 #endif
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
-	/* TODO: Your code goes here. */
+	vm_shm_init ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -225,11 +225,23 @@ bool vm_claim_page(void *va) {
  * 성공 여부를 반환한다.
  */
 static bool vm_do_claim_page(struct page *page) {
-	struct frame *frame = vm_get_frame();
+	struct frame *frame;
 	struct thread *t = thread_current();
 
+	/* 공유 메모리 페이지는 모든 프로세스가 세그먼트의 같은 프레임을 매핑한다.
+	 * 그 프레임은 세그먼트의 것이므로 frame->page를 어느 한 페이지로 잇지 않는다. */
+	if (VM_TYPE(page->operations->type) == VM_SHM) {
+		frame = shm_get_frame(page);
+		if (frame == NULL) {
+			return false;
+		}
+	}
+	else {
+		frame = vm_get_frame();
+		frame->page = page;
+	}
+
 	/* Set links */
-	frame->page = page;
 	page->frame = frame;
 
 	if (!pml4_set_page(t->pml4, page->va, frame->kva, page->writable)) {
@@ -268,7 +280,7 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
 					return false;
 				}
 				dst_page = spt_find_page(dst, src_page->va);
-				memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+				copy_page(dst_page->frame->kva, src_page->frame->kva);
 				break;
 			case VM_FILE:
 				if (!vm_alloc_page(src_type, src_page->va, src_page->writable)) {
@@ -278,7 +290,13 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
 					return false;
 				}
 				dst_page = spt_find_page(dst, src_page->va);
-				memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+				copy_page(dst_page->frame->kva, src_page->frame->kva);
+				break;
+			case VM_SHM:
+				/* 복사하지 않고 부모와 같은 세그먼트를 공유한다. */
+				if (!shm_copy_page(src_page)) {
+					return false;
+				}
 				break;
 			default:
 				break;